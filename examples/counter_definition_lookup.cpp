@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <perfcpp/counter_definition.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Allocator counting the allocated bytes, used to measure the memory of the node-based baseline map.
+ */
+template<typename T>
+class CountingAllocator
+{
+public:
+  using value_type = T;
+
+  explicit CountingAllocator(std::size_t& allocated_bytes) noexcept
+    : _allocated_bytes(allocated_bytes)
+  {
+  }
+  template<typename U>
+  CountingAllocator(const CountingAllocator<U>& other) noexcept
+    : _allocated_bytes(other.allocated_bytes())
+  {
+  }
+
+  T* allocate(const std::size_t count)
+  {
+    _allocated_bytes += count * sizeof(T);
+    return std::allocator<T>{}.allocate(count);
+  }
+
+  void deallocate(T* pointer, const std::size_t count) noexcept
+  {
+    _allocated_bytes -= count * sizeof(T);
+    std::allocator<T>{}.deallocate(pointer, count);
+  }
+
+  [[nodiscard]] std::size_t& allocated_bytes() const noexcept { return _allocated_bytes; }
+
+  template<typename U>
+  bool operator==(const CountingAllocator<U>& other) const noexcept
+  {
+    return &_allocated_bytes == &other.allocated_bytes();
+  }
+  template<typename U>
+  bool operator!=(const CountingAllocator<U>& other) const noexcept
+  {
+    return !(*this == other);
+  }
+
+private:
+  std::size_t& _allocated_bytes;
+};
+
+/**
+ * Measures the average time per lookup of the given names.
+ *
+ * @param names Names to look up.
+ * @param count_rounds Number of rounds over all names.
+ * @param lookup Callable looking up a name, returning true if the name was found.
+ * @return Average time per lookup in nanoseconds.
+ */
+template<typename F>
+double
+measure(const std::vector<std::string_view>& names, const std::size_t count_rounds, F&& lookup)
+{
+  auto count_found = std::uint64_t{ 0U };
+
+  const auto start = std::chrono::steady_clock::now();
+  for (auto round = std::size_t{ 0U }; round < count_rounds; ++round) {
+    for (const auto name : names) {
+      count_found += static_cast<std::uint64_t>(lookup(name));
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  asm volatile(""
+               : "+r,m"(count_found)
+               :
+               : "memory"); /// We do not want the compiler to optimize away this unused value.
+
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+         double(count_rounds * names.size());
+}
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Measure the cost of looking up counters by name in a counter definition "
+               "of 5,000 events."
+            << std::endl;
+
+  constexpr auto count_events = std::size_t{ 5000U };
+  constexpr auto count_rounds = std::size_t{ 200U };
+
+  /// Create names similar to the events of a pmu-events catalog (e.g., "mem_load_retired.l3_miss_42").
+  auto names = std::vector<std::string>{};
+  names.reserve(count_events);
+  for (auto event_id = std::size_t{ 0U }; event_id < count_events; ++event_id) {
+    names.emplace_back(std::string{ "mem_load_retired.l3_miss_" }.append(std::to_string(event_id)));
+  }
+
+  /// Counter definition holding the events (besides the generalized events and metrics).
+  auto counter_definitions = perf::CounterDefinition{};
+  for (auto event_id = std::size_t{ 0U }; event_id < count_events; ++event_id) {
+    counter_definitions.add(std::string{ names[event_id] }, std::uint64_t(event_id));
+  }
+
+  /// Baseline: Node-based map, looked up by constructing a std::string per lookup.
+  auto baseline_bytes = std::size_t{ 0U };
+  auto baseline = std::unordered_map<std::string,
+                                     perf::CounterConfig,
+                                     std::hash<std::string>,
+                                     std::equal_to<>,
+                                     CountingAllocator<std::pair<const std::string, perf::CounterConfig>>>{
+    0U,
+    std::hash<std::string>{},
+    std::equal_to<>{},
+    CountingAllocator<std::pair<const std::string, perf::CounterConfig>>{ baseline_bytes }
+  };
+  for (auto event_id = std::size_t{ 0U }; event_id < count_events; ++event_id) {
+    baseline.insert(std::make_pair(names[event_id], perf::CounterConfig{ PERF_TYPE_RAW, std::uint64_t(event_id) }));
+  }
+
+  /// Look up the names in random order (views on the names, like the user-provided names of EventCounter::add()).
+  auto lookup_names = std::vector<std::string_view>{ names.begin(), names.end() };
+  std::shuffle(lookup_names.begin(), lookup_names.end(), std::mt19937{ std::random_device{}() });
+
+  const auto counter_definition_time = measure(lookup_names, count_rounds, [&counter_definitions](const auto name) {
+    return counter_definitions.counter(name).has_value();
+  });
+  const auto baseline_time = measure(lookup_names, count_rounds, [&baseline](const auto name) {
+    return baseline.find(std::string{ name }) != baseline.end();
+  });
+
+  /// Names longer than the small string buffer are allocated separately (not seen by the allocator of the map).
+  for (const auto& [name, _] : baseline) {
+    if (name.capacity() > std::string{}.capacity()) {
+      baseline_bytes += name.capacity() + 1U;
+    }
+  }
+
+  std::cout << "\nResults for " << counter_definitions.names().size() << " counters:\n"
+            << "  perf::CounterDefinition:                  " << counter_definition_time << " ns/lookup, "
+            << counter_definitions.memory_usage() / 1024U << " kB\n"
+            << "  std::unordered_map (std::string lookup):  " << baseline_time << " ns/lookup, "
+            << baseline_bytes / 1024U << " kB (without metrics)" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "access_benchmark.h"
+#include "perfcpp/event_counter.h"
+#include "perfcpp/interval_reader.h"
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record performance counter in intervals of 50ms for "
+               "random access to an in-memory array on all CPU cores."
+            << std::endl;
+  std::cout << "A background thread will read the counters periodically without stopping them." << std::endl;
+
+  /// Create a list of cpus to record performance counters on (all available, in this example).
+  auto cpus_to_watch = std::vector<std::uint16_t>(std::thread::hardware_concurrency());
+  std::iota(cpus_to_watch.begin(), cpus_to_watch.end(), 0U);
+
+  /// Initialize performance counters.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+  auto multi_cpu_event_counter = perf::MultiCoreEventCounter{ counter_definitions, std::move(cpus_to_watch) };
+
+  /// Add all the performance counters we want to record.
+  try {
+    multi_cpu_event_counter.add({ "instructions", "cycles", "cache-misses", "cycles-per-instruction" });
+  } catch (std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  /// Create the interval reader that reads the counters every 50ms and stores up to 1024 intervals.
+  /// The memory for all intervals is allocated upfront.
+  auto interval_reader = perf::IntervalReader{ multi_cpu_event_counter, std::chrono::milliseconds{ 50U }, 1024U };
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Start recording performance counter and the interval reader.
+  try {
+    multi_cpu_event_counter.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+  interval_reader.start();
+
+  /// Execute the benchmark multiple times.
+  auto value = 0ULL;
+  for (auto iteration = 0U; iteration < 5U; ++iteration) {
+    for (auto index = 0U; index < benchmark.size(); ++index) {
+      value += benchmark[index].value;
+    }
+  }
+
+  /// Stop the interval reader and the performance counter recording.
+  interval_reader.stop();
+  multi_cpu_event_counter.stop();
+
+  /// Add up the results so that the compiler does not get the idea of
+  /// optimizing away the accesses.
+  asm volatile("" : "+r,m"(value) : : "memory");
+
+  /// Print the performance counters per interval.
+  std::cout << "\nResults:\n";
+  for (const auto& interval : interval_reader.result()) {
+    std::cout << "[" << std::chrono::duration_cast<std::chrono::milliseconds>(interval.time()).count() << "ms]";
+    for (const auto& [counter_name, counter_value] : interval.result()) {
+      std::cout << " " << counter_value << " " << counter_name;
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
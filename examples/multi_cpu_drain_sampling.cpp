@@ -0,0 +1,127 @@
+#include "access_benchmark.h"
+#include <atomic>
+#include <iostream>
+#include <numeric>
+#include <perfcpp/sample_drainer.h>
+#include <perfcpp/sampler.h>
+#include <thread>
+#include <unordered_map>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record perf samples on multiple CPU cores into small buffers, "
+               "consumed by a background thread while sampling."
+            << std::endl;
+
+  constexpr auto count_threads = 4U;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Initialize sampler.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(500000U); /// Record every 500,000th event.
+
+  /// Use small buffers (64 kB per CPU core instead of 32 MB), since they are drained while sampling.
+  perf_config.buffer_pages(1U + 16U);
+
+  /// Wake up the background thread whenever 16 kB of samples are written into a buffer.
+  perf_config.wakeup_watermark(16U * 1024U);
+
+  /// Create a list of cpus to sample (all available, in this example).
+  auto cpus_to_watch = std::vector<std::uint16_t>(std::min(4U, std::thread::hardware_concurrency()));
+  std::iota(cpus_to_watch.begin(), cpus_to_watch.end(), 0U);
+
+  auto sampler = perf::MultiCoreSampler{ counter_definitions, std::move(cpus_to_watch), perf_config };
+
+  /// Setup event that triggers writing samples.
+  sampler.trigger("cycles");
+
+  /// Setup what data the samples should include (timestamp, instruction pointer, CPU id).
+  sampler.values().time(true).instruction_pointer(true).cpu_id(true);
+
+  /// Aggregate the samples per CPU core while recording (only accessed by the background thread and after stopping).
+  auto samples_per_cpu = std::unordered_map<std::uint32_t, std::uint64_t>{};
+  auto count_lost_samples = std::uint64_t{ 0U };
+  auto drainer = perf::SampleDrainer{ sampler, [&samples_per_cpu, &count_lost_samples](auto&& samples) {
+                                       for (const auto& sample : samples) {
+                                         if (sample.count_loss().has_value()) {
+                                           count_lost_samples += sample.count_loss().value();
+                                         } else if (sample.cpu_id().has_value()) {
+                                           ++samples_per_cpu[sample.cpu_id().value()];
+                                         }
+                                       }
+                                     } };
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 1024U };
+
+  /// Allocate space for threads and their results.
+  const auto items_per_thread = benchmark.size() / count_threads;
+  auto threads = std::vector<std::thread>{};
+  auto thread_local_results =
+    std::vector<std::uint64_t>(count_threads, 0U); /// Array to store the thread-local results.
+
+  /// Barrier for the threads to wait in order to start them all at the same time.
+  auto thread_barrier = std::atomic<bool>{ false };
+
+  for (auto thread_index = 0U; thread_index < count_threads; ++thread_index) {
+    threads.emplace_back([thread_index, items_per_thread, &thread_local_results, &benchmark, &thread_barrier]() {
+      auto local_value = 0ULL;
+
+      /// Wait for the barrier to become "true", i.e., all threads are spawned.
+      while (!thread_barrier)
+        ;
+
+      /// Process the data.
+      for (auto index = 0U; index < items_per_thread; ++index) {
+        local_value += benchmark[(thread_index * items_per_thread) + index].value;
+      }
+
+      thread_local_results[thread_index] = local_value;
+    });
+  }
+
+  /// Start sampling for all specified CPUs at once, and the drainer afterward (the samplers need to be opened).
+  try {
+    sampler.start();
+    drainer.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Let threads start.
+  thread_barrier = true;
+
+  /// Wait for all threads to finish.
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  /// Stop sampling on all CPUs and drain the remaining samples.
+  sampler.stop();
+  drainer.stop();
+
+  /// Add up the results so that the compiler does not get the idea of
+  /// optimizing away the accesses.
+  auto value = std::accumulate(thread_local_results.begin(), thread_local_results.end(), 0UL);
+  asm volatile("" : "+r,m"(value) : : "memory");
+
+  std::cout << "\nDrained " << drainer.count_samples() << " samples in " << drainer.count_batches()
+            << " batches (lost " << count_lost_samples << " samples)." << std::endl;
+  for (const auto& [cpu_id, count_samples] : samples_per_cpu) {
+    std::cout << "CPU ID = " << cpu_id << " | Samples = " << count_samples << "\n";
+  }
+  std::cout << std::flush;
+
+  /// Close the sampler.
+  /// Note that the sampler can only be closed after stopping the drainer.
+  sampler.close();
+
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <perfcpp/benchmark.h>
+#include <perfcpp/event_counter.h>
+
+#include "access_benchmark.h"
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record performance counter for "
+               "single-threaded random access to an in-memory array over multiple runs."
+            << std::endl;
+
+  /// Initialize performance counters.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+  auto event_counter = perf::EventCounter{ counter_definitions };
+
+  /// Add all the performance counters we want to record.
+  try {
+    event_counter.add({ "instructions", "cycles", "cache-misses", "cycles-per-instruction" });
+  } catch (std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 64 MB */ 64U };
+
+  /// Run the benchmark 20 times after 2 warm-up runs.
+  auto repeated_benchmark = perf::Benchmark{ event_counter, 20U, 2U };
+  auto result = perf::BenchmarkResult{ {}, perf::Statistics{}, 0U };
+  try {
+    result = repeated_benchmark.run([&benchmark]() {
+      auto value = 0ULL;
+      for (auto index = 0U; index < benchmark.size(); ++index) {
+        value += benchmark[index].value;
+      }
+      asm volatile(""
+                   : "+r,m"(value)
+                   :
+                   : "memory"); /// We do not want the compiler to optimize away
+                                /// this unused value.
+    });
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Access the statistics of specific counters.
+  const auto cycles = result.get("cycles");
+  if (cycles.has_value()) {
+    const auto [lower, upper] = cycles->confidence_interval(.95);
+    std::cout << "\nMedian cycles: " << cycles->median() << " (95% confidence interval: " << lower << " - " << upper
+              << ")" << std::endl;
+  }
+
+  /// Print the statistics of all counters as table.
+  std::cout << "\nResults as table:\n" << result.to_string() << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "counter.h"
+#include "event_counter.h"
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Robust statistics over the values of a counter, metric, or the wall time recorded in multiple runs.
+ */
+class Statistics
+{
+public:
+  Statistics() = default;
+  explicit Statistics(std::vector<double>&& values);
+  ~Statistics() = default;
+
+  /**
+   * @return Number of values (runs) the statistics are based on.
+   */
+  [[nodiscard]] std::size_t count() const noexcept { return _values.size(); }
+
+  /**
+   * @return Sorted values the statistics are based on.
+   */
+  [[nodiscard]] const std::vector<double>& values() const noexcept { return _values; }
+
+  [[nodiscard]] double min() const noexcept { return _min; }
+  [[nodiscard]] double max() const noexcept { return _max; }
+  [[nodiscard]] double mean() const noexcept { return _mean; }
+
+  /**
+   * @return Sample standard deviation.
+   */
+  [[nodiscard]] double standard_deviation() const noexcept { return _standard_deviation; }
+
+  [[nodiscard]] double median() const noexcept { return _median; }
+
+  /**
+   * @return Median absolute deviation (not scaled to the standard deviation of a normal distribution).
+   */
+  [[nodiscard]] double mad() const noexcept { return _mad; }
+
+  /**
+   * Calculates the percentile by linear interpolation between the closest ranks.
+   *
+   * @param percent Percentile to calculate (between 0 and 100).
+   * @return The percentile (NaN if there are no values).
+   */
+  [[nodiscard]] double percentile(double percent) const noexcept;
+
+  /**
+   * Calculates a distribution-free confidence interval of the median, based on order statistics.
+   *
+   * @param confidence Confidence level (e.g., 0.95).
+   * @return Lower and upper bound of the interval (NaN if there are no values).
+   */
+  [[nodiscard]] std::pair<double, double> confidence_interval(double confidence = .95) const noexcept;
+
+private:
+  std::vector<double> _values;
+  double _min{ std::numeric_limits<double>::quiet_NaN() };
+  double _max{ std::numeric_limits<double>::quiet_NaN() };
+  double _mean{ std::numeric_limits<double>::quiet_NaN() };
+  double _standard_deviation{ std::numeric_limits<double>::quiet_NaN() };
+  double _median{ std::numeric_limits<double>::quiet_NaN() };
+  double _mad{ std::numeric_limits<double>::quiet_NaN() };
+};
+
+/**
+ * Statistics of all counters and metrics and the wall time, recorded over multiple runs by the Benchmark.
+ */
+class BenchmarkResult
+{
+public:
+  using const_iterator = std::vector<std::pair<std::string_view, Statistics>>::const_iterator;
+
+  BenchmarkResult(std::vector<std::pair<std::string_view, Statistics>>&& statistics,
+                  Statistics&& time,
+                  const std::size_t count_runs) noexcept
+    : _statistics(std::move(statistics))
+    , _time(std::move(time))
+    , _count_runs(count_runs)
+  {
+  }
+  ~BenchmarkResult() = default;
+
+  /**
+   * Access the statistics of the counter or metric with the given name.
+   *
+   * @param name Name of the counter or metric.
+   * @return The statistics, or std::nullopt if the result has no counter or metric with the requested name.
+   */
+  [[nodiscard]] std::optional<Statistics> get(std::string_view name) const;
+
+  /**
+   * @return Statistics of the wall time (in nanoseconds) per run.
+   */
+  [[nodiscard]] const Statistics& time() const noexcept { return _time; }
+
+  /**
+   * @return Number of recorded runs (without warm-up runs), including outliers.
+   */
+  [[nodiscard]] std::size_t count_runs() const noexcept { return _count_runs; }
+
+  /**
+   * @return Number of runs rejected as outliers.
+   */
+  [[nodiscard]] std::size_t count_outliers() const noexcept { return _count_runs - _time.count(); }
+
+  [[nodiscard]] const_iterator begin() const { return _statistics.begin(); }
+  [[nodiscard]] const_iterator end() const { return _statistics.end(); }
+
+  /**
+   * Converts the result to a table-formatted string with median, MAD, 5th and 95th percentile, and the
+   * 95% confidence interval of the median per counter and metric.
+   *
+   * @return Result as a table-formatted string.
+   */
+  [[nodiscard]] std::string to_string() const;
+
+private:
+  std::vector<std::pair<std::string_view, Statistics>> _statistics;
+  Statistics _time;
+  std::size_t _count_runs;
+};
+
+/**
+ * Runs a callable multiple times (after warm-up runs) and records the counters, metrics, and wall time of every
+ * run. Runs whose wall time deviates too much from the median are rejected as outliers (modified z-score, see
+ * Iglewicz and Hoaglin).
+ * The counters are kept open and all per-run storage is allocated upfront, such that the harness neither
+ * opens counters nor allocates memory between the runs.
+ */
+class Benchmark
+{
+public:
+  /**
+   * @param event_counter Event counter with the counters and metrics to record (not started).
+   * @param count_runs Number of recorded runs.
+   * @param count_warm_up_runs Number of runs before recording.
+   */
+  Benchmark(EventCounter& event_counter, std::size_t count_runs, std::size_t count_warm_up_runs = 1U);
+  ~Benchmark() = default;
+
+  /**
+   * Sets the threshold of the modified z-score (based on the wall time) to reject a run as outlier.
+   *
+   * @param threshold Threshold, default = 3.5; 0 disables the rejection.
+   */
+  void outlier_threshold(const double threshold) noexcept { _outlier_threshold = threshold; }
+
+  /**
+   * @return Threshold of the modified z-score to reject a run as outlier.
+   */
+  [[nodiscard]] double outlier_threshold() const noexcept { return _outlier_threshold; }
+
+  /**
+   * Runs the callable count_warm_up_runs + count_runs times and records all runs after the warm-up.
+   *
+   * @param callable Code to benchmark.
+   * @return Statistics of all counters, metrics, and the wall time.
+   */
+  template<typename F>
+  BenchmarkResult run(F&& callable)
+  {
+    const auto is_opened = this->prepare();
+
+    for (auto run_id = std::size_t{ 0U }; run_id < this->_count_warm_up_runs; ++run_id) {
+      this->_event_counter.start();
+      callable();
+      this->_event_counter.stop();
+    }
+
+    for (auto run_id = std::size_t{ 0U }; run_id < this->_count_runs; ++run_id) {
+      this->_event_counter.reset();
+      this->_event_counter.start();
+      const auto start = std::chrono::steady_clock::now();
+      callable();
+      const auto end = std::chrono::steady_clock::now();
+      this->_event_counter.stop();
+
+      this->record(run_id, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start));
+    }
+
+    if (is_opened) {
+      this->_event_counter.close();
+    }
+
+    return this->evaluate();
+  }
+
+  /**
+   * Value of a counter or metric in a recorded run of the last call to run().
+   *
+   * @param run_id Id of the run.
+   * @param handle Handle of the counter or metric (see EventCounter::handle()).
+   * @return The value (NaN if the value is not available).
+   */
+  [[nodiscard]] double value(const std::size_t run_id, const CounterHandle handle) const noexcept
+  {
+    return _values[run_id * _result.size() + handle.index()];
+  }
+
+  /**
+   * @param run_id Id of the run.
+   * @return Wall time of a recorded run of the last call to run().
+   */
+  [[nodiscard]] std::chrono::nanoseconds time(const std::size_t run_id) const noexcept { return _times[run_id]; }
+
+private:
+  EventCounter& _event_counter;
+  std::size_t _count_runs;
+  std::size_t _count_warm_up_runs;
+  double _outlier_threshold{ 3.5 };
+
+  /// Reusable view to read the results of a run.
+  CounterResultView _result;
+
+  /// Values of all counters and metrics per run (runs x counters and metrics).
+  std::vector<double> _values;
+
+  /// Wall time per run.
+  std::vector<std::chrono::nanoseconds> _times;
+
+  /**
+   * Opens the counters (if not opened) and allocates the storage for all runs.
+   *
+   * @return True, if the counters were opened by the benchmark and should be closed afterward.
+   */
+  [[nodiscard]] bool prepare();
+
+  /**
+   * Stores the counter values and the wall time of a run.
+   *
+   * @param run_id Id of the run.
+   * @param time Wall time of the run.
+   */
+  void record(std::size_t run_id, std::chrono::nanoseconds time);
+
+  /**
+   * Rejects outliers and calculates the statistics over all recorded runs.
+   *
+   * @return Statistics of all counters, metrics, and the wall time.
+   */
+  [[nodiscard]] BenchmarkResult evaluate() const;
+};
+}
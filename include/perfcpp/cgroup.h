@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace perf {
+/**
+ * Open handle to a cgroup (the directory of the cgroup in the cgroup file system) to record counters and samples
+ * of all processes within the cgroup (e.g., a container) instead of individual processes.
+ * The cgroup has to be alive as long as counters or samplers are opened for it.
+ */
+class CgroupHandle
+{
+public:
+  /**
+   * Opens the cgroup. Throws an exception if the cgroup cannot be opened.
+   *
+   * @param path Path of the cgroup, either absolute or relative to the cgroup mount (i.e., "/sys/fs/cgroup").
+   */
+  explicit CgroupHandle(std::string_view path);
+
+  CgroupHandle(CgroupHandle&& other) noexcept;
+  CgroupHandle& operator=(CgroupHandle&& other) noexcept;
+  CgroupHandle(const CgroupHandle&) = delete;
+  CgroupHandle& operator=(const CgroupHandle&) = delete;
+
+  ~CgroupHandle();
+
+  /**
+   * @return Path of the cgroup.
+   */
+  [[nodiscard]] const std::string& path() const noexcept { return _path; }
+
+  /**
+   * @return File descriptor of the cgroup directory (passed to perf_event_open instead of a process id).
+   */
+  [[nodiscard]] std::int32_t file_descriptor() const noexcept { return _file_descriptor; }
+
+private:
+  /// Mount point of the cgroup file system, used for relative paths.
+  constexpr static inline auto MOUNT_PATH = std::string_view{ "/sys/fs/cgroup/" };
+
+  std::string _path;
+  std::int32_t _file_descriptor{ -1 };
+};
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "branch.h"
+#include "hardware_info.h"
+#include "multiplexing.h"
 #include "period.h"
 #include "precision.h"
 #include "registers.h"
@@ -17,7 +19,18 @@ public:
   Config& operator=(const Config&) noexcept = default;
 
   [[nodiscard]] std::uint8_t max_groups() const noexcept { return _max_groups; }
-  [[nodiscard]] std::uint8_t max_counters_per_group() const noexcept { return _max_counters_per_group; }
+
+  /// Maximal number of counters per group: the configured value or, if not set, the number of hardware counters
+  /// detected on the PMU (general purpose and fixed counters).
+  [[nodiscard]] std::uint8_t max_counters_per_group() const
+  {
+    return _max_counters_per_group.value_or(std::uint8_t(HardwareInfo::count_general_purpose_counters().value_or(4U) +
+                                                         HardwareInfo::count_fixed_counters()));
+  }
+
+  /// Flag if the maximal number of counters per group was configured (otherwise, groups are packed by the detected
+  /// capacity of the PMU).
+  [[nodiscard]] bool is_max_counters_per_group_set() const noexcept { return _max_counters_per_group.has_value(); }
 
   [[deprecated("Will be replaced by Sampler::values() interface from v.0.9.0.")]] [[nodiscard]] std::uint16_t
   max_stack() const noexcept
@@ -32,10 +45,23 @@ public:
   [[nodiscard]] bool is_include_idle() const noexcept { return _is_include_idle; }
   [[nodiscard]] bool is_include_guest() const noexcept { return _is_include_guest; }
 
+  [[nodiscard]] bool is_read_with_rdpmc() const noexcept { return _is_read_with_rdpmc; }
+
+  [[nodiscard]] bool is_pinned() const noexcept { return _is_pinned; }
+  [[nodiscard]] bool is_exclusive() const noexcept { return _is_exclusive; }
+
+  [[nodiscard]] double min_running_ratio() const noexcept { return _min_running_ratio; }
+  [[nodiscard]] MultiplexingPolicy multiplexing_policy() const noexcept { return _multiplexing_policy; }
+
+  [[nodiscard]] bool is_subtract_overhead() const noexcept { return _is_subtract_overhead; }
+
+  [[nodiscard]] std::uint16_t max_open_threads() const noexcept { return _max_open_threads; }
+
   [[nodiscard]] bool is_debug() const noexcept { return _is_debug; }
 
   [[nodiscard]] std::optional<std::uint16_t> cpu_id() const noexcept { return _cpu_id; }
   [[nodiscard]] pid_t process_id() const noexcept { return _process_id; }
+  [[nodiscard]] std::optional<std::int32_t> cgroup_file_descriptor() const noexcept { return _cgroup_file_descriptor; }
 
   void max_groups(const std::uint8_t max_groups) noexcept { _max_groups = max_groups; }
   void max_counters_per_group(const std::uint8_t max_counters_per_group) noexcept
@@ -59,14 +85,35 @@ public:
   void include_idle(const bool is_include_idle) noexcept { _is_include_idle = is_include_idle; }
   void include_guest(const bool is_include_guest) noexcept { _is_include_guest = is_include_guest; }
 
+  void read_with_rdpmc(const bool is_read_with_rdpmc) noexcept { _is_read_with_rdpmc = is_read_with_rdpmc; }
+
+  void pinned(const bool is_pinned) noexcept { _is_pinned = is_pinned; }
+  void exclusive(const bool is_exclusive) noexcept { _is_exclusive = is_exclusive; }
+
+  void min_running_ratio(const double min_running_ratio) noexcept { _min_running_ratio = min_running_ratio; }
+  void multiplexing_policy(const MultiplexingPolicy multiplexing_policy) noexcept
+  {
+    _multiplexing_policy = multiplexing_policy;
+  }
+
+  void subtract_overhead(const bool is_subtract_overhead) noexcept { _is_subtract_overhead = is_subtract_overhead; }
+
+  void max_open_threads(const std::uint16_t max_open_threads) noexcept { _max_open_threads = max_open_threads; }
+
   void is_debug(const bool is_debug) noexcept { _is_debug = is_debug; }
 
   void cpu_id(const std::uint16_t cpu_id) noexcept { _cpu_id = cpu_id; }
   void process_id(const pid_t process_id) noexcept { _process_id = process_id; }
+  void cgroup_file_descriptor(const std::int32_t cgroup_file_descriptor) noexcept
+  {
+    _cgroup_file_descriptor = cgroup_file_descriptor;
+  }
 
 private:
   std::uint8_t _max_groups{ 5U };
-  std::uint8_t _max_counters_per_group{ 4U };
+
+  /// Maximal number of counters per group; if not set, the groups are packed by the capacity of the PMU.
+  std::optional<std::uint8_t> _max_counters_per_group{ std::nullopt };
 
   std::uint16_t _max_stack{ 16U };
 
@@ -77,10 +124,33 @@ private:
   bool _is_include_idle{ true };
   bool _is_include_guest{ true };
 
+  /// Read counter values from user-space (via rdpmc) instead of read() syscalls, if supported by the hardware.
+  bool _is_read_with_rdpmc{ true };
+
+  /// Pin all groups to the PMU (never multiplexed, error state if they cannot be scheduled).
+  bool _is_pinned{ false };
+
+  /// Schedule all groups exclusively on the PMU.
+  bool _is_exclusive{ false };
+
+  /// Minimal fraction of the enabled time a counter has to run on the PMU; lower ratios are flagged or refused.
+  double _min_running_ratio{ .0 };
+  MultiplexingPolicy _multiplexing_policy{ MultiplexingPolicy::Flag };
+
+  /// Subtract the calibrated overhead of starting and stopping the counters from the results (see
+  /// EventCounter::calibrate()); has no effect unless the counters are calibrated.
+  bool _is_subtract_overhead{ true };
+
+  /// Maximal number of threads that open counters and samplers of multiple CPU cores in parallel.
+  std::uint16_t _max_open_threads{ 8U };
+
   bool _is_debug{ false };
 
   std::optional<std::uint16_t> _cpu_id{ std::nullopt };
   pid_t _process_id{ 0 };
+
+  /// File descriptor of a cgroup (see perf::CgroupHandle) to record instead of the process; requires a CPU core.
+  std::optional<std::int32_t> _cgroup_file_descriptor{ std::nullopt };
 };
 
 class SampleConfig final : public Config
@@ -92,6 +162,8 @@ public:
   [[nodiscard]] Precision precise_ip() const noexcept { return _precise_ip; }
   [[nodiscard]] std::uint64_t buffer_pages() const noexcept { return _buffer_pages; }
   [[nodiscard]] PeriodOrFrequency period_for_frequency() const noexcept { return _period_or_frequency; }
+  [[nodiscard]] std::uint32_t wakeup_events() const noexcept { return _wakeup_events; }
+  [[nodiscard]] std::uint32_t wakeup_watermark() const noexcept { return _wakeup_watermark; }
 
   [[deprecated("User Registers will be set through the Sampler::values() interface.")]] [[nodiscard]] Registers
   user_registers() const noexcept
@@ -135,6 +207,30 @@ public:
     }
   }
   void buffer_pages(const std::uint64_t buffer_pages) noexcept { _buffer_pages = buffer_pages; }
+
+  /**
+   * Wakes up consumers waiting for the buffer (e.g., the SampleDrainer) every given number of samples.
+   * Replaces the wakeup watermark, since both share a field of the perf event attribute.
+   *
+   * @param wakeup_events Number of samples.
+   */
+  void wakeup_events(const std::uint32_t wakeup_events) noexcept
+  {
+    _wakeup_events = wakeup_events;
+    _wakeup_watermark = 0U;
+  }
+
+  /**
+   * Wakes up consumers waiting for the buffer (e.g., the SampleDrainer) once the given number of bytes is written.
+   * Replaces the wakeup events, since both share a field of the perf event attribute.
+   *
+   * @param wakeup_watermark Number of bytes.
+   */
+  void wakeup_watermark(const std::uint32_t wakeup_watermark) noexcept
+  {
+    _wakeup_watermark = wakeup_watermark;
+    _wakeup_events = 0U;
+  }
   [[deprecated("User Registers will be set through the Sampler::values() interface from v.0.9.0.")]] void
   user_registers(const Registers registers) noexcept
   {
@@ -161,6 +257,11 @@ public:
 private:
   std::uint64_t _buffer_pages{ 8192U + 1U };
 
+  /// Number of samples or bytes after which consumers waiting for the buffer are woken up; if none is set, the perf
+  /// subsystem wakes up consumers when half of the buffer is filled.
+  std::uint32_t _wakeup_events{ 0U };
+  std::uint32_t _wakeup_watermark{ 0U };
+
   PeriodOrFrequency _period_or_frequency{ Period{ 4000U } };
 
   Precision _precise_ip{ Precision::MustHaveConstantSkid /* Enable PEBS by default */ };
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "multiplexing.h"
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <linux/perf_event.h>
 #include <optional>
@@ -27,6 +29,8 @@ public:
   void precise_ip(const std::uint8_t precise_ip) noexcept { _precise_ip = precise_ip; }
   void period(const std::uint64_t period) noexcept { _is_frequency = false; _period_or_frequency = period; }
   void frequency(const std::uint64_t frequency) noexcept { _is_frequency = true; _period_or_frequency = frequency; }
+  void pinned(const bool is_pinned) noexcept { _is_pinned = is_pinned; }
+  void exclusive(const bool is_exclusive) noexcept { _is_exclusive = is_exclusive; }
 
   [[nodiscard]] std::uint32_t type() const noexcept { return _type; }
   [[nodiscard]] std::uint64_t event_id() const noexcept { return _event_id; }
@@ -34,6 +38,8 @@ public:
   [[nodiscard]] std::uint8_t precise_ip() const noexcept { return _precise_ip; }
   [[nodiscard]] bool is_frequency() const noexcept { return _is_frequency; }
   [[nodiscard]] std::uint64_t period_or_frequency() const noexcept { return _period_or_frequency; }
+  [[nodiscard]] bool is_pinned() const noexcept { return _is_pinned; }
+  [[nodiscard]] bool is_exclusive() const noexcept { return _is_exclusive; }
 
   [[nodiscard]] bool is_auxiliary() const noexcept { return _event_id == 0x8203; }
 
@@ -44,6 +50,12 @@ private:
   std::uint8_t _precise_ip{ 0U };
   bool _is_frequency;
   std::uint64_t _period_or_frequency;
+
+  /// Pinned counters (and their groups) are always on the PMU or go into error state; they are never multiplexed.
+  bool _is_pinned{ false };
+
+  /// Exclusive counters (and their groups) are the only groups on the PMU while they are scheduled.
+  bool _is_exclusive{ false };
 };
 
 class CounterResult
@@ -59,6 +71,12 @@ public:
     : _results(std::move(results))
   {
   }
+  CounterResult(std::vector<std::pair<std::string_view, double>>&& results,
+                std::vector<std::pair<std::string_view, Multiplexing>>&& multiplexing) noexcept
+    : _results(std::move(results))
+    , _multiplexing(std::move(multiplexing))
+  {
+  }
 
   ~CounterResult() = default;
 
@@ -73,6 +91,20 @@ public:
    */
   [[nodiscard]] std::optional<double> get(std::string_view name) const noexcept;
 
+  /**
+   * Access the multiplexing details (raw and scaled value, running ratio, and error estimate) of the counter
+   * with the given name. Counters refused due to a low running ratio have multiplexing details but no value.
+   *
+   * @param name Name of the counter.
+   * @return The multiplexing details, or std::nullopt if the result has no counter with the requested name.
+   */
+  [[nodiscard]] std::optional<Multiplexing> multiplexing(std::string_view name) const noexcept;
+
+  /**
+   * @return True, if the running ratio of any counter is below the configured threshold.
+   */
+  [[nodiscard]] bool is_below_threshold() const noexcept;
+
   [[nodiscard]] iterator begin() { return _results.begin(); }
   [[nodiscard]] iterator end() { return _results.end(); }
   [[nodiscard]] const_iterator begin() const { return _results.begin(); }
@@ -101,6 +133,86 @@ public:
 
 private:
   std::vector<std::pair<std::string_view, double>> _results;
+
+  /// Multiplexing details of the (not hidden) counters.
+  std::vector<std::pair<std::string_view, Multiplexing>> _multiplexing;
+};
+
+/**
+ * Handle of a counter or metric added to an EventCounter (see EventCounter::handle()).
+ * The handle is the index of the counter or metric and resolves the name once, such that results can be
+ * accessed by an array lookup instead of comparing names.
+ */
+class CounterHandle
+{
+public:
+  explicit constexpr CounterHandle(const std::uint16_t index) noexcept
+    : _index(index)
+  {
+  }
+  ~CounterHandle() noexcept = default;
+
+  [[nodiscard]] constexpr std::uint16_t index() const noexcept { return _index; }
+
+  [[nodiscard]] constexpr bool operator==(const CounterHandle other) const noexcept { return _index == other._index; }
+  [[nodiscard]] constexpr bool operator!=(const CounterHandle other) const noexcept { return _index != other._index; }
+
+private:
+  std::uint16_t _index;
+};
+
+/**
+ * Result of all counters and metrics (including hidden counters), indexed by CounterHandles.
+ * The view can be reused for multiple results; the memory is only allocated when filling it the first time.
+ * Values that are not available (e.g., refused due to multiplexing or metrics that could not be calculated)
+ * are stored as NaN.
+ */
+class CounterResultView
+{
+  friend class EventCounter;
+
+public:
+  CounterResultView() = default;
+  ~CounterResultView() = default;
+
+  /**
+   * Access the value of the counter or metric with the given handle.
+   *
+   * @param handle Handle of the counter or metric.
+   * @return The value, or std::nullopt if the value is not available.
+   */
+  [[nodiscard]] std::optional<double> get(const CounterHandle handle) const noexcept
+  {
+    if (handle.index() < _values.size() && !std::isnan(_values[handle.index()])) {
+      return _values[handle.index()];
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * Access the value of the counter or metric with the given handle without checks.
+   *
+   * @param handle Handle of the counter or metric.
+   * @return The value (NaN if the value is not available).
+   */
+  [[nodiscard]] double operator[](const CounterHandle handle) const noexcept { return _values[handle.index()]; }
+
+  /**
+   * @return Number of counters and metrics in the view.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _values.size(); }
+
+private:
+  /// Values of all counters and metrics, in the order they were added to the EventCounter.
+  std::vector<double> _values;
+
+  /// Time enabled and running per counter, used to apply the multiplexing policy.
+  std::vector<std::uint64_t> _time_enabled;
+  std::vector<std::uint64_t> _time_running;
+
+  /// Buffer for the values of counters required by a metric.
+  std::vector<double> _metric_arguments;
 };
 
 class Counter
@@ -133,6 +245,13 @@ public:
   [[nodiscard]] std::int64_t file_descriptor() const noexcept { return _file_descriptor; }
   [[nodiscard]] bool is_open() const noexcept { return _file_descriptor > -1; }
 
+  void user_page(perf_event_mmap_page* user_page) noexcept { _user_page = user_page; }
+  [[nodiscard]] perf_event_mmap_page* user_page() const noexcept { return _user_page; }
+
+  [[nodiscard]] const CounterConfig& config() const noexcept { return _config; }
+  [[nodiscard]] bool is_pinned() const noexcept { return _config.is_pinned(); }
+  [[nodiscard]] bool is_exclusive() const noexcept { return _config.is_exclusive(); }
+
   [[nodiscard]] bool is_auxiliary() const noexcept { return _config.is_auxiliary(); }
 
   [[nodiscard]] std::string to_string() const;
@@ -143,6 +262,9 @@ private:
   std::uint64_t _id{ 0U };
   std::int64_t _file_descriptor{ -1 };
 
+  /// Mapped first page of the counter (perf_event_mmap_page), used to read the counter from user-space via rdpmc.
+  perf_event_mmap_page* _user_page{ nullptr };
+
   /**
    * Prints a name of a type (e.g., sample, branch, ...) to the stream if the type is set in the mask.
    *
@@ -2,12 +2,17 @@
 
 #include "counter.h"
 #include "metric.h"
+#include "metric_expression.h"
+#include "name_table.h"
+#include "pmu_event_index.h"
+#include "pmu_event_parser.h"
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace perf {
 class CounterDefinition
@@ -37,37 +42,67 @@ public:
 
   void add(std::string&& name, CounterConfig config)
   {
-    _counter_configs.insert(std::make_pair(std::move(name), config));
+    _counter_configs.insert(name, std::move(config));
   }
 
-  void add(std::string&& name, std::unique_ptr<Metric>&& metric)
+  void add(std::string&& name, std::unique_ptr<Metric>&& metric) { _metrics.insert(name, std::move(metric)); }
+
+  void add(std::unique_ptr<Metric>&& metric)
   {
-    _metrics.insert(std::make_pair(std::move(name), std::move(metric)));
+    const auto name = metric->name();
+    _metrics.insert(name, std::move(metric));
   }
 
-  void add(std::unique_ptr<Metric>&& metric) { _metrics.insert(std::make_pair(metric->name(), std::move(metric))); }
+  /**
+   * Adds a metric defined by an expression over counters, e.g., add("cycles-per-instruction", "cycles / instructions").
+   * Throws an exception if the expression is malformed (see MetricExpression for the syntax).
+   *
+   * @param name Name of the metric.
+   * @param expression Expression to calculate the metric.
+   */
+  void add(std::string&& name, const std::string_view expression)
+  {
+    auto metric = std::make_unique<MetricExpression>(std::string{ name }, expression);
+    _metrics.insert(name, std::move(metric));
+  }
 
+  /**
+   * Looks up a counter by name (without allocating, unless the counter is resolved via the sysfs or a pmu-events
+   * catalog for the first time).
+   *
+   * @param name Name of the counter.
+   * @return Name (valid as long as the definition) and configuration of the counter, or std::nullopt if the counter
+   * is not defined.
+   */
+  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(
+    std::string_view name) const noexcept;
   [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(std::string&& name) const noexcept
   {
-    return counter(name);
+    return counter(std::string_view{ name });
   }
   [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(
-    const std::string& name) const noexcept;
-  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(
-    const std::string_view name) const noexcept
+    const std::string& name) const noexcept
   {
-    return counter(std::string{ name });
+    return counter(std::string_view{ name });
   }
-  [[nodiscard]] bool is_metric(const std::string& name) const noexcept { return _metrics.find(name) != _metrics.end(); }
-  [[nodiscard]] bool is_metric(std::string_view name) const noexcept { return is_metric(std::string{ name }); }
-  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const std::string& name) const noexcept;
+
+  [[nodiscard]] bool is_metric(const std::string_view name) const noexcept { return _metrics.contains(name); }
+  [[nodiscard]] bool is_metric(const std::string& name) const noexcept { return is_metric(std::string_view{ name }); }
+
+  /**
+   * Looks up a metric by name (without allocating).
+   *
+   * @param name Name of the metric.
+   * @return Name (valid as long as the definition) and the metric, or std::nullopt if the metric is not defined.
+   */
+  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(std::string_view name) const noexcept;
   [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(std::string&& name) const noexcept
   {
-    return metric(name);
+    return metric(std::string_view{ name });
   }
-  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const std::string_view name) const noexcept
+  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const std::string& name) const noexcept
   {
-    return metric(std::string{ name.data(), name.size() });
+    return metric(std::string_view{ name });
   }
 
   /**
@@ -76,12 +111,50 @@ public:
   [[nodiscard]] std::vector<std::string> names() const
   {
     auto names = std::vector<std::string>{};
+    names.reserve(_counter_configs.size());
     std::transform(_counter_configs.begin(), _counter_configs.end(), std::back_inserter(names), [](const auto& config) {
-      return config.first;
+      return std::string{ config.first };
     });
     return names;
   }
 
+  /**
+   * Sets the directory of the PMUs in the sysfs, used to resolve event strings like "cpu/event=0x3c,umask=0x1/"
+   * that are not defined explicitly (see PmuEventParser).
+   *
+   * @param sysfs_root Directory containing one sub-directory per PMU, default = "/sys/bus/event_source/devices".
+   */
+  void sysfs_root(std::string sysfs_root) { _pmu_event_parser = PmuEventParser{ std::move(sysfs_root) }; }
+
+  /**
+   * @return Parser for event strings based on the PMUs in the sysfs.
+   */
+  [[nodiscard]] const PmuEventParser& pmu_event_parser() const noexcept { return _pmu_event_parser; }
+
+  /**
+   * Makes the core events of a pmu-events catalog (the JSON format of the Linux kernel) available by name.
+   * The catalog is compiled into a binary index file once (and again when the JSON files change); later calls only
+   * map the index, and events are materialized when they are looked up for the first time.
+   * Throws an exception if the catalog cannot be read or the index cannot be written.
+   *
+   * @param json_path A pmu-events JSON file or a directory containing JSON files (e.g., of one microarchitecture).
+   * @param index_file Path of the index file (e.g., in a cache directory).
+   */
+  void read_pmu_events(const std::string& json_path, const std::string& index_file)
+  {
+    _pmu_event_indices.emplace_back(PmuEventIndex::open_or_compile(json_path, index_file));
+  }
+
+  /**
+   * @return Number of bytes allocated to look up counters and metrics by name (not including the metrics
+   * themselves and the mapped pmu-events indices).
+   */
+  [[nodiscard]] std::size_t memory_usage() const
+  {
+    const auto lock = std::lock_guard{ *_pmu_counter_configs_mutex };
+    return _counter_configs.memory_usage() + _metrics.memory_usage() + _pmu_counter_configs.memory_usage();
+  }
+
   /**
    * Reads and adds counters from the provided CSV file with counter configurations.
    * @param csv_filename CSV file with counter configurations.
@@ -90,10 +163,31 @@ public:
 
 private:
   /// List of added counter configurations.
-  std::unordered_map<std::string, CounterConfig> _counter_configs;
+  NameTable<CounterConfig> _counter_configs;
 
   /// List of added metrics.
-  std::unordered_map<std::string, std::unique_ptr<Metric>> _metrics;
+  NameTable<std::unique_ptr<Metric>> _metrics;
+
+  /// Parser for event strings that are not defined explicitly (e.g., "cpu/event=0x3c,umask=0x1/").
+  PmuEventParser _pmu_event_parser;
+
+  /// Indices of pmu-events catalogs (see read_pmu_events()).
+  std::vector<PmuEventIndex> _pmu_event_indices;
+
+  /// Counter configurations resolved from event strings or pmu-events catalogs, cached on first access (lookups may
+  /// come from multiple threads, e.g., when opening samplers of multiple CPU cores in parallel).
+  mutable NameTable<CounterConfig> _pmu_counter_configs;
+  std::unique_ptr<std::mutex> _pmu_counter_configs_mutex{ std::make_unique<std::mutex>() };
+
+  /**
+   * Resolves an event string (e.g., "cpu/event=0x3c,umask=0x1/") via the sysfs or an event of a pmu-events catalog
+   * and caches the configuration.
+   *
+   * @param name Event string or name of the event.
+   * @return Name and configuration of the event, or std::nullopt if the event string cannot be resolved.
+   */
+  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> pmu_counter(
+    std::string_view name) const noexcept;
 
   /**
    * Add all generalized counters to the counter config.
@@ -109,5 +203,10 @@ private:
    * If the system is an Intel, read some PEBS counters, if supported.
    */
   void initialize_intel_pebs_counters();
+
+  /**
+   * Add counters and metrics of the top-down microarchitecture analysis, if supported by the system.
+   */
+  void initialize_topdown_metrics();
 };
 }
\ No newline at end of file
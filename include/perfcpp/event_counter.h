@@ -1,30 +1,42 @@
 #pragma once
 
+#include "cgroup.h"
 #include "config.h"
 #include "counter.h"
 #include "counter_definition.h"
 #include "group.h"
+#include "hardware_info.h"
+#include "parallel_open.h"
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace perf {
 class EventCounter
 {
   friend class MultiEventCounterBase;
+  friend class IntervalReader;
+  friend class Benchmark;
 
 private:
   class Event
   {
   public:
-    explicit Event(std::string_view name) noexcept
+    Event(std::string_view name, const Metric& metric, std::vector<std::uint16_t>&& required_counter_ids) noexcept
       : _name(name)
       , _is_hidden(false)
       , _is_counter(false)
       , _group_id(0U)
       , _in_group_id(0U)
+      , _metric(&metric)
+      , _expression(dynamic_cast<const MetricExpression*>(&metric))
+      , _required_counter_ids(std::move(required_counter_ids))
     {
     }
 
@@ -47,6 +59,12 @@ private:
     [[nodiscard]] bool is_hidden() const noexcept { return _is_hidden; }
     [[nodiscard]] std::uint8_t group_id() const noexcept { return _group_id; }
     [[nodiscard]] std::uint8_t in_group_id() const noexcept { return _in_group_id; }
+    [[nodiscard]] const Metric* metric() const noexcept { return _metric; }
+    [[nodiscard]] const MetricExpression* expression() const noexcept { return _expression; }
+    [[nodiscard]] const std::vector<std::uint16_t>& required_counter_ids() const noexcept
+    {
+      return _required_counter_ids;
+    }
 
     void is_hidden(const bool is_hidden) noexcept { _is_hidden = is_hidden; }
 
@@ -56,6 +74,13 @@ private:
     bool _is_hidden;
     std::uint8_t _group_id{ 0U };
     std::uint8_t _in_group_id{ 0U };
+
+    /// Metric (only for metrics) and ids of the events it requires, ordered like Metric::required_counter_names().
+    const Metric* _metric{ nullptr };
+
+    /// Compiled expression, if the metric is defined by an expression (evaluated without virtual calls).
+    const MetricExpression* _expression{ nullptr };
+    std::vector<std::uint16_t> _required_counter_ids;
   };
 
 public:
@@ -106,25 +131,121 @@ public:
   bool add(const std::vector<std::string>& counter_names);
 
   /**
-   * Opens and starts recording performance counters.
+   * Opens the performance counters without starting them.
+   * Counters opened explicitly stay open across start/stop cycles (until close() is called) and
+   * results accumulate over all start/stop intervals.
+   *
+   * @return True, if the performance counters could be opened.
+   */
+  bool open();
+
+  /**
+   * Closes the performance counters.
+   */
+  void close();
+
+  /**
+   * Starts recording performance counters. Opens the counters, if they are not opened.
    *
    * @return True, of the performance counters could be started.
    */
   bool start();
 
   /**
-   * Stops and closes recording performance counters.
+   * Stops recording performance counters. Closes the counters, if they were opened by start().
    */
   void stop();
 
+  /**
+   * Resets the results accumulated over all start/stop intervals since opening the counters.
+   * Calling result() and reset() after every stop() returns the results per interval.
+   */
+  void reset() noexcept;
+
   /**
    * Returns the result of the performance measurement.
+   * If the counters are kept open, the result is accumulated over all start/stop intervals.
    *
    * @param normalization Normalization value, default = 1.
    * @return List of counter names and values.
    */
   [[nodiscard]] CounterResult result(std::uint64_t normalization = 1U) const;
 
+  /**
+   * Returns the result of the performance measurement per core type of a hybrid processor (e.g., "cpu_core" for
+   * performance and "cpu_atom" for efficiency cores); the values of all core types sum up to result().
+   * Counters that were not opened per core type (e.g., software events in groups without hardware events) are
+   * omitted, as are metrics depending on them. The calibrated overhead is not subtracted.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of core PMU names and results; empty if the processor is not hybrid.
+   */
+  [[nodiscard]] std::vector<std::pair<std::string_view, CounterResult>> result_per_core_type(
+    std::uint64_t normalization = 1U) const;
+
+  /**
+   * Writes the result of the performance measurement into the given view, which is indexed by handles
+   * (see handle()) instead of names. Reusing the view avoids allocations and string comparisons, e.g., when
+   * evaluating results at high rates.
+   *
+   * @param result View to write the values of all counters and metrics into.
+   * @param normalization Normalization value, default = 1.
+   */
+  void result(CounterResultView& result, std::uint64_t normalization = 1U) const
+  {
+    EventCounter::result(this, 1U, result, normalization);
+  }
+
+  /**
+   * Returns the handle of an added counter or metric to access its value in a CounterResultView.
+   * Throws an exception if no counter or metric with the given name was added.
+   *
+   * @param name Name of the counter or metric (as reported in the results).
+   * @return Handle of the counter or metric.
+   */
+  [[nodiscard]] CounterHandle handle(std::string_view name) const;
+
+  /**
+   * Measures the cost of the library itself (i.e., the ioctl and read path of starting and stopping the counters)
+   * by recording an empty region multiple times. The median per counter is stored and, if enabled in the config
+   * (see Config::subtract_overhead()), subtracted from the results once per start/stop interval.
+   * Snapshots are not corrected. The calibration is valid for the current configuration and list of counters;
+   * it should be repeated after adding counters or changing the config. Results accumulated so far are reset.
+   *
+   * @param count_runs Number of empty regions to record, default = 100.
+   * @return True, if the counters could be started.
+   */
+  bool calibrate(std::size_t count_runs = 100U);
+
+  /**
+   * @return True, if the overhead of the counters was calibrated.
+   */
+  [[nodiscard]] bool is_calibrated() const noexcept { return !_overhead.empty(); }
+
+  /**
+   * Returns the calibrated overhead per start/stop interval of all counters (see calibrate()), i.e., the values
+   * subtracted from the results per interval. The result is empty, if the counters were not calibrated.
+   *
+   * @return List of counter names and their overhead per interval.
+   */
+  [[nodiscard]] CounterResult calibration() const;
+
+  /**
+   * Returns the current result of the running performance measurement without stopping the counters.
+   * The values include all intervals accumulated so far and are corrected by multiplexing.
+   * The snapshot can be taken from any thread (e.g., a monitoring thread), but the counter should
+   * not be started or stopped concurrently.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult snapshot(std::uint64_t normalization = 1U);
+
+  /**
+   * @return True, if the counters are opened.
+   */
+  [[nodiscard]] bool is_open() const noexcept { return _is_opened; }
+
   /**
    * @return Configuration of the counter.
    */
@@ -148,16 +269,141 @@ private:
   /// Real counters to measure.
   std::vector<Group> _groups;
 
+  /// Flag if the counters are opened.
+  bool _is_opened{ false };
+
+  /// Flag if the counters were opened by start() and should be closed by stop().
+  bool _is_close_on_stop{ false };
+
+  /// Id of the first group that accepts new counters (groups before were closed by add("")).
+  std::size_t _first_open_group_id{ 0U };
+
+  /// Calibrated overhead per start/stop interval of every event (0 for metrics); empty if not calibrated.
+  std::vector<double> _overhead;
+
+  /// Number of start/stop intervals accumulated in the results since the counters were opened or reset.
+  std::uint64_t _count_intervals{ 0U };
+
   /**
-   * Add the specified counter to the list of monitored performance counters.
-   * The counters must exist within the counter definitions.
+   * Mutex serializing opening and closing the counters with readers on other threads (see IntervalReader), which
+   * read the file descriptors. Copies of the event counter get their own mutex.
+   */
+  class LifecycleMutex
+  {
+  public:
+    LifecycleMutex() = default;
+    LifecycleMutex(const LifecycleMutex&) noexcept {}
+    LifecycleMutex(LifecycleMutex&&) noexcept {}
+    ~LifecycleMutex() = default;
+
+    [[nodiscard]] std::mutex& get() const noexcept { return _mutex; }
+
+  private:
+    mutable std::mutex _mutex;
+  };
+  LifecycleMutex _lifecycle_mutex;
+
+  /// Number of times the counters were opened (0 = never opened), such that readers detect re-opened counters.
+  std::uint64_t _open_generation{ 0U };
+
+  /**
+   * Returns the overhead to subtract from the accumulated value of the given event.
    *
-   * @param counter_name Name of the counter.
-   * @param counter Configuration of the counter.
-   * @param is_hidden Indicates if the counter should be exposed in the results.
-   * @return True, if the counter was added.
+   * @param event_id Id of the event.
+   * @return Overhead of all accumulated intervals (0 if not calibrated or subtracting is disabled).
+   */
+  [[nodiscard]] double overhead(const std::size_t event_id) const noexcept
+  {
+    if (this->_overhead.empty() || !this->_config.is_subtract_overhead()) {
+      return .0;
+    }
+
+    return this->_overhead[event_id] * double(this->_count_intervals);
+  }
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters are placed together into the first group that can schedule all of them on the PMU
+   * (e.g., all counters required by a metric); if no group can, they are placed individually.
+   * Counters that were already added before are not added twice.
+   *
+   * @param counters Names and configurations of the counters.
+   * @param is_hidden Indicates if the counters should be exposed in the results.
+   */
+  void add(std::vector<std::pair<std::string_view, CounterConfig>>&& counters, bool is_hidden);
+
+  /**
+   * Adds the given counters to the first group (starting with the preferred one) that can schedule all of them,
+   * creating a new group if needed.
+   *
+   * @param counters Names and configurations of the counters.
+   * @param is_hidden Indicates if the counters should be exposed in the results.
+   * @param preferred_group_id Id of the group to try first.
+   * @return True, if the counters were added.
+   */
+  bool add_to_group(const std::vector<std::pair<std::string_view, CounterConfig>>& counters,
+                    bool is_hidden,
+                    std::optional<std::uint8_t> preferred_group_id);
+
+  /**
+   * Checks if the PMU can schedule the given counters together with the members of the given group, based on
+   * the number of general purpose and fixed counters of the PMU (or the configured maximal number of counters per
+   * group). Software counters do not occupy hardware counters.
+   *
+   * @param group Group to add the counters to.
+   * @param counters Counters to add.
+   * @return True, if the counters fit into the group.
+   */
+  [[nodiscard]] bool is_schedulable(const Group& group,
+                                    const std::vector<std::pair<std::string_view, CounterConfig>>& counters) const;
+
+  /**
+   * Reads the values of all counters, including hidden ones.
+   *
+   * @param normalization Normalization value.
+   * @param is_snapshot If true, the values of the last snapshot are read instead of the accumulated values.
+   * @param hybrid_pmu If set, only the share counted on the given core PMU of a hybrid processor is read (NaN for
+   * counters that were not opened on the core PMU).
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] std::vector<std::pair<std::string_view, double>> counter_values(
+    std::uint64_t normalization,
+    bool is_snapshot,
+    const HybridPmu* hybrid_pmu = nullptr) const;
+
+  /**
+   * Reads the multiplexing details of all counters, including hidden ones, in the same order as counter_values().
+   *
+   * @param is_snapshot If true, the details of the last snapshot are read instead of the accumulated values.
+   * @return List of multiplexing details.
    */
-  void add(std::string_view counter_name, CounterConfig counter, bool is_hidden);
+  [[nodiscard]] std::vector<Multiplexing> multiplexing(bool is_snapshot) const;
+
+  /**
+   * Calculates the metrics from the given counter values and removes hidden counters and counters without value (NaN).
+   * Counters whose running ratio is below the configured threshold are flagged or removed, depending on the
+   * multiplexing policy.
+   *
+   * @param counter_values Values of all counters, including hidden ones.
+   * @param multiplexing Multiplexing details of all counters (same order as the values), may be empty.
+   * @return List of counter and metric names and values.
+   */
+  [[nodiscard]] CounterResult evaluate(std::vector<std::pair<std::string_view, double>>&& counter_values,
+                                       std::vector<Multiplexing>&& multiplexing = {}) const;
+
+  /**
+   * Writes the values of all counters and metrics, aggregated over the given event counters (that share the same
+   * counters), into the given view.
+   *
+   * @param event_counters First event counter.
+   * @param count_event_counters Number of event counters.
+   * @param result View to write the values into.
+   * @param normalization Normalization value.
+   */
+  static void result(const EventCounter* event_counters,
+                     std::size_t count_event_counters,
+                     CounterResultView& result,
+                     std::uint64_t normalization);
 };
 
 class MultiEventCounterBase
@@ -171,7 +417,37 @@ protected:
                                 const std::vector<std::string>& counter_names);
 
   [[nodiscard]] static CounterResult result(const std::vector<EventCounter>& event_counter,
-                                            std::uint64_t normalization = 1U);
+                                            std::uint64_t normalization = 1U,
+                                            bool is_snapshot = false);
+
+  [[nodiscard]] static CounterResult snapshot(std::vector<EventCounter>& event_counter,
+                                              std::uint64_t normalization = 1U);
+
+  static void result(const std::vector<EventCounter>& event_counter,
+                     CounterResultView& result,
+                     std::uint64_t normalization = 1U)
+  {
+    EventCounter::result(event_counter.data(), event_counter.size(), result, normalization);
+  }
+
+  /**
+   * Opens the given event counters (that are not opened yet) in parallel, the first one on the calling thread.
+   *
+   * @param event_counter List of event counters to open.
+   * @param is_close_on_stop If true, the counters opened here will be closed when stopping them.
+   * @param timing Duration of the open phases.
+   * @return True, if all counters could be opened.
+   */
+  [[nodiscard]] static bool open(std::vector<EventCounter>& event_counter, bool is_close_on_stop, OpenTiming& timing);
+
+  /**
+   * Adds the values of the given event counter to the retired event counter (which is never opened) and resets the
+   * given event counter, such that it can be re-opened without losing its values.
+   *
+   * @param event_counter Event counter to retire (closed).
+   * @param retired Event counter accumulating the values of retired event counters.
+   */
+  static void retire(EventCounter& event_counter, EventCounter& retired);
 };
 
 /**
@@ -181,6 +457,8 @@ protected:
  */
 class MultiThreadEventCounter final : private MultiEventCounterBase
 {
+  friend class IntervalReader;
+
 public:
   MultiThreadEventCounter(const CounterDefinition& counter_list, std::uint16_t num_threads, Config config = {});
 
@@ -191,7 +469,9 @@ public:
   {
   }
 
-  ~MultiThreadEventCounter() = default;
+  MultiThreadEventCounter(MultiThreadEventCounter&&) noexcept = default;
+
+  ~MultiThreadEventCounter();
 
   /**
    * Add the specified counter to the list of monitored performance counters.
@@ -239,7 +519,28 @@ public:
   }
 
   /**
-   * Opens and starts recording performance counters for the given thread.
+   * Opens the performance counters for the given thread without starting them.
+   * The counters stay open across start/stop cycles until they are closed.
+   *
+   * @param thread_id Id of the thread.
+   * @return True, of the performance counters could be opened.
+   */
+  bool open(std::uint16_t thread_id) { return this->_thread_local_counter[thread_id].open(); }
+
+  /**
+   * Closes the performance counters for the given thread.
+   *
+   * @param thread_id Id of the thread.
+   */
+  void close(std::uint16_t thread_id) { this->_thread_local_counter[thread_id].close(); }
+
+  /**
+   * Closes the performance counters for all threads.
+   */
+  void close();
+
+  /**
+   * Opens (if not opened) and starts recording performance counters for the given thread.
    *
    * @param thread_id Id of the thread.
    * @return True, of the performance counters could be started.
@@ -247,7 +548,7 @@ public:
   bool start(std::uint16_t thread_id) { return this->_thread_local_counter[thread_id].start(); }
 
   /**
-   * Stops and closes recording performance counters.
+   * Stops recording performance counters. Closes the counters, if they were opened by start().
    *
    * @param thread_id Id of the thread.
    */
@@ -256,11 +557,7 @@ public:
   /**
    * Stops and closes recording performance counters for all threads.
    */
-  void stop() {
-    for (auto& event_counter : this->_thread_local_counter) {
-      event_counter.stop();
-    }
-  }
+  void stop();
 
   /**
    * Returns the result of the performance measurement.
@@ -268,11 +565,35 @@ public:
    * @param normalization Normalization value, default = 1.
    * @return List of counter names and values.
    */
-  [[nodiscard]] CounterResult result(std::uint64_t normalization = 1U) const
+  [[nodiscard]] CounterResult result(std::uint64_t normalization = 1U) const;
+
+  /**
+   * Writes the result of the performance measurement into the given view, indexed by handles.
+   *
+   * @param result View to write the values of all counters and metrics into.
+   * @param normalization Normalization value, default = 1.
+   */
+  void result(CounterResultView& result, std::uint64_t normalization = 1U) const;
+
+  /**
+   * Returns the handle of an added counter or metric to access its value in a CounterResultView.
+   *
+   * @param name Name of the counter or metric (as reported in the results).
+   * @return Handle of the counter or metric.
+   */
+  [[nodiscard]] CounterHandle handle(const std::string_view name) const
   {
-    return MultiEventCounterBase::result(_thread_local_counter, normalization);
+    return this->_thread_local_counter.front().handle(name);
   }
 
+  /**
+   * Returns the current result of the running performance measurement without stopping the counters.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult snapshot(std::uint64_t normalization = 1U);
+
   /**
    * Returns the result of the performance measurement for a given thread.
    *
@@ -280,13 +601,48 @@ public:
    * @param normalization Normalization value, default = 1.
    * @return List of counter names and values.
    */
-  [[nodiscard]] CounterResult result_of_thread(const std::uint16_t thread_id, std::uint64_t normalization = 1U) const
-  {
-    return _thread_local_counter[thread_id].result(normalization);
-  }
+  [[nodiscard]] CounterResult result_of_thread(std::uint16_t thread_id, std::uint64_t normalization = 1U) const;
+
+  /**
+   * Returns the counter of the calling thread instead of using a caller-provided thread id.
+   * The first call of each thread acquires a free thread-local counter (lock-free), later calls
+   * return the same counter without allocating. When the thread exits, its counter is closed and
+   * released for other threads; the values recorded so far are kept and added to the results. Reading the results,
+   * stopping, and closing all counters are synchronized with exiting threads.
+   * Threads using local() should not be mixed with explicit thread ids.
+   * Throws an exception if all thread-local counters are acquired by other (running) threads.
+   *
+   * @return Counter of the calling thread.
+   */
+  [[nodiscard]] EventCounter& local() { return this->_thread_local_counter[this->local_thread_id()]; }
+
+  /**
+   * Returns the id of the thread-local counter of the calling thread, acquiring a free one at the first call.
+   *
+   * @return Id of the calling thread's counter.
+   */
+  [[nodiscard]] std::uint16_t local_thread_id();
+
+  /**
+   * @return Number of threads that acquired a thread-local counter via local() (including threads that exited).
+   */
+  [[nodiscard]] std::uint64_t count_registered_threads() const noexcept;
 
 private:
+  /**
+   * Slots of the thread-local counters acquired via local(). Acquiring threads reference the registry weakly: Exiting
+   * threads release their slots while the MultiThreadEventCounter exists, and forget the slots of destroyed instances.
+   */
+  class Registry;
+
+  /// One counter per thread, followed by one counter that accumulates the values of threads that exited (never opened).
   std::vector<perf::EventCounter> _thread_local_counter;
+
+  /// Id of this instance, used to cache the acquired counter per thread.
+  std::uint64_t _instance_id;
+
+  /// Slots acquired by threads via local().
+  std::shared_ptr<Registry> _registry;
 };
 
 using EventCounterMT = MultiThreadEventCounter;
@@ -298,6 +654,8 @@ using EventCounterMT = MultiThreadEventCounter;
  */
 class MultiProcessEventCounter final : private MultiEventCounterBase
 {
+  friend class IntervalReader;
+
 public:
   MultiProcessEventCounter(const CounterDefinition& counter_list, std::vector<pid_t>&& process_ids, Config config = {});
 
@@ -356,14 +714,27 @@ public:
   }
 
   /**
-   * Opens and starts recording performance counters for the given thread.
+   * Opens the performance counters without starting them.
+   * The counters stay open across start/stop cycles until they are closed.
+   *
+   * @return True, of the performance counters could be opened.
+   */
+  bool open();
+
+  /**
+   * Closes the performance counters.
+   */
+  void close();
+
+  /**
+   * Opens (if not opened) and starts recording performance counters.
    *
    * @return True, of the performance counters could be started.
    */
   bool start();
 
   /**
-   * Stops and closes recording performance counters.
+   * Stops recording performance counters. Closes the counters, if they were opened by start().
    */
   void stop();
 
@@ -378,10 +749,261 @@ public:
     return MultiEventCounterBase::result(_process_local_counter, normalization);
   }
 
+  /**
+   * Writes the result of the performance measurement into the given view, indexed by handles.
+   *
+   * @param result View to write the values of all counters and metrics into.
+   * @param normalization Normalization value, default = 1.
+   */
+  void result(CounterResultView& result, std::uint64_t normalization = 1U) const
+  {
+    MultiEventCounterBase::result(this->_process_local_counter, result, normalization);
+  }
+
+  /**
+   * Returns the handle of an added counter or metric to access its value in a CounterResultView.
+   *
+   * @param name Name of the counter or metric (as reported in the results).
+   * @return Handle of the counter or metric.
+   */
+  [[nodiscard]] CounterHandle handle(const std::string_view name) const
+  {
+    return this->_process_local_counter.front().handle(name);
+  }
+
+  /**
+   * Returns the current result of the running performance measurement without stopping the counters.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult snapshot(std::uint64_t normalization = 1U)
+  {
+    return MultiEventCounterBase::snapshot(_process_local_counter, normalization);
+  }
+
 private:
   std::vector<perf::EventCounter> _process_local_counter;
 };
 
+/**
+ * Wrapper for EventCounter to record counters of an external (running) process, including all of its threads.
+ * The threads are discovered via /proc/<pid>/task when opening the counters; threads created afterward are picked
+ * up by rescan(). Every thread is recorded by its own counter; the results can be aggregated over the process or
+ * queried for a specific thread. Counters of threads that exited keep their final values: They are detected when
+ * opening the counters or rescanning, and are neither opened nor started again.
+ */
+class AttachedProcessEventCounter final : private MultiEventCounterBase
+{
+public:
+  AttachedProcessEventCounter(const CounterDefinition& counter_list, pid_t process_id, Config config = {})
+    : _event_counter(counter_list, config)
+    , _process_id(process_id)
+  {
+  }
+
+  AttachedProcessEventCounter(EventCounter&& event_counter, const pid_t process_id)
+    : _event_counter(std::move(event_counter))
+    , _process_id(process_id)
+  {
+  }
+
+  AttachedProcessEventCounter(const EventCounter& event_counter, const pid_t process_id)
+    : AttachedProcessEventCounter(perf::EventCounter{ event_counter }, process_id)
+  {
+  }
+
+  ~AttachedProcessEventCounter() = default;
+
+  /**
+   * Add the specified counter to the list of monitored performance counters.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(std::string&& counter_name) { return add(std::vector<std::string>{ std::move(counter_name) }); }
+
+  /**
+   * Add the specified counter to the list of monitored performance counters.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(const std::string& counter_name) { return add(std::string{ counter_name }); }
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(std::vector<std::string>&& counter_names);
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(const std::vector<std::string>& counter_names) { return add(std::vector<std::string>(counter_names)); }
+
+  /**
+   * Discovers the threads of the process and opens their performance counters without starting them.
+   * The counters stay open across start/stop cycles until they are closed. Counters of threads that exited since
+   * the last time are not opened again (keeping their values). Throws an exception if the threads of the process
+   * cannot be listed.
+   *
+   * @return True, if the performance counters of any thread could be opened.
+   */
+  bool open();
+
+  /**
+   * Closes the performance counters.
+   */
+  void close();
+
+  /**
+   * Opens (if not opened) and starts recording performance counters of all discovered threads that are alive.
+   *
+   * @return True, if the performance counters of all live threads (and at least one) could be started.
+   */
+  bool start();
+
+  /**
+   * Stops recording performance counters. Closes the counters, if they were opened by start().
+   */
+  void stop();
+
+  /**
+   * Discovers threads of the process that were created since the last scan. Counters of new threads are opened
+   * and started, if the counters are opened and started, respectively. Threads that exit between discovering and
+   * opening them are skipped; threads that exited since the last scan are not started again. Throws an exception if
+   * the threads of the process cannot be listed.
+   *
+   * @return Number of newly discovered threads.
+   */
+  std::size_t rescan();
+
+  /**
+   * @return Process id the counter is attached to.
+   */
+  [[nodiscard]] pid_t process_id() const noexcept { return _process_id; }
+
+  /**
+   * @return Ids of all discovered threads (including exited ones), in order of their discovery.
+   */
+  [[nodiscard]] const std::vector<pid_t>& thread_ids() const noexcept { return _thread_ids; }
+
+  /**
+   * Returns the result of the performance measurement, aggregated over all threads of the process.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult result(std::uint64_t normalization = 1U) const
+  {
+    return this->_thread_local_counter.empty()
+             ? CounterResult{}
+             : MultiEventCounterBase::result(this->_thread_local_counter, normalization);
+  }
+
+  /**
+   * Returns the result of the performance measurement of a single thread.
+   *
+   * @param thread_id Id of the thread.
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values, or std::nullopt if the thread was not discovered.
+   */
+  [[nodiscard]] std::optional<CounterResult> result(pid_t thread_id, std::uint64_t normalization = 1U) const;
+
+  /**
+   * Writes the result of the performance measurement, aggregated over all threads, into the given view.
+   *
+   * @param result View to write the values of all counters and metrics into.
+   * @param normalization Normalization value, default = 1.
+   */
+  void result(CounterResultView& result, std::uint64_t normalization = 1U) const
+  {
+    if (!this->_thread_local_counter.empty()) {
+      MultiEventCounterBase::result(this->_thread_local_counter, result, normalization);
+    }
+  }
+
+  /**
+   * Returns the handle of an added counter or metric to access its value in a CounterResultView.
+   *
+   * @param name Name of the counter or metric (as reported in the results).
+   * @return Handle of the counter or metric.
+   */
+  [[nodiscard]] CounterHandle handle(const std::string_view name) const { return this->_event_counter.handle(name); }
+
+  /**
+   * Returns the current result of the running performance measurement without stopping the counters.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult snapshot(std::uint64_t normalization = 1U)
+  {
+    return this->_thread_local_counter.empty()
+             ? CounterResult{}
+             : MultiEventCounterBase::snapshot(this->_thread_local_counter, normalization);
+  }
+
+private:
+  /// Counter with all added counters and metrics; copied for every discovered thread.
+  EventCounter _event_counter;
+
+  pid_t _process_id;
+
+  /// Ids of the discovered threads, their counters, and whether the threads are alive (same order).
+  std::vector<pid_t> _thread_ids;
+  std::vector<perf::EventCounter> _thread_local_counter;
+  std::vector<bool> _is_thread_alive;
+
+  bool _is_opened{ false };
+  bool _is_running{ false };
+
+  /// Flag if the counters were opened by start() and should be closed by stop().
+  bool _is_close_on_stop{ false };
+
+  /**
+   * Lists the ids of all current threads of the given process.
+   *
+   * @param process_id Id of the process.
+   * @return List of thread ids.
+   */
+  [[nodiscard]] static std::vector<pid_t> read_thread_ids(pid_t process_id);
+
+  /**
+   * Adds counters for the threads of the given list that were not discovered before.
+   *
+   * @param thread_ids Sorted list of the current threads of the process.
+   * @return Number of newly discovered threads.
+   */
+  std::size_t rescan(const std::vector<pid_t>& thread_ids);
+
+  /**
+   * Marks discovered threads that are missing in the given list as exited.
+   *
+   * @param thread_ids Sorted list of the current threads of the process.
+   */
+  void detect_exited_threads(const std::vector<pid_t>& thread_ids);
+
+  /**
+   * Opens (and starts) the counter of a thread. Closes the counter if the thread exited in the meantime.
+   *
+   * @param event_counter Counter of the thread.
+   * @param is_start True, if the counter should be started after opening.
+   * @return True, if the counter could be opened (and started).
+   */
+  [[nodiscard]] static bool open(EventCounter& event_counter, bool is_start);
+};
+
 /**
  * Wrapper for EventCounter to record counters on different CPU cores.
  * CPU ids have to be specified. The counter can be started/stopped at once.
@@ -389,6 +1011,8 @@ private:
  */
 class MultiCoreEventCounter final : private MultiEventCounterBase
 {
+  friend class IntervalReader;
+
 public:
   MultiCoreEventCounter(const CounterDefinition& counter_list,
                         std::vector<std::uint16_t>&& cpu_ids,
@@ -401,6 +1025,31 @@ public:
   {
   }
 
+  /**
+   * Records all processes of the given cgroup on the given CPU cores.
+   *
+   * @param counter_list Counter definitions.
+   * @param cgroup Cgroup to record (has to be alive while the counters are opened).
+   * @param cpu_ids List of CPU cores.
+   * @param config Configuration of the counters.
+   */
+  MultiCoreEventCounter(const CounterDefinition& counter_list,
+                        const CgroupHandle& cgroup,
+                        std::vector<std::uint16_t>&& cpu_ids,
+                        Config config = {});
+
+  /**
+   * Records all processes of the given cgroup on all online CPU cores.
+   *
+   * @param counter_list Counter definitions.
+   * @param cgroup Cgroup to record (has to be alive while the counters are opened).
+   * @param config Configuration of the counters.
+   */
+  MultiCoreEventCounter(const CounterDefinition& counter_list, const CgroupHandle& cgroup, Config config = {})
+    : MultiCoreEventCounter(counter_list, cgroup, HardwareInfo::online_cpu_ids(), config)
+  {
+  }
+
   ~MultiCoreEventCounter() = default;
 
   /**
@@ -449,14 +1098,27 @@ public:
   }
 
   /**
-   * Opens and starts recording performance counters for the given thread.
+   * Opens the performance counters without starting them.
+   * The counters stay open across start/stop cycles until they are closed.
+   *
+   * @return True, of the performance counters could be opened.
+   */
+  bool open();
+
+  /**
+   * Closes the performance counters.
+   */
+  void close();
+
+  /**
+   * Opens (if not opened) and starts recording performance counters.
    *
    * @return True, of the performance counters could be started.
    */
   bool start();
 
   /**
-   * Stops and closes recording performance counters.
+   * Stops recording performance counters. Closes the counters, if they were opened by start().
    */
   void stop();
 
@@ -471,7 +1133,48 @@ public:
     return MultiEventCounterBase::result(_cpu_local_counter, normalization);
   }
 
+  /**
+   * Writes the result of the performance measurement into the given view, indexed by handles.
+   *
+   * @param result View to write the values of all counters and metrics into.
+   * @param normalization Normalization value, default = 1.
+   */
+  void result(CounterResultView& result, std::uint64_t normalization = 1U) const
+  {
+    MultiEventCounterBase::result(this->_cpu_local_counter, result, normalization);
+  }
+
+  /**
+   * Returns the handle of an added counter or metric to access its value in a CounterResultView.
+   *
+   * @param name Name of the counter or metric (as reported in the results).
+   * @return Handle of the counter or metric.
+   */
+  [[nodiscard]] CounterHandle handle(const std::string_view name) const
+  {
+    return this->_cpu_local_counter.front().handle(name);
+  }
+
+  /**
+   * Returns the current result of the running performance measurement without stopping the counters.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult snapshot(std::uint64_t normalization = 1U)
+  {
+    return MultiEventCounterBase::snapshot(_cpu_local_counter, normalization);
+  }
+
+  /**
+   * @return Duration of the phases when the counters were opened the last time.
+   */
+  [[nodiscard]] OpenTiming open_timing() const noexcept { return _open_timing; }
+
 private:
   std::vector<perf::EventCounter> _cpu_local_counter;
+
+  /// Duration of the phases when the counters were opened the last time.
+  OpenTiming _open_timing;
 };
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 7, 0)
 #define PERFCPP_NO_RECORD_CGROUP
 #define PERFCPP_NO_SAMPLE_CGROUP
+#define PERFCPP_NO_SAMPLE_BRANCH_HW_INDEX
 #endif
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 11, 0)
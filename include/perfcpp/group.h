@@ -2,6 +2,8 @@
 
 #include "config.h"
 #include "counter.h"
+#include "hardware_info.h"
+#include <vector>
 
 namespace perf {
 class Group
@@ -13,24 +15,126 @@ public:
   Group(Group&&) noexcept = default;
   Group(const Group&) = default;
 
-  constexpr static inline auto MAX_MEMBERS = 8U;
+  constexpr static inline auto MAX_MEMBERS = 16U;
+
+  /**
+   * Raw values of the members and time enabled/running, counted by the kernel since opening the group (merged over
+   * the instances on core PMUs of a hybrid processor).
+   */
+  struct Counts
+  {
+    std::array<std::uint64_t, MAX_MEMBERS> values{};
+    std::uint64_t time_enabled{ 0U };
+    std::uint64_t time_running{ 0U };
+  };
+
   bool add(CounterConfig counter);
 
+  /**
+   * Opens the members of the group. On hybrid processors, groups of generic hardware events are opened once per core
+   * PMU (e.g., on performance and efficiency cores), and the values of all instances are merged.
+   *
+   * @param config Config to open the members with.
+   * @return True, if all members could be opened.
+   */
   bool open(Config config);
   void close();
 
   bool start();
   bool stop();
 
+  /**
+   * Resets the values accumulated over all start/stop intervals since opening the group.
+   */
+  void reset() noexcept;
+
+  /**
+   * Adds the values accumulated by the given group (with the same members), including its instances on further core
+   * PMUs of a hybrid processor, to the values of this group. This way, values survive re-opening the given group.
+   *
+   * @param other Group to add the accumulated values of.
+   */
+  void add_accumulated(const Group& other) noexcept;
+
+  /**
+   * Reads the current values of the group without stopping it, including the values accumulated so far.
+   * The values are read via read() (never rdpmc) such that the snapshot can be taken by any thread.
+   *
+   * @return True, if the values could be read.
+   */
+  bool snapshot();
+
+  /**
+   * Reads the raw values counted since opening the group into the given buffer, without modifying the group. Since
+   * only the file descriptors are read, this is safe while another thread starts and stops the group (but not while
+   * it opens or closes the group).
+   *
+   * @param counts Buffer to read the values into.
+   * @return True, if the values could be read.
+   */
+  [[nodiscard]] bool read_counts(Counts& counts) const;
+
   [[nodiscard]] std::size_t size() const noexcept { return _members.size(); }
   [[nodiscard]] bool empty() const noexcept { return _members.empty(); }
 
+  /**
+   * @return True, if the group is pinned to the PMU (via the config or one of its counters).
+   */
+  [[nodiscard]] bool is_pinned() const noexcept { return _is_pinned; }
+
   [[nodiscard]] std::int32_t leader_file_descriptor() const noexcept
   {
     return !_members.empty() ? _members.front().file_descriptor() : -1;
   }
 
-  [[nodiscard]] double get(std::size_t index) const;
+  [[nodiscard]] double get(const std::size_t index) const
+  {
+    return _hybrid_groups.empty() ? _accumulated.get(index) : merged_multiplexing(index, false).scaled_value();
+  }
+
+  [[nodiscard]] double get_snapshot(const std::size_t index) const
+  {
+    return _hybrid_groups.empty() ? _snapshot.get(index) : merged_multiplexing(index, true).scaled_value();
+  }
+
+  /**
+   * Share of the value of the member with the given index that was counted on the given core PMU of a hybrid
+   * processor (the shares of all core PMUs sum up to get()).
+   *
+   * @param index Index of the member.
+   * @param hybrid_pmu Core PMU.
+   * @return The share of the value, or NaN if the group was not opened on the core PMU.
+   */
+  [[nodiscard]] double get(std::size_t index, const HybridPmu& hybrid_pmu) const;
+
+  [[nodiscard]] Multiplexing multiplexing(const std::size_t index) const { return merged_multiplexing(index, false); }
+
+  [[nodiscard]] Multiplexing multiplexing_snapshot(const std::size_t index) const
+  {
+    return merged_multiplexing(index, true);
+  }
+
+  /**
+   * Determines the core PMUs of a hybrid processor the group has to be opened on: Groups with generic hardware events
+   * (and software events) are opened on every core PMU (or the PMU serving the CPU core of the config); groups with
+   * events of a specific core PMU are bound to that PMU.
+   *
+   * @param config Config the group is opened with.
+   * @return List of core PMUs; empty, if the processor is not hybrid or the group is not bound to core PMUs.
+   */
+  [[nodiscard]] std::vector<const HybridPmu*> hybrid_pmus(const Config& config) const;
+
+  /**
+   * Binds the generic hardware events of the group to a core PMU of a hybrid processor.
+   *
+   * @param hybrid_pmu Core PMU, or nullptr to open the events on the default PMU.
+   */
+  void hybrid_pmu(const HybridPmu* hybrid_pmu) noexcept { _hybrid_pmu = hybrid_pmu; }
+
+  /**
+   * @return Core PMU the group is bound to, or nullptr if the group is opened on the default PMU.
+   */
+  [[nodiscard]] const HybridPmu* hybrid_pmu() const noexcept { return _hybrid_pmu; }
 
   [[nodiscard]] Counter& member(const std::size_t index) { return _members[index]; }
 
@@ -53,12 +157,140 @@ private:
     std::array<value, MAX_MEMBERS> values;
   };
 
+  /**
+   * Values (per member) and time enabled/running accumulated over multiple start/stop intervals.
+   */
+  struct accumulated_value
+  {
+    std::array<std::uint64_t, MAX_MEMBERS> values{};
+    std::uint64_t time_enabled{ 0U };
+    std::uint64_t time_running{ 0U };
+
+    /**
+     * @return The value of the member with the given index, corrected by multiplexing.
+     */
+    [[nodiscard]] double get(std::size_t index) const noexcept;
+
+    /**
+     * @return The raw value of the member with the given index and the time enabled/running.
+     */
+    [[nodiscard]] Multiplexing multiplexing(std::size_t index) const noexcept;
+  };
+
   std::vector<Counter> _members;
 
   read_format _start_value;
 
   read_format _end_value;
 
+  /// Values accumulated over all start/stop intervals since opening the group.
+  accumulated_value _accumulated;
+
+  /// Values of the last snapshot, including the accumulated values.
+  accumulated_value _snapshot;
+
+  /// Flag if the group is started.
+  bool _is_running{ false };
+
+  /// Flag if the members were mapped to read their values from user-space (via rdpmc).
+  bool _is_read_with_rdpmc{ false };
+
+  /// Thread that opened the group; rdpmc reads the counters of the calling thread, other threads use read().
+  pid_t _rdpmc_thread_id{ 0 };
+
+  /// Flag if the group is pinned to the PMU.
+  bool _is_pinned{ false };
+
+  /// Flag if the (pinned) group went into error state, i.e., it could not be scheduled on the PMU.
+  bool _is_in_error_state{ false };
+
+  /// Core PMU of a hybrid processor the group is bound to (nullptr = default PMU).
+  const HybridPmu* _hybrid_pmu{ nullptr };
+
+  /// Instances of the group on further core PMUs of a hybrid processor, opened, started, and read with this group.
+  std::vector<Group> _hybrid_groups;
+
+  /**
+   * Opens the members on the PMU the group is bound to.
+   *
+   * @param config Config to open the members with.
+   * @return True, if all members could be opened.
+   */
+  bool open_members(const Config& config);
+
+  /**
+   * Reads the current values of the members (of this group only) without stopping it.
+   *
+   * @return True, if the values could be read.
+   */
+  bool snapshot_members();
+
+  /**
+   * Reads the raw values of the members (of this group only) and merges them into the given buffer.
+   *
+   * @param counts Buffer to merge the values into.
+   * @return True, if the values could be read.
+   */
+  [[nodiscard]] bool read_counts_members(Counts& counts) const;
+
+  /**
+   * Merges the values and times of the member with the given index over all instances on core PMUs of a hybrid
+   * processor: Each instance is enabled the entire time but only runs while the thread is scheduled on its core
+   * type, so raw values and running times add up while the enabled time is shared.
+   *
+   * @param index Index of the member.
+   * @param is_snapshot True, if the values of the last snapshot should be merged.
+   * @return Merged multiplexing details (the details of this group, if the group has no further instances).
+   */
+  [[nodiscard]] Multiplexing merged_multiplexing(std::size_t index, bool is_snapshot) const;
+
+  /**
+   * Adds the difference between the given start and end values to the accumulated values.
+   *
+   * @param start_value Values read when starting.
+   * @param end_value Values read when stopping (or snapshotting).
+   * @param accumulated Accumulated values to add the difference to.
+   */
+  void accumulate(const read_format& start_value, const read_format& end_value, accumulated_value& accumulated) const;
+
+  /**
+   * Reads the values of all members into the given read format.
+   * Uses rdpmc if the members are mapped and the hardware allows user-space reads; falls back to read() otherwise.
+   * Detects the error state of pinned groups (read() returns EOF).
+   *
+   * @param value Read format to read the values into.
+   * @return True, if the values could be read.
+   */
+  [[nodiscard]] bool read(read_format& value);
+
+  /**
+   * Throws an exception if the group went into error state.
+   */
+  void throw_if_in_error_state() const;
+
+  /**
+   * Reads the values of all members from user-space via rdpmc, following the seqlock protocol of the
+   * perf_event_mmap_page.
+   *
+   * @param value Read format to read the values into.
+   * @return True, if all members could be read from user-space.
+   */
+  [[nodiscard]] bool read_with_rdpmc(read_format& value) const noexcept;
+
+  /**
+   * Reads the value of a single counter via rdpmc, including the (extrapolated) time enabled and running.
+   *
+   * @param user_page Mapped perf_event_mmap_page of the counter.
+   * @param value Value of the counter.
+   * @param time_enabled Time the counter was enabled.
+   * @param time_running Time the counter was running.
+   * @return True, if the counter could be read from user-space.
+   */
+  [[nodiscard]] static bool read_with_rdpmc(const perf_event_mmap_page* user_page,
+                                            std::uint64_t& value,
+                                            std::uint64_t& time_enabled,
+                                            std::uint64_t& time_running) noexcept;
+
   [[nodiscard]] static std::optional<std::uint64_t> value_for_id(const read_format& value,
                                                                  const std::uint64_t id) noexcept
   {
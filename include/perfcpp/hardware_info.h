@@ -1,8 +1,16 @@
 #pragma once
 
+#include "pmu_event_parser.h"
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
+#include <linux/perf_event.h>
+#include <numeric>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 #if defined(__x86_64__) || defined(__i386__)
 #include <cpuid.h>
 #endif
@@ -12,6 +20,77 @@
 #endif
 
 namespace perf {
+/**
+ * Core PMU of a hybrid processor (e.g., "cpu_core" for the performance cores and "cpu_atom" for the efficiency cores
+ * of Intel Alder Lake and newer). Generic hardware events (PERF_TYPE_HARDWARE and PERF_TYPE_HW_CACHE) count on a
+ * specific core PMU if its type is set in the upper 32 bits of the config ("extended type").
+ */
+class HybridPmu
+{
+public:
+  HybridPmu(std::string&& name, const std::uint32_t type, std::vector<std::uint16_t>&& cpu_ids) noexcept
+    : _name(std::move(name))
+    , _type(type)
+    , _cpu_ids(std::move(cpu_ids))
+  {
+  }
+  ~HybridPmu() = default;
+
+  /**
+   * @return Name of the PMU (e.g., "cpu_atom").
+   */
+  [[nodiscard]] const std::string& name() const noexcept { return _name; }
+
+  /**
+   * @return Dynamic type of the PMU.
+   */
+  [[nodiscard]] std::uint32_t type() const noexcept { return _type; }
+
+  /**
+   * @return Ids of the CPU cores served by the PMU.
+   */
+  [[nodiscard]] const std::vector<std::uint16_t>& cpu_ids() const noexcept { return _cpu_ids; }
+
+  /**
+   * @param cpu_id Id of a CPU core.
+   * @return True, if the PMU serves the given CPU core.
+   */
+  [[nodiscard]] bool is_serving(const std::uint16_t cpu_id) const noexcept
+  {
+    return std::find(_cpu_ids.begin(), _cpu_ids.end(), cpu_id) != _cpu_ids.end();
+  }
+
+  /**
+   * @param type Type of the event.
+   * @param event_id Id (config) of the event.
+   * @return True, if the event is a generic hardware event that is not yet bound to a specific core PMU.
+   */
+  [[nodiscard]] static bool is_generic_event(const std::uint32_t type, const std::uint64_t event_id) noexcept
+  {
+    return (type == PERF_TYPE_HARDWARE || type == PERF_TYPE_HW_CACHE) && (event_id >> EXTENDED_TYPE_SHIFT) == 0U;
+  }
+
+  /**
+   * Binds a generic hardware event to this PMU; other events are not changed.
+   *
+   * @param perf_event Event attribute to bind.
+   */
+  void bind(perf_event_attr& perf_event) const noexcept
+  {
+    if (is_generic_event(perf_event.type, perf_event.config)) {
+      perf_event.config |= std::uint64_t{ _type } << EXTENDED_TYPE_SHIFT;
+    }
+  }
+
+private:
+  /// Position of the PMU type within the config of generic hardware events (PERF_PMU_TYPE_SHIFT, since Linux 5.13).
+  constexpr static inline auto EXTENDED_TYPE_SHIFT = 32U;
+
+  std::string _name;
+  std::uint32_t _type;
+  std::vector<std::uint16_t> _cpu_ids;
+};
+
 /**
  * Access to information about the underlying hardware substrate like manufacturer and perf specifics.
  */
@@ -75,6 +154,193 @@ public:
     return false;
   }
 
+  /**
+   * Returns the number of general purpose performance counters per logical core that are available to perf, i.e.,
+   * one counter less if the NMI watchdog is enabled (which occupies one counter permanently).
+   *
+   * @return Number of general purpose counters, or std::nullopt if the number cannot be detected.
+   */
+  [[nodiscard]] static std::optional<std::uint8_t> count_general_purpose_counters()
+  {
+    static const auto count_counters = []() -> std::optional<std::uint8_t> {
+      auto count_counters = std::optional<std::uint8_t>{ std::nullopt };
+
+#if defined(__x86_64__) || defined(__i386__)
+      std::uint32_t eax, ebx, ecx, edx;
+
+      if (is_intel()) {
+        /// Architectural performance monitoring leaf: EAX[15:8] holds the number of counters per logical core.
+        if (__get_cpuid_count(0x0A, 0, &eax, &ebx, &ecx, &edx) && (eax & 0xFFU) > 0U) {
+          count_counters = std::uint8_t((eax >> 8U) & 0xFFU);
+        }
+      } else if (is_amd()) {
+        /// Performance monitoring v2 reports the number of core counters (EBX[3:0]), older processors
+        /// provide six counters with the core performance counter extension and four without.
+        if (__get_cpuid_count(0x80000022, 0, &eax, &ebx, &ecx, &edx) && (ebx & 0xFU) > 0U) {
+          count_counters = std::uint8_t(ebx & 0xFU);
+        } else if (__get_cpuid_count(0x80000001, 0, &eax, &ebx, &ecx, &edx)) {
+          count_counters = static_cast<bool>(ecx & (std::uint32_t(1U) << 23U)) ? 6U : 4U;
+        }
+      }
+#endif
+
+      if (count_counters.has_value() && count_counters.value() > 1U && is_nmi_watchdog_enabled()) {
+        count_counters = count_counters.value() - 1U;
+      }
+
+      return count_counters;
+    }();
+
+    return count_counters;
+  }
+
+  /**
+   * @return Number of fixed performance counters (e.g., for instructions and cycles on Intel processors).
+   */
+  [[nodiscard]] static std::uint8_t count_fixed_counters()
+  {
+    static const auto count_counters = []() -> std::uint8_t {
+#if defined(__x86_64__) || defined(__i386__)
+      std::uint32_t eax, ebx, ecx, edx;
+
+      /// Fixed counters are reported in EDX[4:0] since version 2 of the architectural performance monitoring.
+      if (is_intel() && __get_cpuid_count(0x0A, 0, &eax, &ebx, &ecx, &edx) && (eax & 0xFFU) > 1U) {
+        return std::uint8_t(edx & 0x1FU);
+      }
+#endif
+      return 0U;
+    }();
+
+    return count_counters;
+  }
+
+  /**
+   * Returns the id of the fixed counter that can count the given event (Intel only): instructions (0),
+   * cycles (1), reference cycles (2), and topdown slots (3).
+   *
+   * @param type Type of the event.
+   * @param event_id Id (config) of the event.
+   * @return Id of the fixed counter, or std::nullopt if the event can only be counted by general purpose counters.
+   */
+  [[nodiscard]] static std::optional<std::uint8_t> fixed_counter_id(const std::uint32_t type,
+                                                                    const std::uint64_t event_id) noexcept
+  {
+    if (type == PERF_TYPE_HARDWARE) {
+      switch (event_id) {
+        case PERF_COUNT_HW_INSTRUCTIONS:
+          return 0U;
+        case PERF_COUNT_HW_CPU_CYCLES:
+          return 1U;
+        case PERF_COUNT_HW_REF_CPU_CYCLES:
+          return 2U;
+        default:
+          return std::nullopt;
+      }
+    }
+
+    if (type == PERF_TYPE_RAW && is_intel()) {
+      switch (event_id) {
+        case 0x00C0:
+          return 0U;
+        case 0x003C:
+          return 1U;
+        case 0x0300:
+          return 2U;
+        case 0x0400:
+          return 3U;
+        default:
+          return std::nullopt;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * @return True, if the underlying Intel processor exposes topdown metrics via the slots event (Ice Lake and newer).
+   */
+  [[nodiscard]] static bool is_intel_topdown_supported() { return is_intel() && is_core_pmu_event("topdown-retiring"); }
+
+  /**
+   * @return True, if the underlying Intel processor exposes level-2 topdown metrics (Sapphire Rapids and newer).
+   */
+  [[nodiscard]] static bool is_intel_topdown_level2_supported()
+  {
+    return is_intel() && is_core_pmu_event("topdown-heavy-ops");
+  }
+
+  /**
+   * @param type Type of the event.
+   * @param event_id Id (config) of the event.
+   * @return True, if the event is the topdown slots event (Intel), which has to lead the group of topdown metrics.
+   */
+  [[nodiscard]] static bool is_intel_topdown_slots(const std::uint32_t type, const std::uint64_t event_id) noexcept
+  {
+    return type == PERF_TYPE_RAW && event_id == 0x0400 && is_intel();
+  }
+
+  /**
+   * Topdown metric events (Intel) are no counters but report a fraction of the slots; they occupy no counter
+   * and can only be counted within a group led by the slots event.
+   *
+   * @param type Type of the event.
+   * @param event_id Id (config) of the event.
+   * @return True, if the event is a topdown metric event (e.g., topdown-retiring).
+   */
+  [[nodiscard]] static bool is_intel_topdown_metric(const std::uint32_t type, const std::uint64_t event_id) noexcept
+  {
+    return type == PERF_TYPE_RAW && event_id >= 0x8000 && event_id <= 0x8700 && (event_id & 0xFFU) == 0U &&
+           is_intel();
+  }
+
+  /**
+   * Returns the number of dispatch slots per cycle of AMD processors that provide the pipeline utilization events
+   * (de_no_dispatch_per_slot) used for topdown analysis: six on Zen 4 and eight on Zen 5.
+   *
+   * @return Number of dispatch slots, or std::nullopt if the processor does not support topdown analysis.
+   */
+  [[nodiscard]] static std::optional<std::uint8_t> amd_dispatch_slots() noexcept
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    if (is_amd()) {
+      std::uint32_t eax, ebx, ecx, edx;
+
+      if (__get_cpuid_count(0x01, 0, &eax, &ebx, &ecx, &edx)) {
+        const auto base_family = (eax >> 8U) & 0xFU;
+        const auto family = base_family == 0xFU ? base_family + ((eax >> 20U) & 0xFFU) : base_family;
+
+        /// Zen 5.
+        if (family >= 0x1AU) {
+          return 8U;
+        }
+
+        /// Zen 4 (unlike Zen 3, which belongs to the same family) supports performance monitoring v2.
+        if (family == 0x19U && __get_cpuid_count(0x80000022, 0, &eax, &ebx, &ecx, &edx) &&
+            static_cast<bool>(eax & 0x1U)) {
+          return 6U;
+        }
+      }
+    }
+#endif
+    return std::nullopt;
+  }
+
+  /**
+   * @return True, if the NMI watchdog is enabled and occupies a performance counter.
+   */
+  [[nodiscard]] static bool is_nmi_watchdog_enabled()
+  {
+    auto nmi_watchdog_stream = std::ifstream{ "/proc/sys/kernel/nmi_watchdog" };
+    if (nmi_watchdog_stream.is_open()) {
+      auto is_enabled = 0U;
+      nmi_watchdog_stream >> is_enabled;
+
+      return is_enabled > 0U;
+    }
+
+    return false;
+  }
+
   /**
    * @return The config type for IBS execution counter, if IBS is supported by the underlying hardware.
    */
@@ -110,5 +376,97 @@ public:
 
     return std::nullopt;
   }
+
+  /**
+   * Reads the ids of all online CPU cores from the sysfs (e.g., "0-3,6,8-11").
+   * Falls back to the ids 0 to std::thread::hardware_concurrency() - 1 if the list cannot be read.
+   *
+   * @return List of online CPU core ids.
+   */
+  [[nodiscard]] static std::vector<std::uint16_t> online_cpu_ids()
+  {
+    auto cpu_ids = read_cpu_ids("/sys/devices/system/cpu/online");
+    if (cpu_ids.empty()) {
+      cpu_ids.resize(std::max(std::thread::hardware_concurrency(), 1U));
+      std::iota(cpu_ids.begin(), cpu_ids.end(), 0U);
+    }
+
+    return cpu_ids;
+  }
+
+  /**
+   * Detects the core PMUs of hybrid processors from the sysfs (PMUs named "cpu_*" that serve a subset of the CPU
+   * cores, e.g., "cpu_core" and "cpu_atom"). The PMUs are detected once.
+   *
+   * @return List of core PMUs, sorted by name; empty if the processor is not hybrid.
+   */
+  [[nodiscard]] static const std::vector<HybridPmu>& hybrid_pmus()
+  {
+    static const auto hybrid_pmus = []() {
+      auto hybrid_pmus = std::vector<HybridPmu>{};
+
+      const auto pmu_event_parser = PmuEventParser{};
+      for (auto& pmu : pmu_event_parser.pmus()) {
+        if (pmu.rfind("cpu_", 0U) != 0U) {
+          continue;
+        }
+
+        const auto cpus_path = std::string{ pmu_event_parser.sysfs_root() }.append("/").append(pmu).append("/cpus");
+        auto cpu_ids = read_cpu_ids(cpus_path);
+        if (const auto type = pmu_event_parser.type(pmu); type.has_value() && !cpu_ids.empty()) {
+          hybrid_pmus.emplace_back(std::move(pmu), type.value(), std::move(cpu_ids));
+        }
+      }
+
+      return hybrid_pmus;
+    }();
+
+    return hybrid_pmus;
+  }
+
+  /**
+   * @return True, if the processor has multiple core PMUs (e.g., performance and efficiency cores).
+   */
+  [[nodiscard]] static bool is_hybrid() { return hybrid_pmus().size() > 1U; }
+
+private:
+  /**
+   * Reads a list of CPU core ids from the sysfs (e.g., "0-3,6,8-11").
+   *
+   * @param path Path of the file.
+   * @return List of CPU core ids, empty if the file cannot be read or parsed.
+   */
+  [[nodiscard]] static std::vector<std::uint16_t> read_cpu_ids(const std::string& path)
+  {
+    auto cpu_ids = std::vector<std::uint16_t>{};
+
+    auto stream = std::ifstream{ path };
+    auto range = std::string{};
+    while (stream.is_open() && std::getline(stream, range, ',')) {
+      try {
+        const auto separator = range.find('-');
+        const auto first = std::stoul(range.substr(0U, separator));
+        const auto last = separator != std::string::npos ? std::stoul(range.substr(separator + 1U)) : first;
+        for (auto cpu_id = first; cpu_id <= last; ++cpu_id) {
+          cpu_ids.emplace_back(static_cast<std::uint16_t>(cpu_id));
+        }
+      } catch (std::logic_error&) {
+        cpu_ids.clear();
+        break;
+      }
+    }
+
+    return cpu_ids;
+  }
+
+  /**
+   * @param event_name Name of the event.
+   * @return True, if the core PMU (or the performance core PMU of hybrid processors) exposes the given event.
+   */
+  [[nodiscard]] static bool is_core_pmu_event(const std::string& event_name)
+  {
+    return std::ifstream{ "/sys/bus/event_source/devices/cpu/events/" + event_name }.is_open() ||
+           std::ifstream{ "/sys/bus/event_source/devices/cpu_core/events/" + event_name }.is_open();
+  }
 };
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "counter.h"
+#include "event_counter.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace perf {
+/**
+ * Result of a single interval recorded by the IntervalReader.
+ */
+class IntervalResult
+{
+public:
+  IntervalResult(const std::chrono::nanoseconds time,
+                 const std::chrono::nanoseconds duration,
+                 CounterResult&& result) noexcept
+    : _time(time)
+    , _duration(duration)
+    , _result(std::move(result))
+  {
+  }
+  ~IntervalResult() = default;
+
+  /**
+   * @return Time at the end of the interval, relative to starting the reader.
+   */
+  [[nodiscard]] std::chrono::nanoseconds time() const noexcept { return _time; }
+
+  /**
+   * @return Duration of the interval.
+   */
+  [[nodiscard]] std::chrono::nanoseconds duration() const noexcept { return _duration; }
+
+  /**
+   * @return Counter and metric values of the interval.
+   */
+  [[nodiscard]] const CounterResult& result() const noexcept { return _result; }
+
+private:
+  std::chrono::nanoseconds _time;
+  std::chrono::nanoseconds _duration;
+  CounterResult _result;
+};
+
+/**
+ * Reads running event counters periodically from a background thread (comparable to "perf stat -I").
+ * The per-interval deltas are stored in a fixed-capacity, preallocated ring such that no allocation
+ * happens per interval; when the ring is full, the oldest intervals are overwritten.
+ * The reader neither starts nor stops the counters; they have to be started before starting the reader.
+ *
+ * The reader reads the raw values and times enabled/running of the counters' file descriptors into its own buffers
+ * (it never touches the results of the counters), and scales the difference of every interval by the share of the
+ * interval the counters were running. Reading is synchronized with opening and closing the counters, such that
+ * counters may be started, stopped, and (re-)opened while the reader runs: Values of re-opened counters count from
+ * zero, values between the last read and closing are not reported. Counters must not be added while the reader runs.
+ */
+class IntervalReader
+{
+public:
+  IntervalReader(EventCounter& event_counter, std::chrono::milliseconds interval, std::size_t capacity);
+  IntervalReader(MultiThreadEventCounter& event_counter, std::chrono::milliseconds interval, std::size_t capacity);
+  IntervalReader(MultiProcessEventCounter& event_counter, std::chrono::milliseconds interval, std::size_t capacity);
+  IntervalReader(MultiCoreEventCounter& event_counter, std::chrono::milliseconds interval, std::size_t capacity);
+
+  IntervalReader(const IntervalReader&) = delete;
+  IntervalReader& operator=(const IntervalReader&) = delete;
+
+  ~IntervalReader();
+
+  /**
+   * Starts the background thread that reads the counters every interval.
+   */
+  void start();
+
+  /**
+   * Stops the background thread.
+   */
+  void stop();
+
+  /**
+   * @return Number of intervals currently stored in the ring (at most the capacity).
+   */
+  [[nodiscard]] std::size_t size() const;
+
+  /**
+   * @return Number of intervals that were overwritten since the ring was full.
+   */
+  [[nodiscard]] std::uint64_t count_overwritten() const;
+
+  /**
+   * Returns the result of a stored interval, including evaluated metrics.
+   *
+   * @param index Index of the interval, 0 is the oldest stored interval.
+   * @param normalization Normalization value, default = 1.
+   * @return Result of the interval.
+   */
+  [[nodiscard]] IntervalResult result(std::size_t index, std::uint64_t normalization = 1U) const;
+
+  /**
+   * @return Results of all stored intervals, ordered from oldest to newest.
+   */
+  [[nodiscard]] std::vector<IntervalResult> result() const;
+
+private:
+  /// Event counters to read; the first one defines the counters and metrics.
+  std::vector<EventCounter*> _event_counters;
+
+  /// Time between two reads.
+  std::chrono::milliseconds _interval;
+
+  /// Maximal number of intervals stored in the ring.
+  std::size_t _capacity;
+
+  /// Number of (hidden and visible) counters per interval.
+  std::size_t _count_counters;
+
+  /// Ring of counter values (capacity x counters).
+  std::vector<double> _values;
+
+  /// Ring of timestamps (end of interval, relative to the start of the reader) and durations.
+  std::vector<std::chrono::nanoseconds> _times;
+  std::vector<std::chrono::nanoseconds> _durations;
+
+  /// Number of intervals written since starting the reader.
+  std::uint64_t _count_intervals{ 0U };
+
+  /// Index of the first group of every event counter within the buffers of the reads.
+  std::vector<std::size_t> _first_group_ids;
+
+  /// Raw values of all groups of the previous and current read, used to calculate deltas.
+  std::vector<Group::Counts> _previous_counts;
+  std::vector<Group::Counts> _current_counts;
+
+  /// Open generation of the event counter per group of the previous and current read (0 = not opened), used to detect
+  /// counters that were re-opened between two reads.
+  std::vector<std::uint64_t> _previous_generations;
+  std::vector<std::uint64_t> _current_generations;
+
+  /// Synchronization between the background thread and readers of the ring.
+  mutable std::mutex _mutex;
+  std::condition_variable _stop_condition;
+  bool _is_stop_requested{ false };
+
+  std::thread _reader_thread;
+
+  IntervalReader(std::vector<EventCounter*>&& event_counters, std::chrono::milliseconds interval, std::size_t capacity);
+
+  /**
+   * Reads the raw values of all groups into the buffers of the current read. Groups that cannot be read keep the
+   * values of the previous read.
+   */
+  void read();
+
+  /**
+   * Loop of the background thread.
+   */
+  void run();
+};
+}
@@ -12,6 +12,27 @@ public:
   [[nodiscard]] virtual std::string name() const = 0;
   [[nodiscard]] virtual std::vector<std::string> required_counter_names() const = 0;
   [[nodiscard]] virtual std::optional<double> calculate(const CounterResult& result) const = 0;
+
+  /**
+   * Calculates the metric from the values of the required counters, ordered like required_counter_names().
+   * Used when evaluating results into a CounterResultView. The default implementation looks up the values by
+   * name (via calculate()); metrics evaluated at high rates should override it.
+   *
+   * @param values Values of the required counters.
+   * @return The value of the metric, or std::nullopt if it cannot be calculated.
+   */
+  [[nodiscard]] virtual std::optional<double> calculate_from_values(const std::vector<double>& values) const
+  {
+    const auto counter_names = this->required_counter_names();
+
+    auto counter_values = std::vector<std::pair<std::string_view, double>>{};
+    counter_values.reserve(counter_names.size());
+    for (auto counter_id = 0U; counter_id < counter_names.size() && counter_id < values.size(); ++counter_id) {
+      counter_values.emplace_back(counter_names[counter_id], values[counter_id]);
+    }
+
+    return this->calculate(CounterResult{ std::move(counter_values) });
+  }
 };
 
 class CyclesPerInstruction final : public Metric
@@ -33,6 +54,11 @@ public:
 
     return std::nullopt;
   }
+
+  [[nodiscard]] std::optional<double> calculate_from_values(const std::vector<double>& values) const override
+  {
+    return values[0] / values[1];
+  }
 };
 
 class CacheHitRatio final : public Metric
@@ -54,6 +80,11 @@ public:
 
     return std::nullopt;
   }
+
+  [[nodiscard]] std::optional<double> calculate_from_values(const std::vector<double>& values) const override
+  {
+    return values[1] / values[0];
+  }
 };
 
 class DTLBMissRatio final : public Metric
@@ -75,6 +106,11 @@ public:
 
     return std::nullopt;
   }
+
+  [[nodiscard]] std::optional<double> calculate_from_values(const std::vector<double>& values) const override
+  {
+    return values[1] / values[0];
+  }
 };
 
 class ITLBMissRatio final : public Metric
@@ -96,6 +132,11 @@ public:
 
     return std::nullopt;
   }
+
+  [[nodiscard]] std::optional<double> calculate_from_values(const std::vector<double>& values) const override
+  {
+    return values[1] / values[0];
+  }
 };
 
 class L1DataMissRatio final : public Metric
@@ -117,5 +158,10 @@ public:
 
     return std::nullopt;
   }
+
+  [[nodiscard]] std::optional<double> calculate_from_values(const std::vector<double>& values) const override
+  {
+    return values[1] / values[0];
+  }
 };
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "counter.h"
+#include "metric.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace perf {
+/**
+ * Metric defined by an arithmetic expression over counters, e.g., "cycles / instructions".
+ * The expression is compiled into a small bytecode for a stack machine once; evaluating the metric
+ * runs the bytecode without virtual calls, allocations, or name lookups.
+ *
+ * Supported syntax:
+ *  - Counter names (may contain '-', '.', and ':'; binary minus must therefore be surrounded by spaces),
+ *  - numeric constants (e.g., 4, 0.5, 1e9),
+ *  - the operators +, -, *, / (with the usual precedence), unary minus, and parentheses,
+ *  - the functions min(a, b), max(a, b), and if_zero(value, then, else) which results in then if
+ *    value is zero and else otherwise (e.g., "if_zero(instructions, 0, cycles / instructions)").
+ */
+class MetricExpression final : public Metric
+{
+public:
+  /// Maximal depth of the evaluation stack.
+  constexpr static inline auto MAX_STACK_SIZE = 32U;
+
+  enum class Operation : std::uint8_t
+  {
+    Constant,
+    Counter,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate,
+    Min,
+    Max,
+    IfZero
+  };
+
+  class Instruction
+  {
+  public:
+    explicit Instruction(const Operation operation) noexcept
+      : _operation(operation)
+    {
+    }
+    Instruction(const Operation operation, const double constant) noexcept
+      : _operation(operation)
+      , _constant(constant)
+    {
+    }
+    Instruction(const Operation operation, const std::uint16_t counter_id) noexcept
+      : _operation(operation)
+      , _counter_id(counter_id)
+    {
+    }
+    ~Instruction() noexcept = default;
+
+    [[nodiscard]] Operation operation() const noexcept { return _operation; }
+    [[nodiscard]] double constant() const noexcept { return _constant; }
+    [[nodiscard]] std::uint16_t counter_id() const noexcept { return _counter_id; }
+
+  private:
+    Operation _operation;
+    double _constant{ .0 };
+
+    /// Index of the counter within the required counters.
+    std::uint16_t _counter_id{ 0U };
+  };
+
+  /**
+   * Compiles the given expression. Throws an exception if the expression is malformed.
+   *
+   * @param name Name of the metric.
+   * @param expression Expression to calculate the metric.
+   */
+  MetricExpression(std::string&& name, std::string_view expression);
+  ~MetricExpression() override = default;
+
+  [[nodiscard]] std::string name() const override { return _name; }
+  [[nodiscard]] std::vector<std::string> required_counter_names() const override { return _counter_names; }
+  [[nodiscard]] std::optional<double> calculate(const CounterResult& result) const override;
+  [[nodiscard]] std::optional<double> calculate_from_values(const std::vector<double>& values) const override
+  {
+    return this->evaluate([&values](const std::uint16_t counter_id) { return values[counter_id]; });
+  }
+
+  /**
+   * @return The expression the metric was compiled from.
+   */
+  [[nodiscard]] const std::string& expression() const noexcept { return _expression; }
+
+  /**
+   * @return The compiled bytecode.
+   */
+  [[nodiscard]] const std::vector<Instruction>& instructions() const noexcept { return _instructions; }
+
+  /**
+   * Evaluates the compiled expression.
+   *
+   * @param counter_value Callback returning the value of a required counter, given its index within
+   *  required_counter_names().
+   * @return The value of the metric.
+   */
+  template<typename F>
+  [[nodiscard]] double evaluate(F&& counter_value) const noexcept
+  {
+    auto stack = std::array<double, MAX_STACK_SIZE>{};
+    auto top = 0U;
+
+    for (const auto& instruction : this->_instructions) {
+      switch (instruction.operation()) {
+        case Operation::Constant:
+          stack[top++] = instruction.constant();
+          break;
+        case Operation::Counter:
+          stack[top++] = counter_value(instruction.counter_id());
+          break;
+        case Operation::Add:
+          --top;
+          stack[top - 1U] += stack[top];
+          break;
+        case Operation::Subtract:
+          --top;
+          stack[top - 1U] -= stack[top];
+          break;
+        case Operation::Multiply:
+          --top;
+          stack[top - 1U] *= stack[top];
+          break;
+        case Operation::Divide:
+          --top;
+          stack[top - 1U] /= stack[top];
+          break;
+        case Operation::Negate:
+          stack[top - 1U] = -stack[top - 1U];
+          break;
+        case Operation::Min:
+          --top;
+          stack[top - 1U] = std::min(stack[top - 1U], stack[top]);
+          break;
+        case Operation::Max:
+          --top;
+          stack[top - 1U] = std::max(stack[top - 1U], stack[top]);
+          break;
+        case Operation::IfZero:
+          top -= 2U;
+          stack[top - 1U] = stack[top - 1U] == .0 ? stack[top] : stack[top + 1U];
+          break;
+      }
+    }
+
+    return top == 1U ? stack[0U] : std::numeric_limits<double>::quiet_NaN();
+  }
+
+private:
+  std::string _name;
+  std::string _expression;
+
+  /// Names of the counters the expression refers to, in order of their first occurrence.
+  std::vector<std::string> _counter_names;
+
+  /// Bytecode in postfix order.
+  std::vector<Instruction> _instructions;
+};
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace perf {
+/**
+ * The multiplexing policy controls how counter values are reported whose group was scheduled on the PMU
+ * for less than the configured fraction of time (see Config::min_running_ratio()).
+ */
+enum MultiplexingPolicy : std::uint8_t
+{
+  /// Report the (extrapolated) values, but flag them as below the threshold.
+  Flag = 0U,
+
+  /// Omit the values from the results (metrics depending on them are omitted, too).
+  Refuse = 1U,
+};
+
+/**
+ * Multiplexing details of a counter value: The value that was counted (raw) and the time the counter was
+ * enabled and running on the PMU. When the counter was running only for a fraction of the time it was enabled,
+ * the reported (scaled) value is extrapolated by time_enabled / time_running.
+ */
+class Multiplexing
+{
+public:
+  Multiplexing() noexcept = default;
+  Multiplexing(const double raw_value, const std::uint64_t time_enabled, const std::uint64_t time_running) noexcept
+    : _raw_value(raw_value)
+    , _time_enabled(time_enabled)
+    , _time_running(time_running)
+  {
+  }
+  ~Multiplexing() noexcept = default;
+
+  Multiplexing& operator+=(const Multiplexing& other) noexcept
+  {
+    _scaled_value_sum = scaled_value() + other.scaled_value();
+    _raw_value += other._raw_value;
+    _time_enabled += other._time_enabled;
+    _time_running += other._time_running;
+    _is_below_threshold |= other._is_below_threshold;
+    _is_aggregated = true;
+    return *this;
+  }
+
+  /**
+   * @return The value that was actually counted, not extrapolated (and not normalized).
+   */
+  [[nodiscard]] double raw_value() const noexcept { return _raw_value; }
+
+  /**
+   * @return The value extrapolated by time_enabled / time_running (not normalized).
+   */
+  [[nodiscard]] double scaled_value() const noexcept
+  {
+    if (_is_aggregated) {
+      return _scaled_value_sum;
+    }
+
+    return _time_running > 0U ? _raw_value * (double(_time_enabled) / double(_time_running)) : _raw_value;
+  }
+
+  /**
+   * @return Time (in nanoseconds) the counter was enabled.
+   */
+  [[nodiscard]] std::uint64_t time_enabled() const noexcept { return _time_enabled; }
+
+  /**
+   * @return Time (in nanoseconds) the counter was running on the PMU.
+   */
+  [[nodiscard]] std::uint64_t time_running() const noexcept { return _time_running; }
+
+  /**
+   * @return Fraction of the enabled time the counter was running on the PMU (1.0 if the counter was never enabled).
+   */
+  [[nodiscard]] double running_ratio() const noexcept
+  {
+    return _time_enabled > 0U ? double(_time_running) / double(_time_enabled) : 1.0;
+  }
+
+  /**
+   * @return True, if the counter was not running during the entire enabled time.
+   */
+  [[nodiscard]] bool is_multiplexed() const noexcept { return _time_running < _time_enabled; }
+
+  /**
+   * Estimates the standard error of the scaled value, assuming the events are spread uniformly over the enabled
+   * time and the running time is a random fraction of it. Phase changes of the workload are not covered; the
+   * estimate is a lower bound for the real error.
+   *
+   * @return Estimated standard error of the scaled value (0 if the counter was not multiplexed).
+   */
+  [[nodiscard]] double standard_error() const noexcept
+  {
+    const auto ratio = running_ratio();
+    if (ratio >= 1.0) {
+      return .0;
+    }
+
+    /// A counter that was never running may have any value.
+    if (ratio <= .0) {
+      return INFINITY;
+    }
+
+    /// Variance of the extrapolated count N' = n / r with n ~ Binomial(N, r): N * (1 - r) / r.
+    return std::sqrt(scaled_value() * (1.0 - ratio) / ratio);
+  }
+
+  /**
+   * @return Estimated standard error relative to the scaled value.
+   */
+  [[nodiscard]] double relative_error() const noexcept
+  {
+    const auto value = scaled_value();
+    return value > .0 ? standard_error() / value : standard_error();
+  }
+
+  /**
+   * @return True, if the running ratio is below the configured threshold (see Config::min_running_ratio()).
+   */
+  [[nodiscard]] bool is_below_threshold() const noexcept { return _is_below_threshold; }
+
+  void is_below_threshold(const bool is_below_threshold) noexcept { _is_below_threshold = is_below_threshold; }
+
+private:
+  double _raw_value{ .0 };
+  double _scaled_value_sum{ .0 };
+  std::uint64_t _time_enabled{ 0U };
+  std::uint64_t _time_running{ 0U };
+  bool _is_below_threshold{ false };
+
+  /// Flag if the multiplexing details were summed up (e.g., over threads or cores); the scaled value is then
+  /// the sum of the individually scaled values.
+  bool _is_aggregated{ false };
+};
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Flat hash table mapping names to values, used to look up counters and metrics by name without allocating.
+ *
+ * Entries are stored densely (in insertion order) and referenced by an open-addressing (linear probing) slot array,
+ * where each slot packs the index of the entry and the upper half of its hash. Names are interned into chunks
+ * that are never moved or freed while the table lives: string_views to names remain valid when the table grows
+ * or is moved.
+ */
+template<typename T>
+class NameTable
+{
+public:
+  using value_type = std::pair<std::string_view, T>;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  NameTable() = default;
+  NameTable(NameTable&&) noexcept = default;
+  NameTable& operator=(NameTable&&) noexcept = default;
+  NameTable(const NameTable&) = delete;
+  NameTable& operator=(const NameTable&) = delete;
+  ~NameTable() = default;
+
+  /**
+   * Reserves space for the given number of entries, such that inserting them will not rehash.
+   *
+   * @param count_entries Number of entries.
+   */
+  void reserve(const std::size_t count_entries)
+  {
+    _entries.reserve(count_entries);
+    if (count_entries * 4U > _slots.size() * 3U) {
+      this->rehash(count_entries * 4U / 3U + 1U);
+    }
+  }
+
+  /**
+   * Inserts the value, unless the table already contains the name.
+   *
+   * @param name Name of the value (copied into the table).
+   * @param value Value to insert.
+   * @return Pointer to the inserted or already contained entry, and true if the value was inserted.
+   */
+  std::pair<const value_type*, bool> insert(const std::string_view name, T&& value)
+  {
+    const auto hash = NameTable::hash(name);
+    if (auto* entry = this->find(name, hash); entry != nullptr) {
+      return std::make_pair(entry, false);
+    }
+
+    /// Keep the load factor at or below 0.75 and grow the entries by 1.5x (instead of doubling) to limit unused memory.
+    if ((_entries.size() + 1U) * 4U > _slots.size() * 3U) {
+      this->rehash(_slots.size() * 2U);
+    }
+    if (_entries.size() == _entries.capacity()) {
+      _entries.reserve(std::max(std::size_t{ 16U }, _entries.size() + _entries.size() / 2U));
+    }
+
+    _entries.emplace_back(this->intern(name), std::move(value));
+    this->place(std::uint32_t(_entries.size()), hash);
+
+    return std::make_pair(&_entries.back(), true);
+  }
+
+  /**
+   * Looks up a name. The returned pointer is valid until the next insertion; the name it points to remains valid
+   * as long as the table.
+   *
+   * @param name Name to look up.
+   * @return Pointer to the entry, or nullptr if the table does not contain the name.
+   */
+  [[nodiscard]] const value_type* find(const std::string_view name) const noexcept
+  {
+    return this->find(name, NameTable::hash(name));
+  }
+
+  [[nodiscard]] bool contains(const std::string_view name) const noexcept { return this->find(name) != nullptr; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return _entries.size(); }
+  [[nodiscard]] bool empty() const noexcept { return _entries.empty(); }
+
+  [[nodiscard]] const_iterator begin() const noexcept { return _entries.begin(); }
+  [[nodiscard]] const_iterator end() const noexcept { return _entries.end(); }
+
+  /**
+   * @return Number of bytes allocated by the table (entries, slots, and interned names, not including memory owned
+   * by the values).
+   */
+  [[nodiscard]] std::size_t memory_usage() const noexcept
+  {
+    return _entries.capacity() * sizeof(value_type) + _slots.capacity() * sizeof(std::uint64_t) +
+           _name_chunks.capacity() * sizeof(std::unique_ptr<char[]>) + _name_chunk_bytes;
+  }
+
+private:
+  /// Size of the chunks interned names are stored in (longer names get a chunk of their own).
+  constexpr static inline auto NAME_CHUNK_SIZE = std::size_t{ 4096U };
+
+  /// Mask of the entry index within a slot (the upper half holds the upper half of the hash).
+  constexpr static inline auto INDEX_MASK = std::uint64_t{ 0xFFFFFFFFULL };
+
+  /// Entries in insertion order.
+  std::vector<value_type> _entries;
+
+  /// Slots of the hash table (0 = empty, otherwise the upper half of the hash and the index of the entry + 1).
+  std::vector<std::uint64_t> _slots;
+
+  /// Chunks holding the interned names, the used bytes of the current chunk, and the bytes of all chunks.
+  std::vector<std::unique_ptr<char[]>> _name_chunks;
+  std::size_t _name_chunk_used{ NAME_CHUNK_SIZE };
+  std::size_t _name_chunk_bytes{ 0U };
+
+  /**
+   * FNV-1a hash, mixed by the finalizer of MurmurHash3 such that the upper and lower bits are usable.
+   *
+   * @param name Name to hash.
+   * @return Hash of the name.
+   */
+  [[nodiscard]] static std::uint64_t hash(const std::string_view name) noexcept
+  {
+    auto hash = std::uint64_t{ 0xcbf29ce484222325ULL };
+    for (const auto character : name) {
+      hash = (hash ^ std::uint8_t(character)) * 0x100000001b3ULL;
+    }
+
+    hash ^= hash >> 33U;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33U;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33U;
+
+    return hash;
+  }
+
+  [[nodiscard]] const value_type* find(const std::string_view name, const std::uint64_t hash) const noexcept
+  {
+    if (_slots.empty()) {
+      return nullptr;
+    }
+
+    const auto mask = _slots.size() - 1U;
+    const auto tag = hash & ~INDEX_MASK;
+    for (auto slot_id = std::size_t(hash) & mask;; slot_id = (slot_id + 1U) & mask) {
+      const auto slot = _slots[slot_id];
+      if (slot == 0U) {
+        return nullptr;
+      }
+
+      if ((slot & ~INDEX_MASK) == tag) {
+        const auto& entry = _entries[(slot & INDEX_MASK) - 1U];
+        if (entry.first == name) {
+          return &entry;
+        }
+      }
+    }
+  }
+
+  /**
+   * Places an entry into the first free slot of its probe sequence.
+   *
+   * @param entry_index Index of the entry + 1.
+   * @param hash Hash of the name of the entry.
+   */
+  void place(const std::uint32_t entry_index, const std::uint64_t hash) noexcept
+  {
+    const auto mask = _slots.size() - 1U;
+    auto slot_id = std::size_t(hash) & mask;
+    while (_slots[slot_id] != 0U) {
+      slot_id = (slot_id + 1U) & mask;
+    }
+
+    _slots[slot_id] = (hash & ~INDEX_MASK) | entry_index;
+  }
+
+  /**
+   * Resizes the slot array to (at least) the given number of slots (a power of two) and re-places all entries.
+   *
+   * @param count_slots Minimal number of slots.
+   */
+  void rehash(const std::size_t count_slots)
+  {
+    auto size = std::size_t{ 16U };
+    while (size < count_slots) {
+      size <<= 1U;
+    }
+
+    _slots.assign(size, 0U);
+    for (auto entry_id = std::size_t{ 0U }; entry_id < _entries.size(); ++entry_id) {
+      this->place(std::uint32_t(entry_id + 1U), NameTable::hash(_entries[entry_id].first));
+    }
+  }
+
+  /**
+   * Copies the name into the current chunk (or a new one).
+   *
+   * @param name Name to intern.
+   * @return View on the interned name.
+   */
+  [[nodiscard]] std::string_view intern(const std::string_view name)
+  {
+    if (name.empty()) {
+      return std::string_view{};
+    }
+
+    if (_name_chunk_used + name.size() > NAME_CHUNK_SIZE) {
+      const auto chunk_size = std::max(NAME_CHUNK_SIZE, name.size());
+      _name_chunks.emplace_back(std::make_unique<char[]>(chunk_size));
+      _name_chunk_bytes += chunk_size;
+      _name_chunk_used = 0U;
+    }
+
+    auto* interned_name = _name_chunks.back().get() + _name_chunk_used;
+    std::memcpy(interned_name, name.data(), name.size());
+    _name_chunk_used += name.size();
+
+    return std::string_view{ interned_name, name.size() };
+  }
+};
+}
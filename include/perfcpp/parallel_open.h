@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace perf {
+/**
+ * Duration of the phases when opening counters or samplers on multiple CPU cores.
+ */
+class OpenTiming
+{
+public:
+  OpenTiming() noexcept = default;
+  OpenTiming(const std::chrono::nanoseconds first_core,
+             const std::chrono::nanoseconds remaining_cores,
+             const std::uint16_t count_threads) noexcept
+    : _first_core(first_core)
+    , _remaining_cores(remaining_cores)
+    , _count_threads(count_threads)
+  {
+  }
+  ~OpenTiming() noexcept = default;
+
+  /**
+   * @return Time to open the first core, which resolves the event attributes (e.g., the supported precise_ip).
+   */
+  [[nodiscard]] std::chrono::nanoseconds first_core() const noexcept { return _first_core; }
+
+  /**
+   * @return Time to open all remaining cores in parallel, reusing the resolved event attributes.
+   */
+  [[nodiscard]] std::chrono::nanoseconds remaining_cores() const noexcept { return _remaining_cores; }
+
+  /**
+   * @return Total time to open all cores.
+   */
+  [[nodiscard]] std::chrono::nanoseconds total() const noexcept { return _first_core + _remaining_cores; }
+
+  /**
+   * @return Number of threads that opened the remaining cores.
+   */
+  [[nodiscard]] std::uint16_t count_threads() const noexcept { return _count_threads; }
+
+private:
+  std::chrono::nanoseconds _first_core{ 0U };
+  std::chrono::nanoseconds _remaining_cores{ 0U };
+  std::uint16_t _count_threads{ 0U };
+};
+
+/**
+ * Opens counters or samplers of multiple CPU cores in parallel.
+ */
+class ParallelOpen
+{
+public:
+  /**
+   * Opens the first item on the calling thread and all remaining items in parallel on a small pool of threads.
+   * Exceptions thrown when opening an item are re-thrown on the calling thread after all threads finished.
+   *
+   * @param count_items Number of items to open.
+   * @param max_threads Maximal number of threads opening the remaining items.
+   * @param open_first Callback to open the first item.
+   * @param open_item Callback to open a remaining item (called with the index of the item).
+   * @return Duration of the phases.
+   */
+  template<typename FirstCallback, typename Callback>
+  static OpenTiming open(const std::size_t count_items,
+                         const std::uint16_t max_threads,
+                         FirstCallback&& open_first,
+                         Callback&& open_item)
+  {
+    if (count_items == 0U) {
+      return OpenTiming{};
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    open_first();
+    const auto first_core_opened = std::chrono::steady_clock::now();
+
+    const auto count_threads =
+      std::uint16_t(std::min<std::size_t>(std::max<std::uint16_t>(max_threads, 1U), count_items - 1U));
+    if (count_threads <= 1U) {
+      for (auto item_id = std::size_t{ 1U }; item_id < count_items; ++item_id) {
+        open_item(item_id);
+      }
+    } else {
+      auto next_item_id = std::atomic<std::size_t>{ 1U };
+      auto exceptions = std::vector<std::exception_ptr>(count_threads);
+      auto threads = std::vector<std::thread>{};
+      threads.reserve(count_threads);
+
+      for (auto thread_id = 0U; thread_id < count_threads; ++thread_id) {
+        threads.emplace_back([&next_item_id, &exceptions, &open_item, count_items, thread_id]() {
+          try {
+            auto item_id = next_item_id.fetch_add(1U);
+            while (item_id < count_items) {
+              open_item(item_id);
+              item_id = next_item_id.fetch_add(1U);
+            }
+          } catch (...) {
+            exceptions[thread_id] = std::current_exception();
+          }
+        });
+      }
+
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      for (auto& exception : exceptions) {
+        if (exception != nullptr) {
+          std::rethrow_exception(exception);
+        }
+      }
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    return OpenTiming{ std::chrono::duration_cast<std::chrono::nanoseconds>(first_core_opened - start),
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(end - first_core_opened),
+                       count_threads };
+  }
+};
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "counter.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace perf {
+/**
+ * Read-only index of the core events of a pmu-events catalog (the JSON format of the Linux kernel, see
+ * tools/perf/pmu-events/arch/<arch>/<microarchitecture>/<file>.json), compiled once into a compact binary file.
+ * The file is mapped into memory instead of being read, and names are looked up via a minimal perfect hash
+ * (hash and displace): opening the index costs a single mmap, a lookup hashes the name twice and compares it
+ * once, independent of the number of events. Names are matched case-insensitively.
+ *
+ * Layout of the file (native byte order):
+ *  - Header (magic, version, number of events and buckets),
+ *  - displacement seed per bucket (std::uint32_t),
+ *  - entry per event, placed at the slot of its perfect hash (name offset and length, type, config fields),
+ *  - names (lowercase, not null-terminated).
+ */
+class PmuEventIndex
+{
+public:
+  /**
+   * Maps the given index file. Throws an exception if the file cannot be mapped or is no valid index.
+   *
+   * @param index_file Path to the index file (see compile()).
+   */
+  explicit PmuEventIndex(const std::string& index_file);
+
+  PmuEventIndex(PmuEventIndex&& other) noexcept;
+  PmuEventIndex& operator=(PmuEventIndex&& other) noexcept;
+  PmuEventIndex(const PmuEventIndex&) = delete;
+  PmuEventIndex& operator=(const PmuEventIndex&) = delete;
+
+  ~PmuEventIndex();
+
+  /**
+   * Compiles the core events of a pmu-events catalog into an index file.
+   * Events of uncore units and metrics are skipped; events occurring multiple times are added once.
+   * On hybrid processors, the events of the performance cores ("cpu_core") are indexed with the dynamic type of
+   * their PMU; events of the efficiency cores ("cpu_atom") are skipped.
+   * Throws an exception if a JSON file is malformed or the index cannot be written.
+   *
+   * @param json_path A pmu-events JSON file or a directory containing JSON files (e.g., of one microarchitecture).
+   * @param index_file Path of the index file to write.
+   * @return Number of events in the index.
+   */
+  static std::size_t compile(const std::string& json_path, const std::string& index_file);
+
+  /**
+   * Maps the index file, compiling it first if it does not exist, is not valid, or is older than any of the JSON
+   * files.
+   *
+   * @param json_path A pmu-events JSON file or a directory containing JSON files.
+   * @param index_file Path of the index file.
+   * @return The mapped index.
+   */
+  [[nodiscard]] static PmuEventIndex open_or_compile(const std::string& json_path, const std::string& index_file);
+
+  /**
+   * Looks up an event by name (without allocating).
+   *
+   * @param name Name of the event (e.g., "inst_retired.any").
+   * @return Configuration of the event, or std::nullopt if the index does not contain the event.
+   */
+  [[nodiscard]] std::optional<CounterConfig> find(std::string_view name) const noexcept;
+
+  /**
+   * @return Number of events in the index.
+   */
+  [[nodiscard]] std::uint32_t size() const noexcept { return _data != nullptr ? file_header().count_events : 0U; }
+
+  /**
+   * @param slot Slot of the event (between 0 and size()).
+   * @return Name of the event at the slot (lowercase).
+   */
+  [[nodiscard]] std::string_view name(const std::uint32_t slot) const noexcept { return name(entries()[slot]); }
+
+private:
+  /// Magic number of the index file ("PCPPEVT" and version).
+  constexpr static inline auto MAGIC = std::uint64_t{ 0x3154564550504350ULL };
+
+  struct header
+  {
+    std::uint64_t magic;
+    std::uint32_t count_events;
+    std::uint32_t count_buckets;
+    std::uint64_t size;
+  };
+
+  struct entry
+  {
+    std::uint32_t name_offset;
+    std::uint32_t name_length;
+    std::uint32_t type;
+    std::uint32_t reserved;
+    std::array<std::uint64_t, 3U> config;
+  };
+
+  /// Mapped file.
+  const std::uint8_t* _data{ nullptr };
+  std::size_t _size{ 0U };
+
+  [[nodiscard]] const header& file_header() const noexcept { return *reinterpret_cast<const header*>(_data); }
+  [[nodiscard]] const std::uint32_t* seeds() const noexcept
+  {
+    return reinterpret_cast<const std::uint32_t*>(_data + sizeof(header));
+  }
+  [[nodiscard]] const entry* entries() const noexcept
+  {
+    return reinterpret_cast<const entry*>(_data + PmuEventIndex::entries_offset(file_header().count_buckets));
+  }
+  [[nodiscard]] const char* names() const noexcept
+  {
+    return reinterpret_cast<const char*>(_data + PmuEventIndex::entries_offset(file_header().count_buckets) +
+                                         sizeof(entry) * file_header().count_events);
+  }
+
+  /**
+   * Returns the name of an entry. The name region is validated on every access (instead of validating all entries
+   * when opening the index), such that a corrupted entry cannot point outside the mapped file.
+   *
+   * @param event Entry of the event.
+   * @return Name of the event, or an empty name if the entry points outside the file.
+   */
+  [[nodiscard]] std::string_view name(const entry& event) const noexcept
+  {
+    const auto names_size = static_cast<std::uint64_t>(_data + _size - reinterpret_cast<const std::uint8_t*>(names()));
+    if (std::uint64_t{ event.name_offset } + event.name_length > names_size) {
+      return std::string_view{};
+    }
+
+    return std::string_view{ names() + event.name_offset, event.name_length };
+  }
+
+  /**
+   * @param count_buckets Number of buckets.
+   * @return Offset of the entries within the file (aligned to 8 bytes).
+   */
+  [[nodiscard]] static std::size_t entries_offset(const std::uint32_t count_buckets) noexcept
+  {
+    return (sizeof(header) + sizeof(std::uint32_t) * count_buckets + 7U) & ~std::size_t{ 7U };
+  }
+
+  /**
+   * Hashes a name case-insensitively.
+   *
+   * @param name Name to hash.
+   * @param seed Seed of the hash function.
+   * @return Hash of the name.
+   */
+  [[nodiscard]] static std::uint64_t hash(std::string_view name, std::uint64_t seed) noexcept;
+
+  /**
+   * Unmaps the file.
+   */
+  void unmap() noexcept;
+};
+}
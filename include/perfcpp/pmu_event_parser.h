@@ -0,0 +1,133 @@
+#pragma once
+
+#include "counter.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Resolves event strings in the format of the Linux perf tool to counter configurations, based on the event aliases
+ * (".../<pmu>/events/<event>") and formats (".../<pmu>/format/<term>") that PMUs expose in the sysfs.
+ *
+ * Supported event strings:
+ *  - Terms of the PMU format, e.g., "cpu/event=0x3c,umask=0x1,cmask=1/"; terms without value are set to 1
+ *    (e.g., "edge"),
+ *  - event aliases, e.g., "cpu/mem-loads/" (which can be combined with further terms, e.g.,
+ *    "cpu/mem-loads,ldlat=30/"),
+ *  - the raw fields "config", "config1", and "config2", as well as "period".
+ */
+class PmuEventParser
+{
+public:
+  /// Default location of the PMUs in the sysfs.
+  constexpr static inline auto DEFAULT_SYSFS_ROOT = std::string_view{ "/sys/bus/event_source/devices" };
+
+  /**
+   * @param sysfs_root Directory containing one sub-directory per PMU (e.g., a fake tree for testing).
+   */
+  explicit PmuEventParser(std::string sysfs_root = std::string{ DEFAULT_SYSFS_ROOT })
+    : _sysfs_root(std::move(sysfs_root))
+  {
+  }
+  ~PmuEventParser() = default;
+
+  /**
+   * @return Directory containing the PMUs.
+   */
+  [[nodiscard]] const std::string& sysfs_root() const noexcept { return _sysfs_root; }
+
+  /**
+   * Resolves the given event string to a counter configuration.
+   * Throws an exception if the PMU does not exist or the event string is malformed.
+   *
+   * @param event Event string, e.g., "cpu/event=0x3c,umask=0x1/".
+   * @return Configuration of the event.
+   */
+  [[nodiscard]] CounterConfig parse(std::string_view event) const;
+
+  /**
+   * @return Names of all PMUs.
+   */
+  [[nodiscard]] std::vector<std::string> pmus() const;
+
+  /**
+   * @param pmu Name of the PMU.
+   * @return Names of all event aliases of the PMU (without their .scale/.unit/... attributes).
+   */
+  [[nodiscard]] std::vector<std::string> events(std::string_view pmu) const;
+
+  /**
+   * Reads the dynamic type of the given PMU.
+   *
+   * @param pmu Name of the PMU.
+   * @return The type to use for perf_event_attr::type, or std::nullopt if the PMU does not exist.
+   */
+  [[nodiscard]] std::optional<std::uint32_t> type(std::string_view pmu) const;
+
+private:
+  /**
+   * Placement of a format term within the perf_event_attr: The config field (0 = config, 1 = config1, 2 = config2)
+   * and the bit ranges (first and last bit, inclusive), filled with the value from the lowest bits on.
+   */
+  class Format
+  {
+  public:
+    Format(const std::uint8_t field, std::vector<std::pair<std::uint8_t, std::uint8_t>>&& bit_ranges) noexcept
+      : _field(field)
+      , _bit_ranges(std::move(bit_ranges))
+    {
+    }
+    ~Format() = default;
+
+    [[nodiscard]] std::uint8_t field() const noexcept { return _field; }
+    [[nodiscard]] const std::vector<std::pair<std::uint8_t, std::uint8_t>>& bit_ranges() const noexcept
+    {
+      return _bit_ranges;
+    }
+
+  private:
+    std::uint8_t _field;
+    std::vector<std::pair<std::uint8_t, std::uint8_t>> _bit_ranges;
+  };
+
+  std::string _sysfs_root;
+
+  /**
+   * Reads the format of a term of the given PMU (e.g., "config:0-7,21").
+   *
+   * @param pmu Name of the PMU.
+   * @param term Name of the term.
+   * @return The format, or std::nullopt if the PMU has no such term.
+   */
+  [[nodiscard]] std::optional<Format> format(std::string_view pmu, std::string_view term) const;
+
+  /**
+   * Reads the terms of an event alias of the given PMU (e.g., "event=0xc0,umask=0x0").
+   *
+   * @param pmu Name of the PMU.
+   * @param alias Name of the alias.
+   * @return Terms of the alias, or std::nullopt if the PMU has no such alias.
+   */
+  [[nodiscard]] std::optional<std::string> alias(std::string_view pmu, std::string_view alias) const;
+
+  /**
+   * Applies comma-separated terms to the config fields.
+   *
+   * @param pmu Name of the PMU.
+   * @param terms Terms to apply.
+   * @param config Config fields (config, config1, config2).
+   * @param period Sampling period, if set by the terms.
+   * @param depth Depth of alias expansion (aliases referring to aliases).
+   */
+  void apply(std::string_view pmu,
+             std::string_view terms,
+             std::array<std::uint64_t, 3U>& config,
+             std::optional<std::uint64_t>& period,
+             std::uint8_t depth) const;
+};
+}
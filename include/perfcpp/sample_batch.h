@@ -0,0 +1,272 @@
+#pragma once
+
+#include "branch.h"
+#include "data_source.h"
+#include "sample_view.h"
+#include "weight.h"
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Samples stored column-wise: one contiguous array per recorded field instead of one perf::Sample per record.
+ * Each column holds a value for every sample and a validity bitmap marking samples that lack the value (e.g., due to
+ * malformed records). Columns of fields that were not recorded are empty. Variable-length fields (callchains and
+ * branches) are stored as a single array of values plus an array of offsets per sample.
+ * Records that are no samples (e.g., context switches) are not stored; lost samples are counted.
+ */
+class SampleBatch
+{
+public:
+  /**
+   * Column of a fixed-size field.
+   */
+  template<typename T>
+  class Column
+  {
+  public:
+    Column() = default;
+    ~Column() = default;
+
+    /**
+     * @return True, if the field was recorded.
+     */
+    [[nodiscard]] bool is_enabled() const noexcept { return _is_enabled; }
+
+    /**
+     * @return Number of values, either zero (not recorded) or the number of samples of the batch.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return _values.size(); }
+
+    /**
+     * @param row Index of the sample.
+     * @return True, if the sample holds a value (false if the field was not recorded or the row is out of range).
+     */
+    [[nodiscard]] bool is_valid(const std::size_t row) const noexcept
+    {
+      return row < _values.size() && (_validity[row / 64U] & (std::uint64_t{ 1U } << (row % 64U))) != 0U;
+    }
+
+    /**
+     * @param row Index of the sample.
+     * @return Value of the sample, or std::nullopt if the sample holds no value.
+     */
+    [[nodiscard]] std::optional<T> get(const std::size_t row) const noexcept
+    {
+      return this->is_valid(row) ? std::make_optional(_values[row]) : std::nullopt;
+    }
+
+    /**
+     * @return Values of all samples (values of invalid samples are unspecified).
+     */
+    [[nodiscard]] const std::vector<T>& values() const noexcept { return _values; }
+
+    /**
+     * @return Validity bitmap (bit i of word i/64 is set if sample i holds a value).
+     */
+    [[nodiscard]] const std::vector<std::uint64_t>& validity() const noexcept { return _validity; }
+
+  private:
+    friend SampleBatch;
+
+    bool _is_enabled{ false };
+    std::vector<T> _values;
+    std::vector<std::uint64_t> _validity;
+
+    void push_back(std::optional<T>&& value, const T& placeholder)
+    {
+      const auto row = _values.size();
+      if (row % 64U == 0U) {
+        _validity.push_back(0U);
+      }
+
+      if (value.has_value()) {
+        _validity.back() |= std::uint64_t{ 1U } << (row % 64U);
+        _values.push_back(std::move(value.value()));
+      } else {
+        _values.push_back(placeholder);
+      }
+    }
+
+    void permute(const std::vector<std::size_t>& order)
+    {
+      if (!_is_enabled) {
+        return;
+      }
+
+      auto values = std::vector<T>{};
+      values.reserve(_values.size());
+      auto validity = std::vector<std::uint64_t>(_validity.size(), 0U);
+      for (auto row = std::size_t{ 0U }; row < order.size(); ++row) {
+        values.push_back(_values[order[row]]);
+        if (this->is_valid(order[row])) {
+          validity[row / 64U] |= std::uint64_t{ 1U } << (row % 64U);
+        }
+      }
+
+      _values = std::move(values);
+      _validity = std::move(validity);
+    }
+  };
+
+  /**
+   * Column of a variable-length field: The values of sample i are located between offsets()[i] and offsets()[i+1].
+   */
+  template<typename T>
+  class ListColumn
+  {
+  public:
+    ListColumn() = default;
+    ~ListColumn() = default;
+
+    /**
+     * @return True, if the field was recorded.
+     */
+    [[nodiscard]] bool is_enabled() const noexcept { return _is_enabled; }
+
+    /**
+     * @return Number of samples, either zero (not recorded) or the number of samples of the batch.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return _offsets.empty() ? 0U : _offsets.size() - 1U; }
+
+    /**
+     * @param row Index of the sample.
+     * @return Values of the sample (empty if the field was not recorded or the row is out of range).
+     */
+    [[nodiscard]] ArrayView<T> get(const std::size_t row) const noexcept
+    {
+      if (row >= this->size()) {
+        return ArrayView<T>{};
+      }
+
+      return ArrayView<T>{ _values.data() + _offsets[row], std::size_t(_offsets[row + 1U] - _offsets[row]) };
+    }
+
+    /**
+     * @return Offsets of the values per sample (number of samples + 1).
+     */
+    [[nodiscard]] const std::vector<std::uint64_t>& offsets() const noexcept { return _offsets; }
+
+    /**
+     * @return Values of all samples.
+     */
+    [[nodiscard]] const std::vector<T>& values() const noexcept { return _values; }
+
+  private:
+    friend SampleBatch;
+
+    bool _is_enabled{ false };
+    std::vector<std::uint64_t> _offsets;
+    std::vector<T> _values;
+
+    template<typename I, typename F>
+    void push_back(const ArrayView<I> items, F&& transform)
+    {
+      if (_offsets.empty()) {
+        _offsets.push_back(0U);
+      }
+
+      for (const auto& item : items) {
+        _values.push_back(transform(item));
+      }
+      _offsets.push_back(_values.size());
+    }
+
+    void permute(const std::vector<std::size_t>& order)
+    {
+      if (!_is_enabled) {
+        return;
+      }
+
+      auto offsets = std::vector<std::uint64_t>{};
+      offsets.reserve(_offsets.size());
+      offsets.push_back(0U);
+      auto values = std::vector<T>{};
+      values.reserve(_values.size());
+      for (const auto row : order) {
+        values.insert(values.end(), _values.begin() + _offsets[row], _values.begin() + _offsets[row + 1U]);
+        offsets.push_back(values.size());
+      }
+
+      _offsets = std::move(offsets);
+      _values = std::move(values);
+    }
+  };
+
+  SampleBatch() = default;
+  ~SampleBatch() = default;
+
+  /**
+   * @return Number of samples.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _size; }
+  [[nodiscard]] bool empty() const noexcept { return _size == 0U; }
+
+  /**
+   * @return Number of samples lost by the perf subsystem (e.g., since the buffer was full).
+   */
+  [[nodiscard]] std::uint64_t count_loss() const noexcept { return _count_loss; }
+
+  [[nodiscard]] const Column<std::uintptr_t>& instruction_pointer() const noexcept { return _instruction_pointer; }
+  [[nodiscard]] const Column<std::uint32_t>& process_id() const noexcept { return _process_id; }
+  [[nodiscard]] const Column<std::uint32_t>& thread_id() const noexcept { return _thread_id; }
+  [[nodiscard]] const Column<std::uint64_t>& time() const noexcept { return _time; }
+  [[nodiscard]] const Column<std::uintptr_t>& logical_memory_address() const noexcept
+  {
+    return _logical_memory_address;
+  }
+  [[nodiscard]] const Column<std::uint32_t>& cpu_id() const noexcept { return _cpu_id; }
+  [[nodiscard]] const Column<std::uint64_t>& period() const noexcept { return _period; }
+  [[nodiscard]] const Column<Weight>& weight() const noexcept { return _weight; }
+  [[nodiscard]] const Column<DataSource>& data_src() const noexcept { return _data_src; }
+  [[nodiscard]] const Column<std::uintptr_t>& physical_memory_address() const noexcept
+  {
+    return _physical_memory_address;
+  }
+  [[nodiscard]] const ListColumn<std::uintptr_t>& callchain() const noexcept { return _callchain; }
+  [[nodiscard]] const ListColumn<Branch>& branches() const noexcept { return _branches; }
+
+  /**
+   * @return Number of bytes allocated by the columns.
+   */
+  [[nodiscard]] std::size_t memory_usage() const noexcept;
+
+  /**
+   * Enables the columns of all fields recorded with the given layout.
+   *
+   * @param layout Layout of the sample records.
+   */
+  void enable(const SampleView::Layout& layout) noexcept;
+
+  /**
+   * Appends a record to the batch (samples are stored, lost samples are counted, other records are skipped).
+   *
+   * @param record View on the record.
+   */
+  void push_back(const SampleView& record);
+
+  /**
+   * Sorts the samples by timestamp (if recorded).
+   */
+  void sort_by_time();
+
+private:
+  std::size_t _size{ 0U };
+  std::uint64_t _count_loss{ 0U };
+
+  Column<std::uintptr_t> _instruction_pointer;
+  Column<std::uint32_t> _process_id;
+  Column<std::uint32_t> _thread_id;
+  Column<std::uint64_t> _time;
+  Column<std::uintptr_t> _logical_memory_address;
+  Column<std::uint32_t> _cpu_id;
+  Column<std::uint64_t> _period;
+  Column<Weight> _weight;
+  Column<DataSource> _data_src;
+  Column<std::uintptr_t> _physical_memory_address;
+  ListColumn<std::uintptr_t> _callchain;
+  ListColumn<Branch> _branches;
+};
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "sample.h"
+#include "sampler.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace perf {
+/**
+ * Consumes the samples of one or multiple samplers from a background thread while they are recording.
+ * The thread waits (via epoll) until the perf subsystem signals that a buffer is filled up to its wakeup mark (see
+ * SampleConfig::wakeup_events() and SampleConfig::wakeup_watermark()), drains the samplers of all signaled buffers,
+ * and hands the samples to the sink in batches. Since buffers are consumed continuously, they can be sized far
+ * smaller than needed to hold all samples of a recording.
+ *
+ * The samplers have to be opened before starting the drainer and must not be opened concurrently to start(); only
+ * the samplers opened at start() are drained (samplers opened later are ignored until the drainer is started again).
+ * The drainer has to be stopped before closing the samplers. While the drainer is running, the samplers must not be
+ * drained otherwise.
+ */
+class SampleDrainer
+{
+public:
+  /// Callback receiving a batch of samples on the background thread; the last batch is handed over on the thread
+  /// calling stop() (or destroying the drainer). Must not throw.
+  using Sink = std::function<void(std::vector<Sample>&&)>;
+
+  SampleDrainer(Sampler& sampler, Sink&& sink);
+  SampleDrainer(MultiThreadSampler& sampler, Sink&& sink);
+  SampleDrainer(MultiCoreSampler& sampler, Sink&& sink);
+
+  SampleDrainer(const SampleDrainer&) = delete;
+  SampleDrainer& operator=(const SampleDrainer&) = delete;
+
+  ~SampleDrainer();
+
+  /**
+   * Starts the background thread that drains the buffers of all samplers that are opened at this point.
+   */
+  void start();
+
+  /**
+   * Stops the background thread and drains the samples remaining in the buffers (handed to the sink as a last batch
+   * on the calling thread).
+   */
+  void stop();
+
+  /**
+   * @return Number of samples handed to the sink since starting the drainer.
+   */
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples.load(); }
+
+  /**
+   * @return Number of batches handed to the sink since starting the drainer.
+   */
+  [[nodiscard]] std::uint64_t count_batches() const noexcept { return _count_batches.load(); }
+
+private:
+  /// Samplers to drain.
+  std::vector<Sampler*> _samplers;
+
+  /// Samplers that were opened when starting the drainer; the background thread only touches these.
+  std::vector<Sampler*> _opened_samplers;
+
+  /// Callback receiving the batches.
+  Sink _sink;
+
+  /// File descriptor of the epoll instance waiting for the buffers, and of the event waking up the thread to stop.
+  std::int32_t _epoll_file_descriptor{ -1 };
+  std::int32_t _stop_file_descriptor{ -1 };
+
+  std::atomic<std::uint64_t> _count_samples{ 0U };
+  std::atomic<std::uint64_t> _count_batches{ 0U };
+
+  std::thread _drain_thread;
+
+  SampleDrainer(std::vector<Sampler*>&& samplers, Sink&& sink);
+
+  /**
+   * Drains the given samplers and hands all consumed samples as a single batch to the sink.
+   *
+   * @param samplers Samplers to drain.
+   */
+  void drain(const std::vector<Sampler*>& samplers);
+
+  /**
+   * Closes the epoll instance and the stop event.
+   */
+  void close() noexcept;
+
+  /**
+   * Loop of the background thread.
+   */
+  void run();
+};
+}
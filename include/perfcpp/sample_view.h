@@ -0,0 +1,381 @@
+#pragma once
+
+#include "feature.h"
+#include "sample.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace perf {
+/**
+ * Non-owning view on a contiguous array (e.g., the callchain of a sample record).
+ */
+template<typename T>
+class ArrayView
+{
+public:
+  ArrayView() noexcept = default;
+  ArrayView(const T* data, const std::size_t size) noexcept
+    : _data(data)
+    , _size(size)
+  {
+  }
+  ~ArrayView() noexcept = default;
+
+  [[nodiscard]] const T* data() const noexcept { return _data; }
+  [[nodiscard]] std::size_t size() const noexcept { return _size; }
+  [[nodiscard]] bool empty() const noexcept { return _size == 0U; }
+
+  [[nodiscard]] const T* begin() const noexcept { return _data; }
+  [[nodiscard]] const T* end() const noexcept { return _data + _size; }
+
+  [[nodiscard]] const T& operator[](const std::size_t index) const noexcept { return _data[index]; }
+
+private:
+  const T* _data{ nullptr };
+  std::size_t _size{ 0U };
+};
+
+/**
+ * Lazy view on a record of the sample buffer. In contrast to perf::Sample, the view does not copy the record: Fields
+ * are decoded on access, and arrays (callchain, branches, registers, raw data) are exposed as views into the record.
+ * The offsets of the fields are derived once from the sample type of the sampler (see SampleView::Layout); only
+ * fields located behind variable-length fields require to resolve the lengths of the preceding fields per record.
+ *
+ * A view is only valid during the callback it is handed to (see Sampler::for_each_sample_view()), since the record
+ * is released to the perf subsystem afterward.
+ */
+class SampleView
+{
+public:
+  /**
+   * Fields of a sample record, in the order of the record.
+   */
+  enum Field : std::uint8_t
+  {
+    Identifier,
+    InstructionPointer,
+    ThreadId,
+    Time,
+    LogicalMemoryAddress,
+    Id,
+    StreamId,
+    CpuId,
+    Period,
+    CounterValues,
+    Callchain,
+    Raw,
+    BranchStack,
+    UserRegisters,
+    Weight,
+    DataSource,
+    TransactionAbort,
+    KernelRegisters,
+    PhysicalMemoryAddress,
+    CgroupId,
+    DataPageSize,
+    CodePageSize,
+    CountFields
+  };
+
+  /**
+   * Offsets of the fields within sample records of a sampler, derived from its sample type.
+   */
+  class Layout
+  {
+  public:
+    /// Offset of fields that are not recorded or located behind a variable-length field.
+    constexpr static inline auto UNKNOWN_OFFSET = std::uint16_t{ 0xFFFFU };
+
+    Layout() noexcept;
+
+    /**
+     * Derives the layout from the configuration of a sampler.
+     *
+     * @param sample_type Sample type of the sampler (perf_event_attr::sample_type).
+     * @param branch_sample_type Branch sample type of the sampler (perf_event_attr::branch_sample_type).
+     * @param count_user_registers Number of sampled user registers.
+     * @param count_kernel_registers Number of sampled kernel registers.
+     */
+    Layout(std::uint64_t sample_type,
+           std::uint64_t branch_sample_type,
+           std::size_t count_user_registers,
+           std::size_t count_kernel_registers) noexcept;
+    ~Layout() noexcept = default;
+
+    /**
+     * @param field Field of the record.
+     * @return True, if the field is recorded.
+     */
+    [[nodiscard]] bool is_set(const Field field) const noexcept { return (_fields & (1U << field)) != 0U; }
+
+    /**
+     * @param field Field of the record.
+     * @return Offset of the field behind the header of the record, or UNKNOWN_OFFSET if the field is not recorded or
+     * located behind a variable-length field.
+     */
+    [[nodiscard]] std::uint16_t offset(const Field field) const noexcept { return _offsets[field]; }
+
+    /**
+     * @return The first recorded variable-length field (CountFields, if there is none).
+     */
+    [[nodiscard]] Field first_variable_field() const noexcept { return _first_variable_field; }
+
+    [[nodiscard]] bool is_weight_struct() const noexcept { return _is_weight_struct; }
+    [[nodiscard]] bool is_branch_hw_index() const noexcept { return _is_branch_hw_index; }
+    [[nodiscard]] std::size_t count_user_registers() const noexcept { return _count_user_registers; }
+    [[nodiscard]] std::size_t count_kernel_registers() const noexcept { return _count_kernel_registers; }
+
+  private:
+    /// Bitmap of the recorded fields.
+    std::uint32_t _fields{ 0U };
+
+    /// Offsets of the fields located in front of the first variable-length field.
+    std::array<std::uint16_t, CountFields> _offsets;
+
+    Field _first_variable_field{ CountFields };
+
+    bool _is_weight_struct{ false };
+    bool _is_branch_hw_index{ false };
+    std::size_t _count_user_registers{ 0U };
+    std::size_t _count_kernel_registers{ 0U };
+  };
+
+  /**
+   * Creates a view on a record.
+   *
+   * @param header Header of the record (followed by the payload).
+   * @param layout Layout of the sampler that recorded the record.
+   * @param counter_names Names of the counters whose values are recorded (if any).
+   */
+  SampleView(const perf_event_header* header,
+             const Layout& layout,
+             const std::vector<std::string_view>& counter_names) noexcept
+    : _header(header)
+    , _layout(layout)
+    , _counter_names(counter_names)
+  {
+  }
+  ~SampleView() noexcept = default;
+
+  /**
+   * @return True, if the record is a sample (and not, e.g., a loss or context switch).
+   */
+  [[nodiscard]] bool is_sample() const noexcept { return _header->type == PERF_RECORD_SAMPLE; }
+
+  /**
+   * @return True, if the record reports lost samples.
+   */
+  [[nodiscard]] bool is_loss() const noexcept { return _header->type == PERF_RECORD_LOST_SAMPLES; }
+
+  /**
+   * @return Type of the record (PERF_RECORD_*).
+   */
+  [[nodiscard]] std::uint32_t type() const noexcept { return _header->type; }
+
+  /**
+   * @return Size of the record in bytes, including the header.
+   */
+  [[nodiscard]] std::uint16_t size() const noexcept { return _header->size; }
+
+  [[nodiscard]] Sample::Mode mode() const noexcept { return SampleView::mode(_header->misc); }
+  [[nodiscard]] bool is_exact_ip() const noexcept { return (_header->misc & PERF_RECORD_MISC_EXACT_IP) != 0U; }
+
+  /**
+   * @return Number of lost samples, if the record reports lost samples.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> count_loss() const noexcept
+  {
+    if (this->is_loss() && _header->size >= sizeof(perf_event_header) + sizeof(std::uint64_t)) {
+      return this->read<std::uint64_t>(0U);
+    }
+
+    return std::nullopt;
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> sample_id() const noexcept { return this->value(Identifier); }
+  [[nodiscard]] std::optional<std::uintptr_t> instruction_pointer() const noexcept
+  {
+    return this->value(InstructionPointer);
+  }
+  [[nodiscard]] std::optional<std::uint32_t> process_id() const noexcept
+  {
+    return this->value<std::uint32_t>(ThreadId);
+  }
+  [[nodiscard]] std::optional<std::uint32_t> thread_id() const noexcept
+  {
+    return this->value<std::uint32_t>(ThreadId, sizeof(std::uint32_t));
+  }
+  [[nodiscard]] std::optional<std::uint64_t> time() const noexcept { return this->value(Time); }
+  [[nodiscard]] std::optional<std::uintptr_t> logical_memory_address() const noexcept
+  {
+    return this->value(LogicalMemoryAddress);
+  }
+  [[nodiscard]] std::optional<std::uint64_t> id() const noexcept { return this->value(Id); }
+  [[nodiscard]] std::optional<std::uint64_t> stream_id() const noexcept { return this->value(StreamId); }
+  [[nodiscard]] std::optional<std::uint32_t> cpu_id() const noexcept { return this->value<std::uint32_t>(CpuId); }
+  [[nodiscard]] std::optional<std::uint64_t> period() const noexcept { return this->value(Period); }
+  [[nodiscard]] std::optional<perf::Weight> weight() const noexcept;
+  [[nodiscard]] std::optional<perf::DataSource> data_src() const noexcept
+  {
+    const auto data_source = this->value(DataSource);
+    return data_source.has_value() ? std::make_optional(perf::DataSource{ data_source.value() }) : std::nullopt;
+  }
+  [[nodiscard]] std::optional<perf::TransactionAbort> transaction_abort() const noexcept
+  {
+    const auto transaction_abort = this->value(TransactionAbort);
+    return transaction_abort.has_value() ? std::make_optional(perf::TransactionAbort{ transaction_abort.value() })
+                                         : std::nullopt;
+  }
+  [[nodiscard]] std::optional<std::uintptr_t> physical_memory_address() const noexcept
+  {
+    return this->value(PhysicalMemoryAddress);
+  }
+  [[nodiscard]] std::optional<std::uint64_t> cgroup_id() const noexcept { return this->value(CgroupId); }
+  [[nodiscard]] std::optional<std::uint64_t> data_page_size() const noexcept { return this->value(DataPageSize); }
+  [[nodiscard]] std::optional<std::uint64_t> code_page_size() const noexcept { return this->value(CodePageSize); }
+
+  /**
+   * @return Instruction pointers of the callchain (empty, if not recorded).
+   */
+  [[nodiscard]] ArrayView<std::uint64_t> callchain() const noexcept;
+
+  /**
+   * @return Branch stack (empty, if not recorded).
+   */
+  [[nodiscard]] ArrayView<perf_branch_entry> branches() const noexcept;
+
+  /**
+   * @return Raw data (empty, if not recorded).
+   */
+  [[nodiscard]] ArrayView<char> raw() const noexcept;
+
+  [[nodiscard]] std::optional<std::uint64_t> user_registers_abi() const noexcept { return this->value(UserRegisters); }
+  [[nodiscard]] std::optional<std::uint64_t> kernel_registers_abi() const noexcept
+  {
+    return this->value(KernelRegisters);
+  }
+
+  /**
+   * @return Values of the sampled user registers, in the order of their ids (empty, if not recorded).
+   */
+  [[nodiscard]] ArrayView<std::uint64_t> user_registers() const noexcept { return this->registers(UserRegisters); }
+
+  /**
+   * @return Values of the sampled kernel registers, in the order of their ids (empty, if not recorded).
+   */
+  [[nodiscard]] ArrayView<std::uint64_t> kernel_registers() const noexcept
+  {
+    return this->registers(KernelRegisters);
+  }
+
+  /**
+   * Reads the value of a counter recorded into the sample, corrected by multiplexing.
+   *
+   * @param name Name of the counter.
+   * @return Value of the counter, or std::nullopt if the counter was not recorded.
+   */
+  [[nodiscard]] std::optional<double> counter_value(std::string_view name) const noexcept;
+
+  /**
+   * Translates the misc field of a record header into the mode the record was recorded in.
+   *
+   * @param misc Misc field of the record header.
+   * @return Mode of the record.
+   */
+  [[nodiscard]] static Sample::Mode mode(std::uint16_t misc) noexcept;
+
+private:
+  const perf_event_header* _header;
+  const Layout& _layout;
+  const std::vector<std::string_view>& _counter_names;
+
+  /// Offsets of the fields behind variable-length fields, resolved on the first access to any of these fields.
+  mutable std::array<std::uint16_t, CountFields> _resolved_offsets;
+  mutable bool _is_resolved{ false };
+
+  /**
+   * @param field Field of the record.
+   * @return Offset of the field behind the header, or Layout::UNKNOWN_OFFSET if the field is not part of the record.
+   */
+  [[nodiscard]] std::uint16_t offset(const Field field) const noexcept
+  {
+    if (!this->is_sample() || !_layout.is_set(field)) {
+      return Layout::UNKNOWN_OFFSET;
+    }
+
+    if (field < _layout.first_variable_field()) {
+      return _layout.offset(field);
+    }
+
+    if (!_is_resolved) {
+      this->resolve_offsets();
+    }
+
+    return _resolved_offsets[field];
+  }
+
+  /**
+   * Resolves the offsets of all fields starting with the first variable-length field, using the lengths stored in
+   * the record.
+   */
+  void resolve_offsets() const noexcept;
+
+  /**
+   * Reads a value from the payload of the record.
+   *
+   * @param offset Offset behind the header.
+   * @return The value, or std::nullopt if the value exceeds the record.
+   */
+  template<typename T>
+  [[nodiscard]] std::optional<T> read(const std::size_t offset) const noexcept
+  {
+    if (offset + sizeof(T) > _header->size - sizeof(perf_event_header)) {
+      return std::nullopt;
+    }
+
+    auto value = T{};
+    std::memcpy(&value, reinterpret_cast<const std::uint8_t*>(_header + 1U) + offset, sizeof(T));
+    return value;
+  }
+
+  /**
+   * Reads the value of a fixed-size field.
+   *
+   * @param field Field of the record.
+   * @param offset_in_field Offset of the value within the field.
+   * @return The value, or std::nullopt if the field is not recorded.
+   */
+  template<typename T = std::uint64_t>
+  [[nodiscard]] std::optional<T> value(const Field field, const std::size_t offset_in_field = 0U) const noexcept
+  {
+    const auto offset = this->offset(field);
+    return offset != Layout::UNKNOWN_OFFSET ? this->read<T>(offset + offset_in_field) : std::nullopt;
+  }
+
+  /**
+   * Creates a view on an array stored in the payload of the record.
+   *
+   * @param offset Offset of the first item behind the header.
+   * @param size Number of items.
+   * @return View on the array, or an empty view if the array exceeds the record.
+   */
+  template<typename T>
+  [[nodiscard]] ArrayView<T> array(const std::size_t offset, const std::uint64_t size) const noexcept
+  {
+    const auto payload_size = std::size_t{ _header->size } - sizeof(perf_event_header);
+    if (offset > payload_size || size > (payload_size - offset) / sizeof(T)) {
+      return ArrayView<T>{};
+    }
+
+    return ArrayView<T>{ reinterpret_cast<const T*>(reinterpret_cast<const std::uint8_t*>(_header + 1U) + offset),
+                         std::size_t(size) };
+  }
+
+  [[nodiscard]] ArrayView<std::uint64_t> registers(Field field) const noexcept;
+};
+}
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "cgroup.h"
 #include "config.h"
 #include "counter_definition.h"
 #include "feature.h"
 #include "group.h"
+#include "hardware_info.h"
+#include "parallel_open.h"
 #include "sample.h"
+#include "sample_batch.h"
+#include "sample_view.h"
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <optional>
@@ -16,9 +22,15 @@ namespace perf {
 class MultiSamplerBase;
 class MultiThreadSampler;
 class MultiCoreSampler;
+class SampleDrainer;
+class SampleBufferFuzzer;
 class Sampler
 {
   friend MultiSamplerBase;
+  friend SampleDrainer;
+
+  /// Injects synthetic buffers (see tests/sample_buffer_fuzz.cpp).
+  friend SampleBufferFuzzer;
 
 public:
   /**
@@ -488,7 +500,7 @@ public:
   /**
    * Opens the sampler.
    */
-  void open();
+  void open() { open(nullptr); }
 
   /**
    * Opens and starts recording performance counters.
@@ -508,10 +520,47 @@ public:
   void close();
 
   /**
-   * @return List of sampled events after closing the sampler.
+   * @return List of sampled events after closing the sampler (without the samples already consumed via drain() or
+   * for_each_sample()).
    */
   [[nodiscard]] std::vector<Sample> result(bool sort_by_time = true) const;
 
+  /**
+   * Decodes the samples like result(), but stores them column-wise (one array per recorded field) instead of as a list
+   * of perf::Sample, which needs considerably less memory and speeds up analyses touching only a few fields.
+   *
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   * @return Batch of sampled events after closing the sampler.
+   */
+  [[nodiscard]] SampleBatch result_columnar(bool sort_by_time = true) const;
+
+  /**
+   * Consumes the samples recorded so far and hands the space in the buffers back to the perf subsystem. Can be called
+   * while the sampler is recording (e.g., periodically), such that sampling can continue for an arbitrary time using
+   * buffers of fixed size; otherwise, the perf subsystem drops samples once a buffer is full.
+   *
+   * @param callback Callback that is invoked with every consumed sample.
+   * @return Number of consumed samples.
+   */
+  std::size_t for_each_sample(const std::function<void(Sample&&)>& callback);
+
+  /**
+   * Consumes the records sampled so far like for_each_sample(), but hands lazy views on the records to the callback
+   * instead of decoding them into samples. The views point into the buffers and are only valid during the callback.
+   *
+   * @param callback Callback that is invoked with a view on every consumed record.
+   * @return Number of consumed records.
+   */
+  std::size_t for_each_sample_view(const std::function<void(const SampleView&)>& callback);
+
+  /**
+   * Consumes the samples recorded so far (see for_each_sample()).
+   *
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   * @return List of consumed samples.
+   */
+  [[nodiscard]] std::vector<Sample> drain(bool sort_by_time = true);
+
   /**
    * @return The latest error reported by the sampler.
    */
@@ -540,11 +589,16 @@ private:
     {
     }
 
-    void buffer(void* buffer) noexcept { _buffer = buffer; }
+    void buffer(void* buffer, const std::int64_t file_descriptor) noexcept
+    {
+      _buffer = buffer;
+      _buffer_file_descriptor = file_descriptor;
+    }
 
     [[nodiscard]] Group& group() noexcept { return _group; }
     [[nodiscard]] const Group& group() const noexcept { return _group; }
     [[nodiscard]] void* buffer() const noexcept { return _buffer; }
+    [[nodiscard]] std::int64_t buffer_file_descriptor() const noexcept { return _buffer_file_descriptor; }
     [[nodiscard]] const std::vector<std::string_view>& counter_names() const noexcept { return _counter_names; }
 
   private:
@@ -554,6 +608,9 @@ private:
     /// User-level, mmap-ed buffer that receives the samples by the perf subsystem.
     void* _buffer{ nullptr };
 
+    /// File descriptor of the counter the buffer is mapped for.
+    std::int64_t _buffer_file_descriptor{ -1 };
+
     /// List of counter names if counter values are sampled.
     std::vector<std::string_view> _counter_names;
   };
@@ -567,24 +624,61 @@ private:
   public:
     UserLevelBufferEntry(perf_event_header* header) noexcept
       : _head(std::uintptr_t(header + 1U))
+      , _end(std::uintptr_t(header) + std::max<std::uintptr_t>(header->size, sizeof(perf_event_header)))
       , _misc(header->misc)
       , _type(header->type)
     {
     }
     ~UserLevelBufferEntry() noexcept = default;
 
+    /**
+     * Reads a value from the entry. Reading behind the end of the entry (malformed records) yields zero.
+     *
+     * @return The value.
+     */
     template<typename T>
     [[nodiscard]] T read() noexcept
     {
+      if (!this->is_readable<T>()) {
+        _head = _end;
+        return T{};
+      }
+
       const auto data = *reinterpret_cast<T*>(_head);
       _head += sizeof(T);
 
       return data;
     }
 
+    /**
+     * @param size Number of values.
+     * @return True, if the given number of values can be read without exceeding the entry.
+     */
+    template<typename T>
+    [[nodiscard]] bool is_readable(const std::size_t size = 1U) const noexcept
+    {
+      return size <= (_end - _head) / sizeof(T);
+    }
+
+    /**
+     * @return Number of bytes left in the entry.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return _end - _head; }
+
+    /**
+     * Reads an array of values from the entry.
+     *
+     * @param size Number of values.
+     * @return Pointer to the first value, or nullptr if the array exceeds the entry (malformed records).
+     */
     template<typename T>
     [[nodiscard]] const T* read(const std::size_t size) noexcept
     {
+      if (!this->is_readable<T>(size)) {
+        _head = _end;
+        return nullptr;
+      }
+
       auto* begin = reinterpret_cast<T*>(_head);
       _head += sizeof(T) * size;
 
@@ -594,13 +688,13 @@ private:
     template<typename T>
     void skip() noexcept
     {
-      _head += sizeof(T);
+      this->skip<T>(1U);
     }
 
     template<typename T>
     void skip(const std::size_t size) noexcept
     {
-      _head += sizeof(T) * size;
+      _head = this->is_readable<T>(size) ? _head + sizeof(T) * size : _end;
     }
 
     template<typename T>
@@ -663,6 +757,7 @@ private:
 
   private:
     std::uintptr_t _head;
+    const std::uintptr_t _end;
     const std::uint16_t _misc;
     const std::uint32_t _type;
   };
@@ -692,6 +787,57 @@ private:
     std::array<value, Group::MAX_MEMBERS> values;
   };
 
+  /**
+   * Reads the head of the buffer, i.e., the offset behind the last record written by the perf subsystem.
+   *
+   * @param mmap_page Control page of the buffer.
+   * @return Head of the buffer.
+   */
+  [[nodiscard]] static std::uint64_t data_head(const perf_event_mmap_page* mmap_page) noexcept;
+
+  /**
+   * Publishes the tail of the buffer, i.e., hands the space of all records before the tail back to the perf subsystem.
+   *
+   * @param mmap_page Control page of the buffer.
+   * @param tail New tail of the buffer.
+   */
+  static void data_tail(perf_event_mmap_page* mmap_page, std::uint64_t tail) noexcept;
+
+  /**
+   * Invokes the callback for every record of the buffer between tail and head. Records wrapping around the end of the
+   * buffer are copied into the scratch buffer. Malformed records (and all following records) are skipped.
+   *
+   * @param sample_counter Sample counter owning the buffer.
+   * @param tail Offset of the first record.
+   * @param head Offset behind the last record.
+   * @param scratch Buffer for records wrapping around.
+   * @param callback Callback that is invoked with the header of every record.
+   * @return Offset behind the last read or skipped record.
+   */
+  template<typename F>
+  std::uint64_t read_records(const SampleCounter& sample_counter,
+                             std::uint64_t tail,
+                             std::uint64_t head,
+                             std::vector<std::uint8_t>& scratch,
+                             F&& callback) const;
+
+  /**
+   * Appends all records that were not consumed yet to the given batch, without consuming them.
+   *
+   * @param batch Batch to append the samples to.
+   */
+  void read_columnar(SampleBatch& batch) const;
+
+  /**
+   * Translates a record from the user-level buffer into a sample.
+   *
+   * @param entry Entry of the user-level buffer.
+   * @param sample_counter The SampleCounter the entry is linked to.
+   * @return Sample, or std::nullopt if the record is no sample (or not requested).
+   */
+  [[nodiscard]] std::optional<perf::Sample> read_record(UserLevelBufferEntry entry,
+                                                        const SampleCounter& sample_counter) const;
+
   /**
    * Reads the sample_id struct from the data located at sample_ptr into the provided sample.
    *
@@ -736,6 +882,14 @@ private:
    */
   [[nodiscard]] perf::Sample read_cgroup_event(UserLevelBufferEntry entry) const;
 
+  /**
+   * Opens the sampler, reusing the precise_ip of the counters of an already opened sampler with the same triggers
+   * (e.g., the sampler of another CPU core) to avoid retrying unsupported precise_ip values.
+   *
+   * @param resolved_sampler Already opened sampler, may be nullptr.
+   */
+  void open(const Sampler* resolved_sampler);
+
   /**
    * Translates the current entry from the user-level buffer into a throttle or unthrottle sample.
    *
@@ -762,6 +916,12 @@ private:
   /// List of counter groups used to sample – will be filled when "opening" the sampler.
   std::vector<SampleCounter> _sample_counter;
 
+  /// Offsets of the fields within sample records, derived when opening the sampler.
+  SampleView::Layout _sample_layout;
+
+  /// Scratch buffer for records wrapping around the end of a buffer while draining.
+  std::vector<std::uint8_t> _scratch;
+
   /// Flag if the sampler is already opened, i.e., the events are configured.
   /// This enables the user to open the sampler specifically – or open the
   /// sampler when starting.
@@ -774,6 +934,8 @@ private:
 
 class MultiSamplerBase
 {
+  friend SampleDrainer;
+
 public:
   ~MultiSamplerBase() = default;
 
@@ -810,6 +972,51 @@ public:
     return result(samplers(), sort_by_time);
   }
 
+  /**
+   * @return Batch of sampled events of all samplers after stopping the sampler, see Sampler::result_columnar().
+   */
+  [[nodiscard]] SampleBatch result_columnar(bool sort_by_time = true) const;
+
+  /**
+   * Consumes the samples recorded so far by all samplers, see Sampler::for_each_sample().
+   *
+   * @param callback Callback that is invoked with every consumed sample.
+   * @return Number of consumed samples.
+   */
+  std::size_t for_each_sample(const std::function<void(Sample&&)>& callback)
+  {
+    auto count_samples = std::size_t{ 0U };
+    for (auto& sampler : samplers()) {
+      count_samples += sampler.for_each_sample(callback);
+    }
+
+    return count_samples;
+  }
+
+  /**
+   * Consumes the records sampled so far by all samplers, see Sampler::for_each_sample_view().
+   *
+   * @param callback Callback that is invoked with a view on every consumed record.
+   * @return Number of consumed records.
+   */
+  std::size_t for_each_sample_view(const std::function<void(const SampleView&)>& callback)
+  {
+    auto count_records = std::size_t{ 0U };
+    for (auto& sampler : samplers()) {
+      count_records += sampler.for_each_sample_view(callback);
+    }
+
+    return count_records;
+  }
+
+  /**
+   * Consumes the samples recorded so far by all samplers, see Sampler::drain().
+   *
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   * @return List of consumed samples.
+   */
+  [[nodiscard]] std::vector<Sample> drain(bool sort_by_time = true);
+
 protected:
   explicit MultiSamplerBase(SampleConfig config)
     : _config(config)
@@ -851,6 +1058,12 @@ protected:
    */
   static void trigger(std::vector<Sampler>& samplers, std::vector<std::vector<Sampler::Trigger>>&& triggers);
 
+  /**
+   * @param sampler Sampler to check.
+   * @return True, if the given sampler is opened.
+   */
+  [[nodiscard]] static bool is_opened(const Sampler& sampler) noexcept { return sampler._is_opened; }
+
   /**
    * Initializes the given sampler with values and config.
    *
@@ -863,8 +1076,9 @@ protected:
    *
    * @param sampler Sampler to open.
    * @param config Config for that sampler.
+   * @param resolved_sampler Already opened sampler to reuse the precise_ip from, may be nullptr.
    */
-  void open(Sampler& sampler, SampleConfig config);
+  void open(Sampler& sampler, SampleConfig config, const Sampler* resolved_sampler = nullptr);
 
   /**
    * Initializes the given sampler with values and config.
@@ -1137,6 +1351,31 @@ public:
                             std::vector<std::uint16_t>&& core_ids,
                             SampleConfig config = {});
 
+  /**
+   * Samples all processes of the given cgroup on the given CPU cores.
+   *
+   * @param counter_list Counter definitions.
+   * @param cgroup Cgroup to sample (has to be alive while the samplers are opened).
+   * @param core_ids List of CPU cores.
+   * @param config Configuration of the samplers.
+   */
+  MultiCoreSampler(const CounterDefinition& counter_list,
+                   const CgroupHandle& cgroup,
+                   std::vector<std::uint16_t>&& core_ids,
+                   SampleConfig config = {});
+
+  /**
+   * Samples all processes of the given cgroup on all online CPU cores.
+   *
+   * @param counter_list Counter definitions.
+   * @param cgroup Cgroup to sample (has to be alive while the samplers are opened).
+   * @param config Configuration of the samplers.
+   */
+  MultiCoreSampler(const CounterDefinition& counter_list, const CgroupHandle& cgroup, SampleConfig config = {})
+    : MultiCoreSampler(counter_list, cgroup, HardwareInfo::online_cpu_ids(), config)
+  {
+  }
+
   MultiCoreSampler(MultiCoreSampler&&) noexcept = default;
 
   ~MultiCoreSampler() = default;
@@ -1279,6 +1518,11 @@ public:
     }
   }
 
+  /**
+   * @return Duration of the phases when the samplers were opened the last time.
+   */
+  [[nodiscard]] OpenTiming open_timing() const noexcept { return _open_timing; }
+
 private:
   /**
    * @return A list of multiple samplers.
@@ -1295,6 +1539,9 @@ private:
 
   /// List of core ids the samplers should record on.
   std::vector<std::uint16_t> _core_ids;
+
+  /// Duration of the phases when the samplers were opened the last time.
+  OpenTiming _open_timing;
 };
 
 class SampleTimestampComparator
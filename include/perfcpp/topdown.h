@@ -0,0 +1,53 @@
+#pragma once
+
+#include "counter.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Counters and metrics of the top-down microarchitecture analysis (TMA), which breaks down the pipeline slots into
+ * frontend bound, bad speculation, backend bound, and retiring (level 1) and their sub-categories (level 2).
+ * The CounterDefinition registers the counters and metrics supported by the underlying processor; the lists are
+ * exposed to inspect the metrics and to evaluate them on synthetic results (e.g., in tests).
+ */
+class Topdown
+{
+public:
+  /**
+   * Counters of Intel processors with perf metrics (Ice Lake and newer; level 2 from Sapphire Rapids).
+   * The slots counter has to lead the group of all other (topdown metric) counters; the EventCounter places them
+   * accordingly.
+   *
+   * @param is_level2 If true, the counters of level 2 are included.
+   * @return List of counter names and configurations.
+   */
+  [[nodiscard]] static std::vector<std::pair<std::string, CounterConfig>> intel_counters(bool is_level2);
+
+  /**
+   * Metrics (names and expressions) of Intel processors with perf metrics.
+   *
+   * @param is_level2 If true, the metrics of level 2 are included.
+   * @return List of metric names and expressions.
+   */
+  [[nodiscard]] static std::vector<std::pair<std::string, std::string>> intel_metrics(bool is_level2);
+
+  /**
+   * Counters of AMD processors with pipeline utilization events (Zen 4 and newer).
+   *
+   * @param dispatch_slots Number of dispatch slots per cycle (6 on Zen 4, 8 on Zen 5).
+   * @return List of counter names and configurations.
+   */
+  [[nodiscard]] static std::vector<std::pair<std::string, CounterConfig>> amd_counters(std::uint8_t dispatch_slots);
+
+  /**
+   * Metrics (names and expressions) of AMD processors with pipeline utilization events.
+   *
+   * @param dispatch_slots Number of dispatch slots per cycle (6 on Zen 4, 8 on Zen 5).
+   * @return List of metric names and expressions.
+   */
+  [[nodiscard]] static std::vector<std::pair<std::string, std::string>> amd_metrics(std::uint8_t dispatch_slots);
+};
+}
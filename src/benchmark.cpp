@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <perfcpp/benchmark.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+/**
+ * Calculates the median of the given sorted values.
+ *
+ * @param values Sorted values.
+ * @return The median.
+ */
+double
+median_of_sorted(const std::vector<double>& values) noexcept
+{
+  const auto count = values.size();
+  if (count == 0U) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  return count % 2U == 1U ? values[count / 2U] : (values[count / 2U - 1U] + values[count / 2U]) / 2.0;
+}
+
+/**
+ * Calculates the median absolute deviation of the given values.
+ *
+ * @param values Values.
+ * @param median Median of the values.
+ * @return The median absolute deviation.
+ */
+double
+median_absolute_deviation(const std::vector<double>& values, const double median)
+{
+  auto deviations = std::vector<double>{};
+  deviations.reserve(values.size());
+  std::transform(values.begin(), values.end(), std::back_inserter(deviations), [median](const auto value) {
+    return std::abs(value - median);
+  });
+  std::sort(deviations.begin(), deviations.end());
+
+  return median_of_sorted(deviations);
+}
+
+/**
+ * Calculates the quantile of the standard normal distribution for a two-sided confidence level (e.g., 1.96 for
+ * 0.95) by bisection.
+ *
+ * @param confidence Confidence level.
+ * @return The quantile.
+ */
+double
+normal_quantile(const double confidence) noexcept
+{
+  auto lower = .0, upper = 10.0;
+  for (auto iteration = 0U; iteration < 64U; ++iteration) {
+    const auto middle = (lower + upper) / 2.0;
+    if (std::erf(middle / std::sqrt(2.0)) < confidence) {
+      lower = middle;
+    } else {
+      upper = middle;
+    }
+  }
+
+  return (lower + upper) / 2.0;
+}
+}
+
+perf::Statistics::Statistics(std::vector<double>&& values)
+  : _values(std::move(values))
+{
+  /// Values that were not available (e.g., refused due to multiplexing) are not considered.
+  this->_values.erase(std::remove_if(this->_values.begin(),
+                                     this->_values.end(),
+                                     [](const auto value) { return std::isnan(value); }),
+                      this->_values.end());
+  if (this->_values.empty()) {
+    return;
+  }
+
+  std::sort(this->_values.begin(), this->_values.end());
+
+  const auto count = double(this->_values.size());
+  this->_min = this->_values.front();
+  this->_max = this->_values.back();
+  this->_mean = std::accumulate(this->_values.begin(), this->_values.end(), .0) / count;
+  this->_median = median_of_sorted(this->_values);
+  this->_mad = median_absolute_deviation(this->_values, this->_median);
+
+  auto squared_deviations = .0;
+  for (const auto value : this->_values) {
+    squared_deviations += (value - this->_mean) * (value - this->_mean);
+  }
+  this->_standard_deviation = this->_values.size() > 1U ? std::sqrt(squared_deviations / (count - 1.0)) : .0;
+}
+
+double
+perf::Statistics::percentile(const double percent) const noexcept
+{
+  if (this->_values.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  const auto rank = std::clamp(percent, .0, 100.0) / 100.0 * double(this->_values.size() - 1U);
+  const auto lower = std::size_t(std::floor(rank));
+  const auto upper = std::min(lower + 1U, this->_values.size() - 1U);
+  if (lower == upper || rank == double(lower)) {
+    return this->_values[lower];
+  }
+
+  return this->_values[lower] + (rank - double(lower)) * (this->_values[upper] - this->_values[lower]);
+}
+
+std::pair<double, double>
+perf::Statistics::confidence_interval(const double confidence) const noexcept
+{
+  if (this->_values.empty()) {
+    return std::make_pair(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+  }
+
+  /// Ranks (1-based) of the order statistics enclosing the median with the given confidence, using the normal
+  /// approximation of the binomial distribution.
+  const auto count = double(this->_values.size());
+  const auto half_width = normal_quantile(confidence) * std::sqrt(count) / 2.0;
+  const auto lower_rank = std::max(1.0, std::floor(count / 2.0 - half_width));
+  const auto upper_rank = std::min(count, std::ceil(1.0 + count / 2.0 + half_width));
+
+  return std::make_pair(this->_values[std::size_t(lower_rank) - 1U], this->_values[std::size_t(upper_rank) - 1U]);
+}
+
+std::optional<perf::Statistics>
+perf::BenchmarkResult::get(const std::string_view name) const
+{
+  if (auto iterator = std::find_if(
+        this->_statistics.begin(), this->_statistics.end(), [&name](const auto& item) { return name == item.first; });
+      iterator != this->_statistics.end()) {
+    return iterator->second;
+  }
+
+  return std::nullopt;
+}
+
+std::string
+perf::BenchmarkResult::to_string() const
+{
+  auto rows = std::vector<std::vector<std::string>>{};
+  rows.reserve(this->_statistics.size() + 2U);
+  rows.push_back({ "Counter", "Median", "MAD", "P5", "P95", "CI95 low", "CI95 high" });
+
+  const auto add_row = [&rows](const std::string_view name, const Statistics& statistics) {
+    const auto [lower, upper] = statistics.confidence_interval();
+    rows.push_back({ std::string{ name },
+                     std::to_string(statistics.median()),
+                     std::to_string(statistics.mad()),
+                     std::to_string(statistics.percentile(5.0)),
+                     std::to_string(statistics.percentile(95.0)),
+                     std::to_string(lower),
+                     std::to_string(upper) });
+  };
+
+  add_row("time (ns)", this->_time);
+  for (const auto& [name, statistics] : this->_statistics) {
+    add_row(name, statistics);
+  }
+
+  /// Width of each column.
+  auto widths = std::vector<std::size_t>(rows.front().size(), 0U);
+  for (const auto& row : rows) {
+    for (auto column = 0U; column < row.size(); ++column) {
+      widths[column] = std::max(widths[column], row[column].size());
+    }
+  }
+
+  auto table_stream = std::stringstream{};
+  for (auto row_id = 0U; row_id < rows.size(); ++row_id) {
+    const auto& row = rows[row_id];
+
+    table_stream << "|";
+    for (auto column = 0U; column < row.size(); ++column) {
+      table_stream << " " << std::setw(std::int32_t(widths[column])) << (column == 0U ? std::left : std::right)
+                   << row[column] << " |";
+    }
+    table_stream << "\n";
+
+    /// Print the separator line below the header.
+    if (row_id == 0U) {
+      table_stream << "|";
+      for (const auto width : widths) {
+        table_stream << std::string(width + 2U, '-') << "|";
+      }
+      table_stream << "\n";
+    }
+  }
+
+  table_stream << "runs: " << this->_count_runs << ", outliers: " << this->count_outliers() << std::flush;
+
+  return table_stream.str();
+}
+
+perf::Benchmark::Benchmark(perf::EventCounter& event_counter,
+                           const std::size_t count_runs,
+                           const std::size_t count_warm_up_runs)
+  : _event_counter(event_counter)
+  , _count_runs(count_runs)
+  , _count_warm_up_runs(count_warm_up_runs)
+{
+  if (this->_count_runs == 0U) {
+    throw std::runtime_error{ "The number of benchmark runs must be greater than zero." };
+  }
+}
+
+bool
+perf::Benchmark::prepare()
+{
+  /// Keep the counters open over all runs, opening them only once.
+  const auto is_opened = !this->_event_counter.is_open();
+  if (is_opened && !this->_event_counter.open()) {
+    this->_event_counter.close();
+    throw std::runtime_error{ "Cannot open the counters for the benchmark." };
+  }
+
+  /// Fill the view once to allocate its memory.
+  this->_event_counter.result(this->_result);
+
+  this->_values.assign(this->_count_runs * this->_result.size(), .0);
+  this->_times.assign(this->_count_runs, std::chrono::nanoseconds{ 0U });
+
+  return is_opened;
+}
+
+void
+perf::Benchmark::record(const std::size_t run_id, const std::chrono::nanoseconds time)
+{
+  this->_event_counter.result(this->_result);
+
+  const auto count_values = this->_result.size();
+  for (auto value_id = 0U; value_id < count_values; ++value_id) {
+    this->_values[run_id * count_values + value_id] = this->_result[CounterHandle{ std::uint16_t(value_id) }];
+  }
+
+  this->_times[run_id] = time;
+}
+
+perf::BenchmarkResult
+perf::Benchmark::evaluate() const
+{
+  /// Reject runs whose wall time has a modified z-score (0.6745 * |x - median| / MAD) above the threshold.
+  auto times = std::vector<double>{};
+  times.reserve(this->_count_runs);
+  std::transform(this->_times.begin(), this->_times.end(), std::back_inserter(times), [](const auto time) {
+    return double(time.count());
+  });
+
+  auto is_outlier = std::vector<bool>(this->_count_runs, false);
+  if (this->_outlier_threshold > .0) {
+    auto sorted_times = times;
+    std::sort(sorted_times.begin(), sorted_times.end());
+    const auto median = median_of_sorted(sorted_times);
+    const auto mad = median_absolute_deviation(sorted_times, median);
+
+    if (mad > .0) {
+      for (auto run_id = 0U; run_id < this->_count_runs; ++run_id) {
+        is_outlier[run_id] = 0.6745 * std::abs(times[run_id] - median) / mad > this->_outlier_threshold;
+      }
+    }
+  }
+
+  const auto values_of_accepted_runs = [this, &is_outlier](const auto& value_of) {
+    auto values = std::vector<double>{};
+    values.reserve(this->_count_runs);
+    for (auto run_id = 0U; run_id < this->_count_runs; ++run_id) {
+      if (!is_outlier[run_id]) {
+        values.emplace_back(value_of(run_id));
+      }
+    }
+    return values;
+  };
+
+  /// Calculate the statistics for all visible counters and metrics.
+  auto statistics = std::vector<std::pair<std::string_view, Statistics>>{};
+  const auto count_values = this->_result.size();
+  for (auto value_id = 0U; value_id < count_values; ++value_id) {
+    const auto& event = this->_event_counter._counters[value_id];
+    if (!event.is_hidden()) {
+      auto values = values_of_accepted_runs(
+        [this, count_values, value_id](const auto run_id) { return this->_values[run_id * count_values + value_id]; });
+      statistics.emplace_back(event.name(), Statistics{ std::move(values) });
+    }
+  }
+
+  return BenchmarkResult{ std::move(statistics),
+                          Statistics{ values_of_accepted_runs([&times](const auto run_id) { return times[run_id]; }) },
+                          this->_count_runs };
+}
@@ -0,0 +1,47 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <perfcpp/cgroup.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+
+perf::CgroupHandle::CgroupHandle(const std::string_view path)
+  : _path(!path.empty() && path.front() == '/' ? std::string{ path } : std::string{ MOUNT_PATH }.append(path))
+{
+  this->_file_descriptor = ::open(this->_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (this->_file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot open cgroup '" }
+                                .append(this->_path)
+                                .append("' (error no: ")
+                                .append(std::to_string(errno))
+                                .append(").") };
+  }
+}
+
+perf::CgroupHandle::CgroupHandle(perf::CgroupHandle&& other) noexcept
+  : _path(std::move(other._path))
+  , _file_descriptor(std::exchange(other._file_descriptor, -1))
+{
+}
+
+perf::CgroupHandle&
+perf::CgroupHandle::operator=(perf::CgroupHandle&& other) noexcept
+{
+  if (this != &other) {
+    if (this->_file_descriptor > -1) {
+      ::close(this->_file_descriptor);
+    }
+
+    this->_path = std::move(other._path);
+    this->_file_descriptor = std::exchange(other._file_descriptor, -1);
+  }
+
+  return *this;
+}
+
+perf::CgroupHandle::~CgroupHandle()
+{
+  if (this->_file_descriptor > -1) {
+    ::close(this->_file_descriptor);
+  }
+}
@@ -16,6 +16,27 @@ perf::CounterResult::get(std::string_view name) const noexcept
   return std::nullopt;
 }
 
+std::optional<perf::Multiplexing>
+perf::CounterResult::multiplexing(std::string_view name) const noexcept
+{
+  if (auto iterator = std::find_if(this->_multiplexing.begin(),
+                                   this->_multiplexing.end(),
+                                   [&name](const auto& multiplexing) { return name == multiplexing.first; });
+      iterator != this->_multiplexing.end()) {
+    return iterator->second;
+  }
+
+  return std::nullopt;
+}
+
+bool
+perf::CounterResult::is_below_threshold() const noexcept
+{
+  return std::any_of(this->_multiplexing.begin(), this->_multiplexing.end(), [](const auto& multiplexing) {
+    return multiplexing.second.is_below_threshold();
+  });
+}
+
 std::string
 perf::CounterResult::to_json() const
 {
@@ -2,6 +2,7 @@
 #include <perfcpp/counter_definition.h>
 #include <perfcpp/feature.h>
 #include <perfcpp/hardware_info.h>
+#include <perfcpp/topdown.h>
 #include <sstream>
 #include <string_view>
 #include <utility>
@@ -11,6 +12,7 @@ perf::CounterDefinition::CounterDefinition(const std::string& config_file)
   this->initialize_generalized_counters();
   this->initialize_amd_ibs_counters();
   this->initialize_intel_pebs_counters();
+  this->initialize_topdown_metrics();
 
   this->read_counter_configuration(config_file);
 }
@@ -20,23 +22,59 @@ perf::CounterDefinition::CounterDefinition()
   this->initialize_generalized_counters();
   this->initialize_amd_ibs_counters();
   this->initialize_intel_pebs_counters();
+  this->initialize_topdown_metrics();
 }
 
 std::optional<std::pair<std::string_view, perf::CounterConfig>>
-perf::CounterDefinition::counter(const std::string& name) const noexcept
+perf::CounterDefinition::counter(const std::string_view name) const noexcept
 {
-  if (auto iterator = this->_counter_configs.find(name); iterator != this->_counter_configs.end()) {
-    return std::make_optional(std::make_pair(std::string_view(iterator->first), iterator->second));
+  if (const auto* entry = this->_counter_configs.find(name); entry != nullptr) {
+    return std::make_optional(std::make_pair(entry->first, entry->second));
+  }
+
+  /// Event strings of the form "<pmu>/<terms>/" are resolved via the sysfs, other names via pmu-events catalogs.
+  if (name.find('/') != std::string_view::npos || !this->_pmu_event_indices.empty()) {
+    return this->pmu_counter(name);
   }
 
   return std::nullopt;
 }
 
+std::optional<std::pair<std::string_view, perf::CounterConfig>>
+perf::CounterDefinition::pmu_counter(const std::string_view name) const noexcept
+{
+  try {
+    const auto lock = std::lock_guard{ *this->_pmu_counter_configs_mutex };
+
+    const auto* entry = this->_pmu_counter_configs.find(name);
+    if (entry == nullptr) {
+      if (name.find('/') != std::string_view::npos) {
+        entry = this->_pmu_counter_configs.insert(name, this->_pmu_event_parser.parse(name)).first;
+      } else {
+        for (const auto& pmu_event_index : this->_pmu_event_indices) {
+          if (auto config = pmu_event_index.find(name); config.has_value()) {
+            entry = this->_pmu_counter_configs.insert(name, std::move(config.value())).first;
+            break;
+          }
+        }
+
+        if (entry == nullptr) {
+          return std::nullopt;
+        }
+      }
+    }
+
+    return std::make_optional(std::make_pair(entry->first, entry->second));
+  } catch (std::exception&) {
+    return std::nullopt;
+  }
+}
+
 std::optional<std::pair<std::string_view, perf::Metric&>>
-perf::CounterDefinition::metric(const std::string& name) const noexcept
+perf::CounterDefinition::metric(const std::string_view name) const noexcept
 {
-  if (auto iterator = _metrics.find(name); iterator != _metrics.end()) {
-    return std::make_optional(std::make_pair(std::string_view(iterator->first), std::ref(*iterator->second)));
+  if (const auto* entry = this->_metrics.find(name); entry != nullptr) {
+    return std::make_optional(std::make_pair(entry->first, std::ref(*entry->second)));
   }
 
   return std::nullopt;
@@ -114,11 +152,11 @@ perf::CounterDefinition::initialize_generalized_counters()
             PERF_COUNT_HW_CACHE_ITLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
 
   /// Pre-defined metrics.
-  this->add(std::make_unique<CyclesPerInstruction>());
-  this->add(std::make_unique<CacheHitRatio>());
-  this->add(std::make_unique<DTLBMissRatio>());
-  this->add(std::make_unique<ITLBMissRatio>());
-  this->add(std::make_unique<L1DataMissRatio>());
+  this->add("cycles-per-instruction", "cycles / instructions");
+  this->add("cache-hit-ratio", "cache-references / cache-misses");
+  this->add("dTLB-miss-ratio", "dTLB-load-misses / dTLB-loads");
+  this->add("iTLB-miss-ratio", "iTLB-load-misses / iTLB-loads");
+  this->add("L1-data-miss-ratio", "L1-dcache-load-misses / L1-dcache-loads");
 }
 
 void
@@ -189,11 +227,34 @@ perf::CounterDefinition::read_counter_configuration(const std::string& csv_filen
           }
 
           if (!name.empty()) {
-            this->_counter_configs.insert(
-              std::make_pair(std::move(name), CounterConfig{ type, config, extended_config }));
+            this->_counter_configs.insert(name, CounterConfig{ type, config, extended_config });
           }
         }
       }
     }
   }
-}
\ No newline at end of file
+}
+
+void
+perf::CounterDefinition::initialize_topdown_metrics()
+{
+  auto counters = std::vector<std::pair<std::string, CounterConfig>>{};
+  auto metrics = std::vector<std::pair<std::string, std::string>>{};
+
+  if (HardwareInfo::is_intel_topdown_supported()) {
+    const auto is_level2 = HardwareInfo::is_intel_topdown_level2_supported();
+    counters = Topdown::intel_counters(is_level2);
+    metrics = Topdown::intel_metrics(is_level2);
+  } else if (const auto dispatch_slots = HardwareInfo::amd_dispatch_slots(); dispatch_slots.has_value()) {
+    counters = Topdown::amd_counters(dispatch_slots.value());
+    metrics = Topdown::amd_metrics(dispatch_slots.value());
+  }
+
+  for (auto& [name, config] : counters) {
+    this->add(std::move(name), config);
+  }
+
+  for (auto& [name, expression] : metrics) {
+    this->add(std::move(name), std::string_view{ expression });
+  }
+}
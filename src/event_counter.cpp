@@ -1,7 +1,21 @@
 #include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <dirent.h>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <perfcpp/hardware_info.h>
 #include <perfcpp/perf.h>
 #include <stdexcept>
+#include <utility>
+
+namespace {
+/// Source for unique ids of MultiThreadEventCounter instances.
+std::atomic<std::uint64_t> next_multi_thread_instance_id{ 1U };
+}
+
 bool
 perf::EventCounter::add(std::string&& counter_name)
 {
@@ -13,6 +27,7 @@ perf::EventCounter::add(std::string&& counter_name)
 
     if (this->_groups.size() < this->_config.max_groups()) {
       this->_groups.emplace_back();
+      this->_first_open_group_id = this->_groups.size() - 1U;
       return true;
     }
 
@@ -22,18 +37,37 @@ perf::EventCounter::add(std::string&& counter_name)
   /// Try to add the counter, if the name is a counter.
   auto counter_config = this->_counter_definitions.counter(counter_name);
   if (counter_config.has_value()) {
-    this->add(std::get<0>(counter_config.value()), std::get<1>(counter_config.value()), false);
+    this->add({ std::make_pair(std::get<0>(counter_config.value()), std::get<1>(counter_config.value())) }, false);
     return true;
   }
 
+  /// Try to add the counter with modifiers (like perf): "D" pins the counter, "e" schedules it exclusively.
+  if (const auto modifier_position = counter_name.find_last_of(':'); modifier_position != std::string::npos) {
+    const auto modifiers = std::string_view{ counter_name }.substr(modifier_position + 1U);
+    const auto is_valid_modifiers = !modifiers.empty() && modifiers.find_first_not_of("De") == std::string_view::npos;
+    if (is_valid_modifiers) {
+      const auto unmodified_counter_name = std::string_view{ counter_name }.substr(0U, modifier_position);
+      counter_config = this->_counter_definitions.counter(unmodified_counter_name);
+      if (counter_config.has_value()) {
+        auto config = std::get<1>(counter_config.value());
+        config.pinned(modifiers.find('D') != std::string_view::npos);
+        config.exclusive(modifiers.find('e') != std::string_view::npos);
+        this->add({ std::make_pair(std::get<0>(counter_config.value()), config) }, false);
+        return true;
+      }
+    }
+  }
+
   /// Try to add the metric, if the name is a metric.
   auto metric = this->_counter_definitions.metric(counter_name);
   if (metric.has_value()) {
-    /// Add all required counters.
+    /// Add all required counters, preferably co-scheduled within the same group.
+    auto dependent_counters = std::vector<std::pair<std::string_view, CounterConfig>>{};
     for (auto&& dependent_counter_name : std::get<1>(metric.value()).required_counter_names()) {
       auto dependent_counter_config = this->_counter_definitions.counter(dependent_counter_name);
       if (dependent_counter_config.has_value()) {
-        this->add(std::get<0>(dependent_counter_config.value()), std::get<1>(dependent_counter_config.value()), true);
+        dependent_counters.emplace_back(std::get<0>(dependent_counter_config.value()),
+                                        std::get<1>(dependent_counter_config.value()));
       } else {
         throw std::runtime_error{ std::string{ "Cannot find counter '" }
                                     .append(dependent_counter_name)
@@ -42,8 +76,22 @@ perf::EventCounter::add(std::string&& counter_name)
                                     .append("'.") };
       }
     }
+    auto dependent_counter_names = std::vector<std::string_view>{};
+    dependent_counter_names.reserve(dependent_counters.size());
+    for (const auto& dependent_counter : dependent_counters) {
+      dependent_counter_names.emplace_back(dependent_counter.first);
+    }
+    this->add(std::move(dependent_counters), true);
 
-    this->_counters.emplace_back(std::get<0>(metric.value()));
+    /// Resolve the required counters once, such that the metric can be calculated without looking up names.
+    auto required_counter_ids = std::vector<std::uint16_t>{};
+    required_counter_ids.reserve(dependent_counter_names.size());
+    for (const auto dependent_counter_name : dependent_counter_names) {
+      required_counter_ids.emplace_back(this->handle(dependent_counter_name).index());
+    }
+
+    this->_counters.emplace_back(
+      std::get<0>(metric.value()), std::get<1>(metric.value()), std::move(required_counter_ids));
     return true;
   }
 
@@ -53,32 +101,214 @@ perf::EventCounter::add(std::string&& counter_name)
 }
 
 void
-perf::EventCounter::add(std::string_view counter_name, perf::CounterConfig counter, const bool is_hidden)
-{
-  /// If the counter is already added,
-  if (auto iterator = std::find_if(this->_counters.begin(),
-                                   this->_counters.end(),
-                                   [&counter_name](const auto& counter) { return counter.name() == counter_name; });
-      iterator != this->_counters.end()) {
-    iterator->is_hidden(iterator->is_hidden() && is_hidden);
+perf::EventCounter::add(std::vector<std::pair<std::string_view, CounterConfig>>&& counters, const bool is_hidden)
+{
+  /// The slots event (Intel) has to lead its group.
+  const auto is_slots = [](const auto& counter) {
+    return HardwareInfo::is_intel_topdown_slots(counter.second.type(), counter.second.event_id());
+  };
+  std::stable_partition(counters.begin(), counters.end(), is_slots);
+
+  /// Skip counters that are already added and remember their group to co-schedule the others.
+  auto preferred_group_id = std::optional<std::uint8_t>{ std::nullopt };
+  auto is_spread_over_groups = false;
+  counters.erase(
+    std::remove_if(counters.begin(),
+                   counters.end(),
+                   [this, is_hidden, &preferred_group_id, &is_spread_over_groups](const auto& counter) {
+                     auto iterator =
+                       std::find_if(this->_counters.begin(), this->_counters.end(), [&counter](const auto& event) {
+                         return event.name() == counter.first;
+                       });
+                     if (iterator == this->_counters.end()) {
+                       return false;
+                     }
+
+                     iterator->is_hidden(iterator->is_hidden() && is_hidden);
+                     if (iterator->is_counter()) {
+                       is_spread_over_groups |=
+                         preferred_group_id.has_value() && preferred_group_id.value() != iterator->group_id();
+                       preferred_group_id = iterator->group_id();
+                     }
+                     return true;
+                   }),
+    counters.end());
+
+  if (counters.empty()) {
     return;
   }
 
-  /// Check if space for more counters left.
-  if (this->_groups.size() == this->_config.max_groups() &&
-      this->_groups.back().size() >= this->_config.max_counters_per_group()) {
-    throw std::runtime_error{ "No more space for counters left." };
+  if (is_spread_over_groups ||
+      (preferred_group_id.has_value() && preferred_group_id.value() < this->_first_open_group_id)) {
+    preferred_group_id = std::nullopt;
   }
 
-  /// Add a new group, if needed (no one available or last is full).
-  if (this->_groups.empty() || this->_groups.back().size() >= this->_config.max_counters_per_group()) {
+  /// Topdown metric events (Intel) are only counted in a group led by the slots event: Add the (hidden) slots
+  /// first, if they are neither requested nor added, and prefer their group.
+  if (std::none_of(counters.begin(), counters.end(), is_slots) &&
+      std::any_of(counters.begin(), counters.end(), [](const auto& counter) {
+        return HardwareInfo::is_intel_topdown_metric(counter.second.type(), counter.second.event_id());
+      })) {
+    const auto is_slots_event = [this](const Event& event) {
+      if (!event.is_counter()) {
+        return false;
+      }
+      const auto& config = this->_groups[event.group_id()].member(event.in_group_id()).config();
+      return HardwareInfo::is_intel_topdown_slots(config.type(), config.event_id());
+    };
+
+    auto slots_event = std::find_if(this->_counters.begin(), this->_counters.end(), is_slots_event);
+    if (slots_event == this->_counters.end()) {
+      if (auto slots = this->_counter_definitions.counter(std::string_view{ "topdown-slots" }); slots.has_value()) {
+        this->add({ slots.value() }, true);
+        slots_event = std::find_if(this->_counters.begin(), this->_counters.end(), is_slots_event);
+      }
+    }
+
+    if (!preferred_group_id.has_value() && slots_event != this->_counters.end() &&
+        slots_event->group_id() >= this->_first_open_group_id) {
+      preferred_group_id = slots_event->group_id();
+    }
+  }
+
+  /// Place all counters together...
+  if (this->add_to_group(counters, is_hidden, preferred_group_id)) {
+    return;
+  }
+
+  /// ... or one by one, if they do not fit into one group.
+  if (counters.size() > 1U) {
+    for (auto& counter : counters) {
+      if (!this->add_to_group({ counter }, is_hidden, preferred_group_id)) {
+        throw std::runtime_error{ "No more space for counters left." };
+      }
+    }
+
+    return;
+  }
+
+  throw std::runtime_error{ "No more space for counters left." };
+}
+
+bool
+perf::EventCounter::add_to_group(const std::vector<std::pair<std::string_view, CounterConfig>>& counters,
+                                 const bool is_hidden,
+                                 const std::optional<std::uint8_t> preferred_group_id)
+{
+  auto group_id = std::optional<std::size_t>{ std::nullopt };
+
+  /// Try the preferred group first, then all open groups, and a new group last.
+  if (preferred_group_id.has_value() && this->is_schedulable(this->_groups[preferred_group_id.value()], counters)) {
+    group_id = preferred_group_id.value();
+  } else {
+    for (auto id = this->_first_open_group_id; id < this->_groups.size(); ++id) {
+      if (this->is_schedulable(this->_groups[id], counters)) {
+        group_id = id;
+        break;
+      }
+    }
+  }
+
+  if (!group_id.has_value()) {
+    if (this->_groups.size() >= this->_config.max_groups() || !this->is_schedulable(Group{}, counters)) {
+      return false;
+    }
+
     this->_groups.emplace_back();
+    group_id = this->_groups.size() - 1U;
+  }
+
+  auto& group = this->_groups[group_id.value()];
+  for (const auto& [counter_name, counter_config] : counters) {
+    this->_counters.emplace_back(counter_name, is_hidden, std::uint8_t(group_id.value()), std::uint8_t(group.size()));
+    group.add(counter_config);
+  }
+
+  return true;
+}
+
+bool
+perf::EventCounter::is_schedulable(const perf::Group& group,
+                                   const std::vector<std::pair<std::string_view, CounterConfig>>& counters) const
+{
+  if (group.size() + counters.size() > Group::MAX_MEMBERS) {
+    return false;
+  }
+
+  /// Pinned and exclusive counters are only grouped with counters that are pinned and exclusive, too.
+  if (!group.empty() || !counters.empty()) {
+    const auto& first = !group.empty() ? group.member(0U).config() : counters.front().second;
+    const auto is_compatible = [&first](const CounterConfig& config) {
+      return config.is_pinned() == first.is_pinned() && config.is_exclusive() == first.is_exclusive();
+    };
+
+    for (auto member_id = 0U; member_id < group.size(); ++member_id) {
+      if (!is_compatible(group.member(member_id).config())) {
+        return false;
+      }
+    }
+
+    if (!std::all_of(counters.begin(), counters.end(), [&is_compatible](const auto& counter) {
+          return is_compatible(counter.second);
+        })) {
+      return false;
+    }
+  }
+
+  /// The slots event (Intel) has to lead its group; topdown metric events are only counted in a group led by slots.
+  if (!group.empty() || !counters.empty()) {
+    const auto& leader = !group.empty() ? group.member(0U).config() : counters.front().second;
+    const auto is_slots_leader = HardwareInfo::is_intel_topdown_slots(leader.type(), leader.event_id());
+    for (auto counter_id = 0U; counter_id < counters.size(); ++counter_id) {
+      const auto& config = counters[counter_id].second;
+      if (HardwareInfo::is_intel_topdown_slots(config.type(), config.event_id()) &&
+          (!group.empty() || counter_id > 0U)) {
+        return false;
+      }
+
+      if (HardwareInfo::is_intel_topdown_metric(config.type(), config.event_id()) && !is_slots_leader) {
+        return false;
+      }
+    }
+  }
+
+  /// Respect the configured maximal number of counters per group, if set.
+  if (this->_config.is_max_counters_per_group_set()) {
+    return group.size() + counters.size() <= this->_config.max_counters_per_group();
+  }
+
+  const auto count_general_purpose_counters = HardwareInfo::count_general_purpose_counters().value_or(4U);
+  const auto count_fixed_counters = HardwareInfo::count_fixed_counters();
+
+  /// Count the general purpose counters needed, assuming that events eligible for fixed counters use them.
+  auto occupied_fixed_counters = std::uint32_t{ 0U };
+  auto occupied_general_purpose_counters = 0U;
+  const auto occupy = [&](const std::uint32_t type, const std::uint64_t event_id) {
+    /// Software events and tracepoints are not counted by the PMU, topdown metric events are derived from slots.
+    if (type == PERF_TYPE_SOFTWARE || type == PERF_TYPE_TRACEPOINT || type == PERF_TYPE_BREAKPOINT ||
+        HardwareInfo::is_intel_topdown_metric(type, event_id)) {
+      return;
+    }
+
+    const auto fixed_counter_id = HardwareInfo::fixed_counter_id(type, event_id);
+    if (fixed_counter_id.has_value() && fixed_counter_id.value() < count_fixed_counters &&
+        (occupied_fixed_counters & (std::uint32_t(1U) << fixed_counter_id.value())) == 0U) {
+      occupied_fixed_counters |= std::uint32_t(1U) << fixed_counter_id.value();
+    } else {
+      ++occupied_general_purpose_counters;
+    }
+  };
+
+  for (auto member_id = 0U; member_id < group.size(); ++member_id) {
+    const auto& member = group.member(member_id);
+    occupy(member.type(), member.event_id());
   }
 
-  const auto group_id = std::uint8_t(this->_groups.size()) - 1U;
-  const auto in_group_id = std::uint8_t(this->_groups.back().size());
-  this->_counters.emplace_back(counter_name, is_hidden, group_id, in_group_id);
-  this->_groups.back().add(counter);
+  for (const auto& counter : counters) {
+    occupy(counter.second.type(), counter.second.event_id());
+  }
+
+  return occupied_general_purpose_counters <= count_general_purpose_counters;
 }
 
 bool
@@ -99,14 +329,51 @@ perf::EventCounter::add(const std::vector<std::string>& counter_names)
   return this->add(std::vector<std::string>(counter_names));
 }
 
+bool
+perf::EventCounter::open()
+{
+  /// Do not open again, if the counters are already opened.
+  if (this->_is_opened) {
+    return true;
+  }
+
+  const auto lock = std::lock_guard{ this->_lifecycle_mutex.get() };
+
+  auto is_every_counter_opened = true;
+  for (auto& group : this->_groups) {
+    is_every_counter_opened &= group.open(this->_config);
+  }
+
+  ++this->_open_generation;
+  this->_is_opened = true;
+  this->_is_close_on_stop = false;
+  this->_count_intervals = 0U;
+
+  return is_every_counter_opened;
+}
+
+void
+perf::EventCounter::close()
+{
+  const auto lock = std::lock_guard{ this->_lifecycle_mutex.get() };
+
+  for (auto& group : this->_groups) {
+    group.close();
+  }
+
+  this->_is_opened = false;
+  this->_is_close_on_stop = false;
+}
+
 bool
 perf::EventCounter::start()
 {
   auto is_every_counter_started = true;
 
-  /// Open the counters.
-  for (auto& group : this->_groups) {
-    is_every_counter_started &= group.open(this->_config);
+  /// Open the counters, if not opened explicitly (they will be closed when stopping).
+  if (!this->_is_opened) {
+    is_every_counter_started = this->open();
+    this->_is_close_on_stop = true;
   }
 
   /// Start the counters.
@@ -127,28 +394,220 @@ perf::EventCounter::stop()
     std::ignore = group.stop();
   }
 
-  /// Close the counters.
+  if (this->_is_opened) {
+    ++this->_count_intervals;
+  }
+
+  /// Close the counters, if they were opened when starting.
+  if (this->_is_close_on_stop) {
+    this->close();
+  }
+}
+
+void
+perf::EventCounter::reset() noexcept
+{
   for (auto& group : this->_groups) {
-    group.close();
+    group.reset();
+  }
+
+  this->_count_intervals = 0U;
+}
+
+bool
+perf::EventCounter::calibrate(const std::size_t count_runs)
+{
+  /// Measure without subtracting a previous calibration.
+  this->_overhead.clear();
+
+  const auto is_opened_by_calibration = !this->_is_opened;
+  if (is_opened_by_calibration && !this->open()) {
+    this->close();
+    return false;
   }
+
+  /// Record the empty region multiple times, keeping the values of every counter.
+  auto values = std::vector<std::vector<double>>(this->_counters.size());
+  for (auto& event_values : values) {
+    event_values.reserve(count_runs);
+  }
+
+  auto is_every_counter_started = true;
+  for (auto run_id = std::size_t{ 0U }; run_id < count_runs && is_every_counter_started; ++run_id) {
+    this->reset();
+    is_every_counter_started = this->start();
+    this->stop();
+
+    for (auto event_id = 0U; event_id < this->_counters.size(); ++event_id) {
+      const auto& event = this->_counters[event_id];
+      if (event.is_counter()) {
+        values[event_id].emplace_back(this->_groups[event.group_id()].get(event.in_group_id()));
+      }
+    }
+  }
+
+  this->reset();
+  if (is_opened_by_calibration) {
+    this->close();
+  }
+
+  if (!is_every_counter_started) {
+    return false;
+  }
+
+  /// The median is robust against interrupts and other noise in single runs.
+  this->_overhead.resize(this->_counters.size(), .0);
+  for (auto event_id = 0U; event_id < this->_counters.size(); ++event_id) {
+    auto& event_values = values[event_id];
+    if (!event_values.empty()) {
+      const auto median = event_values.begin() + std::ptrdiff_t(event_values.size() / 2U);
+      std::nth_element(event_values.begin(), median, event_values.end());
+      this->_overhead[event_id] = *median;
+    }
+  }
+
+  return true;
+}
+
+perf::CounterResult
+perf::EventCounter::calibration() const
+{
+  auto result = std::vector<std::pair<std::string_view, double>>{};
+  if (this->_overhead.empty()) {
+    return CounterResult{ std::move(result) };
+  }
+
+  for (auto event_id = 0U; event_id < this->_counters.size(); ++event_id) {
+    const auto& event = this->_counters[event_id];
+    if (event.is_counter() && !event.is_hidden()) {
+      result.emplace_back(event.name(), this->_overhead[event_id]);
+    }
+  }
+
+  return CounterResult{ std::move(result) };
 }
 
 perf::CounterResult
 perf::EventCounter::result(std::uint64_t normalization) const
+{
+  return this->evaluate(this->counter_values(normalization, false), this->multiplexing(false));
+}
+
+perf::CounterResult
+perf::EventCounter::snapshot(std::uint64_t normalization)
+{
+  for (auto& group : this->_groups) {
+    std::ignore = group.snapshot();
+  }
+
+  return this->evaluate(this->counter_values(normalization, true), this->multiplexing(true));
+}
+
+std::vector<std::pair<std::string_view, perf::CounterResult>>
+perf::EventCounter::result_per_core_type(const std::uint64_t normalization) const
+{
+  auto results = std::vector<std::pair<std::string_view, CounterResult>>{};
+  if (!HardwareInfo::is_hybrid()) {
+    return results;
+  }
+
+  for (const auto& hybrid_pmu : HardwareInfo::hybrid_pmus()) {
+    auto counter_values = this->counter_values(normalization, false, &hybrid_pmu);
+    results.emplace_back(hybrid_pmu.name(), this->evaluate(std::move(counter_values), this->multiplexing(false)));
+  }
+
+  return results;
+}
+
+std::vector<std::pair<std::string_view, double>>
+perf::EventCounter::counter_values(const std::uint64_t normalization,
+                                   const bool is_snapshot,
+                                   const HybridPmu* hybrid_pmu) const
 {
   /// Build result with all counters, including hidden ones.
-  auto temporary_result = std::vector<std::pair<std::string_view, double>>{};
-  temporary_result.reserve(this->_counters.size());
+  auto counter_values = std::vector<std::pair<std::string_view, double>>{};
+  counter_values.reserve(this->_counters.size());
+
+  for (auto event_id = 0U; event_id < this->_counters.size(); ++event_id) {
+    const auto& event = this->_counters[event_id];
+    if (event.is_counter()) {
+      const auto& group = this->_groups[event.group_id()];
+      if (hybrid_pmu != nullptr) {
+        counter_values.emplace_back(event.name(), group.get(event.in_group_id(), *hybrid_pmu) / double(normalization));
+        continue;
+      }
+
+      const auto value = is_snapshot ? group.get_snapshot(event.in_group_id())
+                                     : std::max(group.get(event.in_group_id()) - this->overhead(event_id), .0);
+      counter_values.emplace_back(event.name(), value / double(normalization));
+    }
+  }
+
+  return counter_values;
+}
+
+std::vector<perf::Multiplexing>
+perf::EventCounter::multiplexing(const bool is_snapshot) const
+{
+  auto multiplexing = std::vector<Multiplexing>{};
+  multiplexing.reserve(this->_counters.size());
 
   for (const auto& event : this->_counters) {
     if (event.is_counter()) {
-      const auto value = this->_groups[event.group_id()].get(event.in_group_id()) / double(normalization);
-      temporary_result.emplace_back(event.name(), value);
+      const auto& group = this->_groups[event.group_id()];
+      multiplexing.emplace_back(is_snapshot ? group.multiplexing_snapshot(event.in_group_id())
+                                            : group.multiplexing(event.in_group_id()));
+    }
+  }
+
+  return multiplexing;
+}
+
+perf::CounterResult
+perf::EventCounter::evaluate(std::vector<std::pair<std::string_view, double>>&& counter_values,
+                             std::vector<Multiplexing>&& multiplexing) const
+{
+  /// Flag (or remove) counters that ran on the PMU for less than the configured fraction of time.
+  auto multiplexing_result = std::vector<std::pair<std::string_view, Multiplexing>>{};
+  if (!multiplexing.empty()) {
+    multiplexing_result.reserve(multiplexing.size());
+
+    auto counter_id = 0U;
+    for (const auto& event : this->_counters) {
+      if (event.is_counter()) {
+        auto& counter_multiplexing = multiplexing[counter_id];
+        counter_multiplexing.is_below_threshold(counter_multiplexing.running_ratio() <
+                                                this->_config.min_running_ratio());
+
+        if (!event.is_hidden()) {
+          multiplexing_result.emplace_back(event.name(), counter_multiplexing);
+        }
+
+        ++counter_id;
+      }
+    }
+
+    /// Counter values and multiplexing details share the same index.
+    if (this->_config.multiplexing_policy() == MultiplexingPolicy::Refuse) {
+      auto accepted_counter_values = std::vector<std::pair<std::string_view, double>>{};
+      accepted_counter_values.reserve(counter_values.size());
+      for (auto value_id = 0U; value_id < counter_values.size(); ++value_id) {
+        if (value_id >= multiplexing.size() || !multiplexing[value_id].is_below_threshold()) {
+          accepted_counter_values.emplace_back(counter_values[value_id]);
+        }
+      }
+      counter_values = std::move(accepted_counter_values);
     }
   }
 
+  /// Remove counters without value (e.g., counters that were not opened on the requested core type).
+  counter_values.erase(std::remove_if(counter_values.begin(),
+                                      counter_values.end(),
+                                      [](const auto& counter_value) { return std::isnan(counter_value.second); }),
+                       counter_values.end());
+
   /// Calculate metrics and copy not-hidden counters.
-  auto counter_result = CounterResult{ std::move(temporary_result) };
+  auto counter_result = CounterResult{ std::move(counter_values) };
   auto result = std::vector<std::pair<std::string_view, double>>{};
   result.reserve(this->_counters.size());
 
@@ -164,18 +623,112 @@ perf::EventCounter::result(std::uint64_t normalization) const
     }
 
     /// ... and all metrics.
-    else {
-      auto metric = this->_counter_definitions.metric(event.name());
-      if (metric.has_value()) {
-        const auto value = std::get<1>(metric.value()).calculate(counter_result);
-        if (value.has_value()) {
-          result.emplace_back(std::get<0>(metric.value()), value.value());
+    else if (event.metric() != nullptr) {
+      const auto value = event.metric()->calculate(counter_result);
+      if (value.has_value()) {
+        result.emplace_back(event.name(), value.value());
+      }
+    }
+  }
+
+  return CounterResult{ std::move(result), std::move(multiplexing_result) };
+}
+
+perf::CounterHandle
+perf::EventCounter::handle(const std::string_view name) const
+{
+  for (auto event_id = 0U; event_id < this->_counters.size(); ++event_id) {
+    if (this->_counters[event_id].name() == name) {
+      return CounterHandle{ std::uint16_t(event_id) };
+    }
+  }
+
+  throw std::runtime_error{
+    std::string{ "Cannot find added counter or metric with name '" }.append(name).append("'.")
+  };
+}
+
+void
+perf::EventCounter::result(const perf::EventCounter* event_counters,
+                           const std::size_t count_event_counters,
+                           perf::CounterResultView& result,
+                           const std::uint64_t normalization)
+{
+  const auto& main_counter = event_counters[0U];
+  const auto count_events = main_counter._counters.size();
+  const auto is_refuse_multiplexed = main_counter._config.multiplexing_policy() == MultiplexingPolicy::Refuse &&
+                                     main_counter._config.min_running_ratio() > .0;
+
+  /// Assigning keeps the capacity of the view; memory is only allocated when filling the view the first time.
+  result._values.assign(count_events, .0);
+  if (is_refuse_multiplexed) {
+    result._time_enabled.assign(count_events, 0U);
+    result._time_running.assign(count_events, 0U);
+  }
+
+  /// Aggregate the counter values (and times for the multiplexing policy) over all event counters.
+  for (auto event_counter_id = 0U; event_counter_id < count_event_counters; ++event_counter_id) {
+    const auto& event_counter = event_counters[event_counter_id];
+    for (auto event_id = 0U; event_id < count_events; ++event_id) {
+      const auto& event = event_counter._counters[event_id];
+      if (event.is_counter()) {
+        const auto& group = event_counter._groups[event.group_id()];
+        const auto value = std::max(group.get(event.in_group_id()) - event_counter.overhead(event_id), .0);
+        result._values[event_id] += value / double(normalization);
+
+        if (is_refuse_multiplexed) {
+          const auto multiplexing = group.multiplexing(event.in_group_id());
+          result._time_enabled[event_id] += multiplexing.time_enabled();
+          result._time_running[event_id] += multiplexing.time_running();
         }
       }
     }
   }
 
-  return CounterResult{ std::move(result) };
+  /// Refuse counters with a low running ratio and calculate the metrics from the values of their counters.
+  /// Metrics are always added after the counters they require.
+  for (auto event_id = 0U; event_id < count_events; ++event_id) {
+    const auto& event = main_counter._counters[event_id];
+    if (event.is_counter()) {
+      if (is_refuse_multiplexed) {
+        const auto multiplexing =
+          Multiplexing{ result._values[event_id], result._time_enabled[event_id], result._time_running[event_id] };
+        if (multiplexing.running_ratio() < main_counter._config.min_running_ratio()) {
+          result._values[event_id] = std::numeric_limits<double>::quiet_NaN();
+        }
+      }
+    } else if (event.metric() != nullptr) {
+      const auto& required_counter_ids = event.required_counter_ids();
+      const auto is_every_argument_available =
+        std::none_of(required_counter_ids.begin(), required_counter_ids.end(), [&result](const auto counter_id) {
+          return std::isnan(result._values[counter_id]);
+        });
+
+      if (!is_every_argument_available) {
+        result._values[event_id] = std::numeric_limits<double>::quiet_NaN();
+      }
+
+      /// Expressions are evaluated directly on the values...
+      else if (event.expression() != nullptr) {
+        result._values[event_id] =
+          event.expression()->evaluate([&result, &required_counter_ids](const std::uint16_t counter_id) {
+            return result._values[required_counter_ids[counter_id]];
+          });
+      }
+
+      /// ... other metrics get the values of their counters as arguments.
+      else {
+        result._metric_arguments.clear();
+        for (const auto required_counter_id : required_counter_ids) {
+          result._metric_arguments.emplace_back(result._values[required_counter_id]);
+        }
+
+        result._values[event_id] = event.metric()
+                                     ->calculate_from_values(result._metric_arguments)
+                                     .value_or(std::numeric_limits<double>::quiet_NaN());
+      }
+    }
+  }
 }
 
 bool
@@ -217,73 +770,333 @@ perf::MultiEventCounterBase::add(std::vector<EventCounter>& event_counter,
 
 perf::CounterResult
 perf::MultiEventCounterBase::result(const std::vector<perf::EventCounter>& event_counters,
-                                    const std::uint64_t normalization)
+                                    const std::uint64_t normalization,
+                                    const bool is_snapshot)
 {
-  /// Build result with all counters, including hidden ones.
+  /// Build result with all counters, including hidden ones, aggregated over all event counters.
   const auto& main_perf = event_counters.front();
-  auto temporary_result = std::vector<std::pair<std::string_view, double>>{};
-  temporary_result.reserve(main_perf._counters.size());
+  auto counter_values = main_perf.counter_values(normalization, is_snapshot);
+  auto multiplexing = main_perf.multiplexing(is_snapshot);
 
-  for (const auto& event : main_perf._counters) {
-    if (event.is_counter()) {
-      auto value = .0;
-      for (const auto& thread_local_counter : event_counters) {
-        value += thread_local_counter._groups[event.group_id()].get(event.in_group_id());
-      }
-      const auto normalized_value = value / double(normalization);
-      temporary_result.emplace_back(event.name(), normalized_value);
+  for (auto i = 1U; i < event_counters.size(); ++i) {
+    const auto local_counter_values = event_counters[i].counter_values(normalization, is_snapshot);
+    const auto local_multiplexing = event_counters[i].multiplexing(is_snapshot);
+    for (auto counter_id = 0U; counter_id < counter_values.size(); ++counter_id) {
+      counter_values[counter_id].second += local_counter_values[counter_id].second;
+      multiplexing[counter_id] += local_multiplexing[counter_id];
     }
   }
 
-  /// Calculate metrics and copy not-hidden counters.
-  auto counter_result = CounterResult{ std::move(temporary_result) };
-  auto result = std::vector<std::pair<std::string_view, double>>{};
-  result.reserve(main_perf._counters.size());
+  return main_perf.evaluate(std::move(counter_values), std::move(multiplexing));
+}
 
-  for (const auto& event : main_perf._counters) {
-    /// Add all not hidden counters...
-    if (event.is_counter()) {
-      if (!event.is_hidden()) {
-        const auto value = counter_result.get(event.name());
-        if (value.has_value()) {
-          result.emplace_back(event.name(), value.value());
-        }
-      }
+perf::CounterResult
+perf::MultiEventCounterBase::snapshot(std::vector<perf::EventCounter>& event_counters,
+                                      const std::uint64_t normalization)
+{
+  for (auto& event_counter : event_counters) {
+    for (auto& group : event_counter._groups) {
+      std::ignore = group.snapshot();
     }
+  }
 
-    /// ... and all metrics.
-    else {
-      auto metric = main_perf._counter_definitions.metric(event.name());
-      if (metric.has_value()) {
-        auto value = std::get<1>(metric.value()).calculate(counter_result);
-        if (value.has_value()) {
-          result.emplace_back(std::get<0>(metric.value()), value.value());
-        }
+  return MultiEventCounterBase::result(event_counters, normalization, true);
+}
+
+void
+perf::MultiEventCounterBase::retire(perf::EventCounter& event_counter, perf::EventCounter& retired)
+{
+  for (auto group_id = 0U; group_id < std::min(event_counter._groups.size(), retired._groups.size()); ++group_id) {
+    retired._groups[group_id].add_accumulated(event_counter._groups[group_id]);
+  }
+
+  /// The overhead is subtracted per interval; keep the calibration if the retired counter was not calibrated.
+  retired._count_intervals += event_counter._count_intervals;
+  if (retired._overhead.empty()) {
+    retired._overhead = event_counter._overhead;
+  }
+
+  event_counter.reset();
+}
+
+bool
+perf::MultiEventCounterBase::open(std::vector<perf::EventCounter>& event_counters,
+                                  const bool is_close_on_stop,
+                                  perf::OpenTiming& timing)
+{
+  /// Keep the timing of the last open, if all counters are opened already.
+  if (std::all_of(event_counters.begin(), event_counters.end(), [](const auto& event_counter) {
+        return event_counter.is_open();
+      })) {
+    return true;
+  }
+
+  /// Flags per counter, written by different threads (std::vector<bool> would share bytes).
+  auto is_opened = std::vector<std::uint8_t>(event_counters.size(), 1U);
+
+  const auto open = [&event_counters, &is_opened, is_close_on_stop](const std::size_t event_counter_id) {
+    auto& event_counter = event_counters[event_counter_id];
+    if (!event_counter.is_open()) {
+      is_opened[event_counter_id] = static_cast<std::uint8_t>(event_counter.open());
+      event_counter._is_close_on_stop = is_close_on_stop;
+    }
+  };
+
+  timing = ParallelOpen::open(
+    event_counters.size(), event_counters.front().config().max_open_threads(), [&open]() { open(0U); }, open);
+
+  return std::all_of(
+    is_opened.begin(), is_opened.end(), [](const auto is_counter_opened) { return is_counter_opened == 1U; });
+}
+
+class perf::MultiThreadEventCounter::Registry
+{
+public:
+  /**
+   * Slot of a thread-local counter.
+   */
+  struct Slot
+  {
+    enum State : std::uint8_t
+    {
+      Free,
+      Acquired,
+      Releasing
+    };
+
+    std::atomic<std::uint8_t> state{ Free };
+  };
+
+  Registry(EventCounter* event_counters, const std::uint16_t count_slots)
+    : _event_counters(event_counters)
+    , _slots(count_slots)
+  {
+  }
+
+  ~Registry() = default;
+
+  [[nodiscard]] std::vector<Slot>& slots() noexcept { return _slots; }
+  [[nodiscard]] std::atomic<std::uint64_t>& count_registered_threads() noexcept { return _count_registered_threads; }
+  [[nodiscard]] std::mutex& retire_mutex() noexcept { return _retire_mutex; }
+
+  /**
+   * Closes the thread-local counter of the slot (keeping its values) and frees the slot for other threads.
+   * Called by the thread that acquired the slot when it exits.
+   *
+   * @param thread_id Id of the slot (and its thread-local counter) to release.
+   */
+  void release(const std::uint16_t thread_id)
+  {
+    auto& slot = this->_slots[thread_id];
+    slot.state.store(Slot::Releasing);
+
+    /// The counters are only touched while the MultiThreadEventCounter is alive; it waits for releasing slots.
+    /// The values are kept by the retired counter, such that the next thread starts on a fresh counter.
+    /// Threads that exit concurrently retire into the same counter, one after another.
+    if (this->_is_alive.load()) {
+      const auto lock = std::lock_guard{ this->_retire_mutex };
+      auto& event_counter = this->_event_counters[thread_id];
+      event_counter.close();
+      MultiEventCounterBase::retire(event_counter, this->_event_counters[this->_slots.size()]);
+    }
+
+    slot.state.store(Slot::Free);
+  }
+
+  /**
+   * Detaches the registry from the counters of the destroyed MultiThreadEventCounter, waiting for slots that are
+   * released concurrently.
+   */
+  void detach() noexcept
+  {
+    this->_is_alive.store(false);
+
+    for (auto& slot : this->_slots) {
+      while (slot.state.load() == Slot::Releasing) {
+        std::this_thread::yield();
       }
     }
   }
 
-  return CounterResult{ std::move(result) };
-}
+private:
+  /// Thread-local counters of the MultiThreadEventCounter, one per slot followed by the retired counter (the storage
+  /// stays in place when moving the instance).
+  EventCounter* _event_counters;
+
+  /// One slot per thread-local counter.
+  std::vector<Slot> _slots;
+
+  /// Flag if the MultiThreadEventCounter (and its counters) still exists.
+  std::atomic<bool> _is_alive{ true };
+
+  /// Number of threads that acquired a slot.
+  std::atomic<std::uint64_t> _count_registered_threads{ 0U };
+
+  /// Serializes retiring counters of exiting threads with each other and with reading, stopping, and closing all
+  /// counters (acquiring a slot is lock-free).
+  std::mutex _retire_mutex;
+};
 
 perf::MultiThreadEventCounter::MultiThreadEventCounter(const perf::CounterDefinition& counter_list,
                                                        const std::uint16_t num_threads,
                                                        const perf::Config config)
+  : _instance_id(next_multi_thread_instance_id.fetch_add(1U))
 {
-  this->_thread_local_counter.reserve(num_threads);
-  for (auto i = 0U; i < num_threads; ++i) {
+  /// One more counter accumulates the values of threads that exited.
+  this->_thread_local_counter.reserve(num_threads + 1U);
+  for (auto i = 0U; i < num_threads + 1U; ++i) {
     this->_thread_local_counter.emplace_back(counter_list, config);
   }
+
+  this->_registry = std::make_shared<Registry>(this->_thread_local_counter.data(), num_threads);
 }
 
 perf::MultiThreadEventCounter::MultiThreadEventCounter(perf::EventCounter&& event_counter,
                                                        const std::uint16_t num_threads)
+  : _instance_id(next_multi_thread_instance_id.fetch_add(1U))
 {
-  this->_thread_local_counter.reserve(num_threads);
-  for (auto i = 0U; i < num_threads - 1U; ++i) {
+  /// One more counter accumulates the values of threads that exited.
+  this->_thread_local_counter.reserve(num_threads + 1U);
+  for (auto i = 0U; i < num_threads; ++i) {
     this->_thread_local_counter.push_back(event_counter);
   }
   this->_thread_local_counter.emplace_back(std::move(event_counter));
+
+  this->_registry = std::make_shared<Registry>(this->_thread_local_counter.data(), num_threads);
+}
+
+perf::MultiThreadEventCounter::~MultiThreadEventCounter()
+{
+  /// Threads that exit later must not release their slots into the destroyed counters.
+  if (this->_registry != nullptr) {
+    this->_registry->detach();
+  }
+}
+
+std::uint16_t
+perf::MultiThreadEventCounter::local_thread_id()
+{
+  /**
+   * Slot acquired by the calling thread. The registry is referenced weakly, such that threads do not keep the
+   * registries of destroyed instances alive.
+   */
+  struct ThreadSlot
+  {
+    std::uint64_t instance_id;
+    std::weak_ptr<Registry> registry;
+    std::uint16_t thread_id;
+  };
+
+  /**
+   * Slots acquired by the calling thread (over all instances), released when the thread exits.
+   */
+  struct ThreadSlots
+  {
+    std::vector<ThreadSlot> slots;
+
+    ~ThreadSlots()
+    {
+      for (auto& slot : this->slots) {
+        /// Keep the registry alive until the slot is released; slots of destroyed instances need no release.
+        if (const auto registry = slot.registry.lock(); registry != nullptr) {
+          registry->release(slot.thread_id);
+        }
+      }
+    }
+  };
+  thread_local auto thread_slots = ThreadSlots{};
+
+  /// Last counter acquired by this thread; hit when the thread uses the same instance again.
+  thread_local auto cached_instance_id = std::uint64_t{ 0U };
+  thread_local auto cached_thread_id = std::uint16_t{ 0U };
+
+  if (cached_instance_id == this->_instance_id) {
+    return cached_thread_id;
+  }
+
+  /// Forget the slots of destroyed instances, such that long-living threads (e.g., of a pool) do not accumulate them.
+  thread_slots.slots.erase(std::remove_if(thread_slots.slots.begin(),
+                                          thread_slots.slots.end(),
+                                          [](const auto& slot) { return slot.registry.expired(); }),
+                           thread_slots.slots.end());
+
+  /// Look up a counter that was acquired earlier (e.g., when the thread switched between instances).
+  for (const auto& slot : thread_slots.slots) {
+    if (slot.instance_id == this->_instance_id) {
+      cached_instance_id = this->_instance_id;
+      cached_thread_id = slot.thread_id;
+      return slot.thread_id;
+    }
+  }
+
+  /// Acquire a free counter; counters of exited threads are free again.
+  auto& slots = this->_registry->slots();
+  for (auto thread_id = std::uint16_t{ 0U }; thread_id < slots.size(); ++thread_id) {
+    auto state = std::uint8_t{ Registry::Slot::Free };
+    if (slots[thread_id].state.compare_exchange_strong(state, Registry::Slot::Acquired)) {
+      thread_slots.slots.emplace_back(ThreadSlot{ this->_instance_id, this->_registry, thread_id });
+      this->_registry->count_registered_threads().fetch_add(1U);
+
+      cached_instance_id = this->_instance_id;
+      cached_thread_id = thread_id;
+      return thread_id;
+    }
+  }
+
+  throw std::runtime_error{ "No more thread-local counters left; increase the number of threads." };
+}
+
+std::uint64_t
+perf::MultiThreadEventCounter::count_registered_threads() const noexcept
+{
+  return this->_registry != nullptr ? this->_registry->count_registered_threads().load() : 0U;
+}
+
+void
+perf::MultiThreadEventCounter::close()
+{
+  /// Threads that exit concurrently close and retire their counters.
+  const auto lock = std::lock_guard{ this->_registry->retire_mutex() };
+  for (auto& event_counter : this->_thread_local_counter) {
+    event_counter.close();
+  }
+}
+
+void
+perf::MultiThreadEventCounter::stop()
+{
+  const auto lock = std::lock_guard{ this->_registry->retire_mutex() };
+  for (auto& event_counter : this->_thread_local_counter) {
+    event_counter.stop();
+  }
+}
+
+perf::CounterResult
+perf::MultiThreadEventCounter::result(const std::uint64_t normalization) const
+{
+  const auto lock = std::lock_guard{ this->_registry->retire_mutex() };
+  return MultiEventCounterBase::result(this->_thread_local_counter, normalization);
+}
+
+void
+perf::MultiThreadEventCounter::result(perf::CounterResultView& result, const std::uint64_t normalization) const
+{
+  const auto lock = std::lock_guard{ this->_registry->retire_mutex() };
+  MultiEventCounterBase::result(this->_thread_local_counter, result, normalization);
+}
+
+perf::CounterResult
+perf::MultiThreadEventCounter::snapshot(const std::uint64_t normalization)
+{
+  const auto lock = std::lock_guard{ this->_registry->retire_mutex() };
+  return MultiEventCounterBase::snapshot(this->_thread_local_counter, normalization);
+}
+
+perf::CounterResult
+perf::MultiThreadEventCounter::result_of_thread(const std::uint16_t thread_id, const std::uint64_t normalization) const
+{
+  const auto lock = std::lock_guard{ this->_registry->retire_mutex() };
+  return this->_thread_local_counter[thread_id].result(normalization);
 }
 
 perf::MultiProcessEventCounter::MultiProcessEventCounter(const perf::CounterDefinition& counter_list,
@@ -317,6 +1130,25 @@ perf::MultiProcessEventCounter::MultiProcessEventCounter(perf::EventCounter&& ev
   this->_process_local_counter.emplace_back(std::move(event_counter));
 }
 
+bool
+perf::MultiProcessEventCounter::open()
+{
+  auto is_all_opened = true;
+  for (auto& event_counter : this->_process_local_counter) {
+    is_all_opened &= event_counter.open();
+  }
+
+  return is_all_opened;
+}
+
+void
+perf::MultiProcessEventCounter::close()
+{
+  for (auto& event_counter : this->_process_local_counter) {
+    event_counter.close();
+  }
+}
+
 bool
 perf::MultiProcessEventCounter::start()
 {
@@ -350,6 +1182,22 @@ perf::MultiCoreEventCounter::MultiCoreEventCounter(const perf::CounterDefinition
   }
 }
 
+perf::MultiCoreEventCounter::MultiCoreEventCounter(const perf::CounterDefinition& counter_list,
+                                                   const perf::CgroupHandle& cgroup,
+                                                   std::vector<std::uint16_t>&& cpu_ids,
+                                                   perf::Config config)
+{
+  /// Record every process of the cgroup on the given CPUs.
+  config.cgroup_file_descriptor(cgroup.file_descriptor());
+
+  this->_cpu_local_counter.reserve(cpu_ids.size());
+
+  for (const auto cpu_id : cpu_ids) {
+    config.cpu_id(cpu_id);
+    this->_cpu_local_counter.emplace_back(counter_list, config);
+  }
+}
+
 perf::MultiCoreEventCounter::MultiCoreEventCounter(perf::EventCounter&& event_counter,
                                                    std::vector<std::uint16_t>&& cpu_ids)
 {
@@ -370,10 +1218,25 @@ perf::MultiCoreEventCounter::MultiCoreEventCounter(perf::EventCounter&& event_co
   this->_cpu_local_counter.push_back(std::move(event_counter));
 }
 
+bool
+perf::MultiCoreEventCounter::open()
+{
+  return MultiEventCounterBase::open(this->_cpu_local_counter, false, this->_open_timing);
+}
+
+void
+perf::MultiCoreEventCounter::close()
+{
+  for (auto& event_counter : this->_cpu_local_counter) {
+    event_counter.close();
+  }
+}
+
 bool
 perf::MultiCoreEventCounter::start()
 {
-  auto is_all_started = true;
+  /// Open the counters of all cores in parallel (if not opened explicitly) before starting them one by one.
+  auto is_all_started = MultiEventCounterBase::open(this->_cpu_local_counter, true, this->_open_timing);
   for (auto& event_counter : this->_cpu_local_counter) {
     is_all_started &= event_counter.start();
   }
@@ -387,4 +1250,200 @@ perf::MultiCoreEventCounter::stop()
   for (auto& event_counter : this->_cpu_local_counter) {
     event_counter.stop();
   }
-}
\ No newline at end of file
+}
+
+bool
+perf::AttachedProcessEventCounter::add(std::vector<std::string>&& counter_names)
+{
+  /// Threads discovered before get the counters, too.
+  if (!this->_thread_local_counter.empty() &&
+      !MultiEventCounterBase::add(this->_thread_local_counter, counter_names)) {
+    return false;
+  }
+
+  return this->_event_counter.add(std::move(counter_names));
+}
+
+bool
+perf::AttachedProcessEventCounter::open()
+{
+  if (!this->_is_opened) {
+    this->_is_opened = true;
+    this->_is_close_on_stop = false;
+
+    const auto thread_ids = AttachedProcessEventCounter::read_thread_ids(this->_process_id);
+    this->detect_exited_threads(thread_ids);
+
+    /// Open the counters of threads that were discovered before and are still alive. Counters of exited threads stay
+    /// closed: Opening them fails and would reset their final values.
+    for (auto index = 0U; index < this->_thread_local_counter.size(); ++index) {
+      auto& event_counter = this->_thread_local_counter[index];
+      if (this->_is_thread_alive[index] && !AttachedProcessEventCounter::open(event_counter, false)) {
+        this->_is_thread_alive[index] = false;
+      }
+    }
+
+    /// ... and discover (and open) the new threads.
+    std::ignore = this->rescan(thread_ids);
+  }
+
+  return std::find(this->_is_thread_alive.begin(), this->_is_thread_alive.end(), true) != this->_is_thread_alive.end();
+}
+
+void
+perf::AttachedProcessEventCounter::close()
+{
+  for (auto& event_counter : this->_thread_local_counter) {
+    event_counter.close();
+  }
+
+  this->_is_opened = false;
+  this->_is_close_on_stop = false;
+}
+
+bool
+perf::AttachedProcessEventCounter::start()
+{
+  /// Open the counters, if not opened explicitly (they will be closed when stopping).
+  if (!this->_is_opened) {
+    std::ignore = this->open();
+    this->_is_close_on_stop = true;
+  }
+
+  /// Start the counters of the live threads only; starting a closed counter of an exited thread would open it.
+  auto is_any_started = false;
+  auto is_all_started = true;
+  for (auto index = 0U; index < this->_thread_local_counter.size(); ++index) {
+    if (this->_is_thread_alive[index]) {
+      const auto is_started = this->_thread_local_counter[index].start();
+      is_any_started |= is_started;
+      is_all_started &= is_started;
+    }
+  }
+  this->_is_running = true;
+
+  return is_any_started && is_all_started;
+}
+
+void
+perf::AttachedProcessEventCounter::stop()
+{
+  /// Threads that exited while running are stopped, too, such that their final values are read.
+  for (auto& event_counter : this->_thread_local_counter) {
+    event_counter.stop();
+  }
+  this->_is_running = false;
+
+  if (this->_is_close_on_stop) {
+    this->close();
+  }
+}
+
+std::size_t
+perf::AttachedProcessEventCounter::rescan()
+{
+  const auto thread_ids = AttachedProcessEventCounter::read_thread_ids(this->_process_id);
+  this->detect_exited_threads(thread_ids);
+
+  return this->rescan(thread_ids);
+}
+
+std::size_t
+perf::AttachedProcessEventCounter::rescan(const std::vector<pid_t>& thread_ids)
+{
+  auto count_new_threads = std::size_t{ 0U };
+
+  for (const auto thread_id : thread_ids) {
+    /// The id of an exited thread may be reused by a new thread, which gets a new counter.
+    auto is_known = false;
+    for (auto index = 0U; index < this->_thread_ids.size(); ++index) {
+      is_known |= this->_is_thread_alive[index] && this->_thread_ids[index] == thread_id;
+    }
+    if (is_known) {
+      continue;
+    }
+
+    auto config = this->_event_counter.config();
+    config.process_id(thread_id);
+    auto thread_local_counter = EventCounter{ this->_event_counter };
+    thread_local_counter.config(config);
+
+    /// The thread may have exited since listing the threads; skip it in that case.
+    if (this->_is_opened && !AttachedProcessEventCounter::open(thread_local_counter, this->_is_running)) {
+      continue;
+    }
+
+    this->_thread_ids.emplace_back(thread_id);
+    this->_thread_local_counter.emplace_back(std::move(thread_local_counter));
+    this->_is_thread_alive.emplace_back(true);
+    ++count_new_threads;
+  }
+
+  return count_new_threads;
+}
+
+void
+perf::AttachedProcessEventCounter::detect_exited_threads(const std::vector<pid_t>& thread_ids)
+{
+  /// Counters of exited threads are kept (opened until closed), but never opened or started again.
+  for (auto index = 0U; index < this->_thread_ids.size(); ++index) {
+    if (this->_is_thread_alive[index] &&
+        !std::binary_search(thread_ids.begin(), thread_ids.end(), this->_thread_ids[index])) {
+      this->_is_thread_alive[index] = false;
+    }
+  }
+}
+
+bool
+perf::AttachedProcessEventCounter::open(perf::EventCounter& event_counter, const bool is_start)
+{
+  try {
+    if (event_counter.open() && (!is_start || event_counter.start())) {
+      return true;
+    }
+  } catch (std::runtime_error&) {
+    /// The thread exited (e.g., since listing the threads).
+  }
+
+  event_counter.close();
+  return false;
+}
+
+std::optional<perf::CounterResult>
+perf::AttachedProcessEventCounter::result(const pid_t thread_id, const std::uint64_t normalization) const
+{
+  /// Look up the latest thread with the given id (ids of exited threads may be reused).
+  const auto iterator = std::find(this->_thread_ids.rbegin(), this->_thread_ids.rend(), thread_id);
+  if (iterator == this->_thread_ids.rend()) {
+    return std::nullopt;
+  }
+
+  return this->_thread_local_counter[std::size_t(std::distance(iterator, this->_thread_ids.rend())) - 1U].result(
+    normalization);
+}
+
+std::vector<pid_t>
+perf::AttachedProcessEventCounter::read_thread_ids(const pid_t process_id)
+{
+  const auto path = std::string{ "/proc/" }.append(std::to_string(process_id)).append("/task");
+  auto* directory = ::opendir(path.c_str());
+  if (directory == nullptr) {
+    throw std::runtime_error{ std::string{ "Cannot list threads of process " }
+                                .append(std::to_string(process_id))
+                                .append(" (error no: ")
+                                .append(std::to_string(errno))
+                                .append(").") };
+  }
+
+  auto thread_ids = std::vector<pid_t>{};
+  while (const auto* entry = ::readdir(directory)) {
+    /// Skip "." and "..".
+    if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+      thread_ids.emplace_back(pid_t(std::strtol(entry->d_name, nullptr, 10)));
+    }
+  }
+  ::closedir(directory);
+
+  std::sort(thread_ids.begin(), thread_ids.end());
+  return thread_ids;
+}
@@ -1,19 +1,86 @@
+#include <algorithm>
 #include <asm/unistd.h>
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <perfcpp/group.h>
 #include <stdexcept>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <unistd.h>
+#include <utility>
 
 using namespace perf;
 
+namespace {
+/**
+ * @return Id of the calling thread, cached per thread such that reading via rdpmc needs no syscall.
+ */
+pid_t
+current_thread_id() noexcept
+{
+  thread_local const auto thread_id = static_cast<pid_t>(::syscall(__NR_gettid));
+  return thread_id;
+}
+}
+
 bool
 perf::Group::open(const perf::Config config)
+{
+  /// On hybrid processors, generic hardware events only count on the core PMU they are bound to. Open one instance of
+  /// the group per core PMU: this group is bound to the first PMU, copies of the members to the others.
+  this->_hybrid_groups.clear();
+  this->_hybrid_pmu = nullptr;
+
+  const auto hybrid_pmus = this->hybrid_pmus(config);
+  if (!hybrid_pmus.empty()) {
+    this->_hybrid_pmu = hybrid_pmus.front();
+
+    this->_hybrid_groups.reserve(hybrid_pmus.size() - 1U);
+    for (auto pmu_id = 1U; pmu_id < hybrid_pmus.size(); ++pmu_id) {
+      auto& hybrid_group = this->_hybrid_groups.emplace_back();
+      for (const auto& counter : this->_members) {
+        hybrid_group.add(counter.config());
+      }
+      hybrid_group._hybrid_pmu = hybrid_pmus[pmu_id];
+    }
+  }
+
+  auto is_all_open = this->open_members(config);
+  for (auto& hybrid_group : this->_hybrid_groups) {
+    is_all_open &= hybrid_group.open_members(config);
+  }
+
+  return is_all_open;
+}
+
+bool
+perf::Group::open_members(const perf::Config& config)
 {
   /// File descriptor of the group leader.
   auto leader_file_descriptor = std::int64_t{ -1 };
 
+  /// Values will be accumulated from (re-)opening the group.
+  this->reset();
+
+  /// Pinning and exclusivity are properties of the group (set on the leader only).
+  this->_is_pinned = config.is_pinned() || std::any_of(this->_members.begin(),
+                                                       this->_members.end(),
+                                                       [](const auto& counter) { return counter.is_pinned(); });
+  const auto is_exclusive =
+    config.is_exclusive() ||
+    std::any_of(this->_members.begin(), this->_members.end(), [](const auto& counter) { return counter.is_exclusive(); });
+  this->_is_in_error_state = false;
+
+  /// Counters of a cgroup are opened with the file descriptor of the cgroup instead of a process id.
+  /// The kernel accepts cgroup counters only per CPU core.
+  if (config.cgroup_file_descriptor().has_value() && !config.cpu_id().has_value()) {
+    throw std::runtime_error{ "Recording a cgroup requires a specific CPU core (e.g., via MultiCoreEventCounter)." };
+  }
+  const auto process_id = config.cgroup_file_descriptor().value_or(config.process_id());
+  const auto flags = config.cgroup_file_descriptor().has_value() ? PERF_FLAG_PID_CGROUP : 0UL;
+
   auto is_all_open = true;
 
   for (auto& counter : this->_members) {
@@ -28,7 +95,12 @@ perf::Group::open(const perf::Config config)
     perf_event.config = counter.event_id();
     perf_event.config1 = counter.event_id_extension()[0U];
     perf_event.config2 = counter.event_id_extension()[1U];
+    if (this->_hybrid_pmu != nullptr) {
+      this->_hybrid_pmu->bind(perf_event);
+    }
     perf_event.disabled = is_leader;
+    perf_event.pinned = static_cast<std::uint64_t>(is_leader && this->_is_pinned);
+    perf_event.exclusive = static_cast<std::uint64_t>(is_leader && is_exclusive);
     perf_event.inherit = static_cast<std::int32_t>(config.is_include_child_threads());
     perf_event.exclude_kernel = static_cast<std::int32_t>(!config.is_include_kernel());
     perf_event.exclude_user = static_cast<std::int32_t>(!config.is_include_user());
@@ -46,7 +118,7 @@ perf::Group::open(const perf::Config config)
     /// Open the counter.
     const std::int32_t cpu_id = config.cpu_id().has_value() ? std::int32_t{ config.cpu_id().value() } : -1;
     const std::int64_t file_descriptor =
-      syscall(__NR_perf_event_open, &perf_event, config.process_id(), cpu_id, leader_file_descriptor, 0);
+      syscall(__NR_perf_event_open, &perf_event, process_id, cpu_id, leader_file_descriptor, flags);
     counter.file_descriptor(file_descriptor);
 
     /// Print debug output, if requested.
@@ -68,13 +140,62 @@ perf::Group::open(const perf::Config config)
     is_all_open &= counter.is_open();
   }
 
+  /// Map the first page of every counter to read the values from user-space via rdpmc.
+  /// This is only possible if the counters monitor the calling thread (rdpmc reads the counters of the current CPU).
+#if defined(__x86_64__) || defined(__i386__)
+  this->_is_read_with_rdpmc = is_all_open && config.is_read_with_rdpmc() && config.process_id() == 0 &&
+                              !config.cpu_id().has_value() && !config.is_include_child_threads();
+
+  /// Topdown metric events (Intel) report the index of the PERF_METRICS register, which holds the fractions of all
+  /// metrics instead of a count; only read() translates them into slots.
+  this->_is_read_with_rdpmc &= std::none_of(this->_members.begin(), this->_members.end(), [](const auto& counter) {
+    return HardwareInfo::is_intel_topdown_metric(counter.type(), counter.event_id());
+  });
+
+  if (this->_is_read_with_rdpmc) {
+    for (auto& counter : this->_members) {
+      auto* user_page =
+        ::mmap(nullptr, 4096U, PROT_READ, MAP_SHARED, static_cast<std::int32_t>(counter.file_descriptor()), 0);
+      if (user_page != MAP_FAILED) {
+        counter.user_page(reinterpret_cast<perf_event_mmap_page*>(user_page));
+      } else {
+        /// Fall back to read() if any of the counters cannot be mapped.
+        this->_is_read_with_rdpmc = false;
+      }
+    }
+  }
+
+  if (this->_is_read_with_rdpmc) {
+    this->_rdpmc_thread_id = current_thread_id();
+  }
+
+  /// Groups read via rdpmc stay enabled until closing: start() and stop() only read the values (and take their
+  /// difference), which saves the enable/disable syscalls around every recorded interval.
+  if (this->_is_read_with_rdpmc) {
+    ::ioctl(this->leader_file_descriptor(), PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+
   return is_all_open;
 }
 
 void
 perf::Group::close()
 {
+  /// Instances on further core PMUs are kept (but closed), such that their values can be read after closing.
+  for (auto& hybrid_group : this->_hybrid_groups) {
+    hybrid_group.close();
+  }
+
+  this->_is_read_with_rdpmc = false;
+  this->_is_running = false;
+
   for (auto& counter : this->_members) {
+    if (counter.user_page() != nullptr) {
+      ::munmap(counter.user_page(), 4096U);
+      counter.user_page(nullptr);
+    }
+
     if (counter.is_open()) {
       ::close(static_cast<std::int32_t>(counter.file_descriptor()));
       counter.file_descriptor(-1);
@@ -89,13 +210,21 @@ perf::Group::start()
     throw std::runtime_error{ "Cannot start an empty group." };
   }
 
-  const auto leader_file_descriptor = this->leader_file_descriptor();
+  /// Counters are not reset since the values are calculated as difference between start and stop.
+  /// Groups read via rdpmc are already enabled since opening.
+  if (!this->_is_read_with_rdpmc) {
+    ::ioctl(this->leader_file_descriptor(), PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  this->_is_running = this->read(this->_start_value);
+  this->throw_if_in_error_state();
 
-  ::ioctl(leader_file_descriptor, PERF_EVENT_IOC_RESET, 0);
-  ::ioctl(leader_file_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+  auto is_started = this->_is_running;
+  for (auto& hybrid_group : this->_hybrid_groups) {
+    is_started &= hybrid_group.start();
+  }
 
-  const auto read_size = ::read(leader_file_descriptor, &this->_start_value, sizeof(read_format));
-  return read_size > 0U;
+  return is_started;
 }
 
 bool
@@ -105,34 +234,401 @@ perf::Group::stop()
     return false;
   }
 
-  const auto leader_file_descriptor = this->leader_file_descriptor();
+  auto is_read = this->read(this->_end_value);
+  if (!this->_is_read_with_rdpmc) {
+    ::ioctl(this->leader_file_descriptor(), PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  if (std::exchange(this->_is_running, false) && is_read) {
+    this->accumulate(this->_start_value, this->_end_value, this->_accumulated);
+  }
+
+  for (auto& hybrid_group : this->_hybrid_groups) {
+    is_read &= hybrid_group.stop();
+  }
+
+  this->throw_if_in_error_state();
+
+  return is_read;
+}
+
+void
+perf::Group::reset() noexcept
+{
+  this->_accumulated = accumulated_value{};
+
+  for (auto& hybrid_group : this->_hybrid_groups) {
+    hybrid_group.reset();
+  }
+}
+
+void
+perf::Group::add_accumulated(const perf::Group& other) noexcept
+{
+  /// Instances on core PMUs of hybrid processors share the enabled time, values and running times add up (see
+  /// merged_multiplexing()).
+  auto time_enabled = other._accumulated.time_enabled;
+  auto time_running = other._accumulated.time_running;
+  for (auto index = 0U; index < MAX_MEMBERS; ++index) {
+    this->_accumulated.values[index] += other._accumulated.values[index];
+  }
+
+  for (const auto& hybrid_group : other._hybrid_groups) {
+    time_enabled = std::max(time_enabled, hybrid_group._accumulated.time_enabled);
+    time_running += hybrid_group._accumulated.time_running;
+    for (auto index = 0U; index < MAX_MEMBERS; ++index) {
+      this->_accumulated.values[index] += hybrid_group._accumulated.values[index];
+    }
+  }
+
+  this->_accumulated.time_enabled += time_enabled;
+  this->_accumulated.time_running += std::min(time_running, time_enabled);
+}
+
+bool
+perf::Group::snapshot()
+{
+  auto is_read = true;
+  for (auto& hybrid_group : this->_hybrid_groups) {
+    is_read &= hybrid_group.snapshot();
+  }
+
+  return this->snapshot_members() && is_read;
+}
+
+bool
+perf::Group::snapshot_members()
+{
+  this->_snapshot = this->_accumulated;
+
+  /// If the group is not running, the accumulated values are up-to-date.
+  if (!this->_is_running) {
+    return true;
+  }
+
+  auto current_value = read_format{};
+  const auto read_size = ::read(this->leader_file_descriptor(), &current_value, sizeof(read_format));
+  if (read_size > 0) {
+    this->accumulate(this->_start_value, current_value, this->_snapshot);
+    return true;
+  }
+
+  if (read_size == 0 && this->_is_pinned) {
+    this->_is_in_error_state = true;
+    this->throw_if_in_error_state();
+  }
+
+  return false;
+}
+
+bool
+perf::Group::read_counts(perf::Group::Counts& counts) const
+{
+  counts = Counts{};
+
+  /// Instances on core PMUs of hybrid processors share the enabled time, values and running times add up (see
+  /// merged_multiplexing()).
+  auto is_read = this->read_counts_members(counts);
+  for (const auto& hybrid_group : this->_hybrid_groups) {
+    is_read &= hybrid_group.read_counts_members(counts);
+  }
+  counts.time_running = std::min(counts.time_running, counts.time_enabled);
+
+  return is_read;
+}
+
+bool
+perf::Group::read_counts_members(perf::Group::Counts& counts) const
+{
+  if (this->_members.empty() || !this->_members.front().is_open()) {
+    return false;
+  }
+
+  auto value = read_format{};
+  if (::read(this->leader_file_descriptor(), &value, sizeof(read_format)) <= 0) {
+    return false;
+  }
+
+  counts.time_enabled = std::max(counts.time_enabled, value.time_enabled);
+  counts.time_running += value.time_running;
+  for (auto index = 0U; index < std::min<std::size_t>(this->_members.size(), MAX_MEMBERS); ++index) {
+    counts.values[index] += Group::value_for_id(value, this->_members[index].id()).value_or(0U);
+  }
+
+  return true;
+}
+
+void
+perf::Group::accumulate(const perf::Group::read_format& start_value,
+                        const perf::Group::read_format& end_value,
+                        perf::Group::accumulated_value& accumulated) const
+{
+  accumulated.time_enabled += end_value.time_enabled - start_value.time_enabled;
+  accumulated.time_running += end_value.time_running - start_value.time_running;
+
+  for (auto index = 0U; index < std::min<std::size_t>(this->_members.size(), MAX_MEMBERS); ++index) {
+    const auto id = this->_members[index].id();
+    const auto start = Group::value_for_id(start_value, id);
+    const auto end = Group::value_for_id(end_value, id);
+
+    if (start.has_value() && end.has_value() && end.value() > start.value()) {
+      accumulated.values[index] += end.value() - start.value();
+    }
+  }
+}
+bool
+perf::Group::read(perf::Group::read_format& value)
+{
+  /// A pinned group that is not running all the time it is enabled may be in error state, which only read() reports.
+  /// Threads other than the opening one (e.g., when another thread starts or stops the group) would read the counters
+  /// of their own CPU via rdpmc and, therefore, use read().
+  if (this->_is_read_with_rdpmc && this->_rdpmc_thread_id == current_thread_id() && this->read_with_rdpmc(value) &&
+      (!this->_is_pinned || value.time_running >= value.time_enabled)) {
+    return true;
+  }
+
+  const auto read_size = ::read(this->leader_file_descriptor(), &value, sizeof(read_format));
+
+  /// Pinned groups that cannot be scheduled on the PMU go into error state; read() returns EOF.
+  if (read_size == 0 && this->_is_pinned) {
+    this->_is_in_error_state = true;
+  }
+
+  return read_size > 0;
+}
+
+void
+perf::Group::throw_if_in_error_state() const
+{
+  if (this->_is_in_error_state) {
+    throw std::runtime_error{ "Pinned counter group is in error state, it could not be scheduled on the PMU." };
+  }
+}
+
+bool
+perf::Group::read_with_rdpmc(perf::Group::read_format& value) const noexcept
+{
+  if (this->_members.size() > MAX_MEMBERS) {
+    return false;
+  }
+
+  value.count_members = this->_members.size();
+
+  for (auto index = 0U; index < this->_members.size(); ++index) {
+    const auto& counter = this->_members[index];
+
+    auto time_enabled = std::uint64_t{ 0U };
+    auto time_running = std::uint64_t{ 0U };
+    if (!Group::read_with_rdpmc(counter.user_page(), value.values[index].value, time_enabled, time_running)) {
+      return false;
+    }
+    value.values[index].id = counter.id();
+
+    /// Time enabled and running are reported for the group leader.
+    if (index == 0U) {
+      value.time_enabled = time_enabled;
+      value.time_running = time_running;
+    }
+  }
+
+  return true;
+}
+
+bool
+perf::Group::read_with_rdpmc([[maybe_unused]] const perf_event_mmap_page* user_page,
+                             [[maybe_unused]] std::uint64_t& value,
+                             [[maybe_unused]] std::uint64_t& time_enabled,
+                             [[maybe_unused]] std::uint64_t& time_running) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (user_page == nullptr) {
+    return false;
+  }
+
+  /// See the documentation of struct perf_event_mmap_page in linux/perf_event.h for the protocol.
+  const volatile auto* page = user_page;
+
+  std::uint32_t sequence, index;
+  std::uint64_t count, pmc{ 0U }, cycles{ 0U }, time_offset{ 0U };
+  std::uint32_t time_mult{ 0U };
+  std::uint16_t time_shift{ 0U }, pmc_width{ 0U };
+  bool is_rdpmc_allowed, is_user_time;
+
+  do {
+    sequence = page->lock;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    is_rdpmc_allowed = page->cap_user_rdpmc;
+    is_user_time = page->cap_user_time;
+
+    /// Without rdpmc capability, the offset is not updated while the counter runs; read() is needed.
+    if (!is_rdpmc_allowed) {
+      return false;
+    }
+
+    time_enabled = page->time_enabled;
+    time_running = page->time_running;
+
+    if (is_user_time) {
+      std::uint32_t low, high;
+      asm volatile("rdtsc" : "=a"(low), "=d"(high));
+      cycles = (std::uint64_t(high) << 32U) | low;
+      time_offset = page->time_offset;
+      time_mult = page->time_mult;
+      time_shift = page->time_shift;
+    }
+
+    index = page->index;
+    count = page->offset;
+
+    if (index > 0U) {
+      pmc_width = page->pmc_width;
+
+      std::uint32_t low, high;
+      asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(index - 1U));
+      pmc = (std::uint64_t(high) << 32U) | low;
+    }
+
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  } while (page->lock != sequence);
+
+  /// Sign-extend the hardware counter value to the width of the counter.
+  if (index > 0U) {
+    const auto shift = 64U - pmc_width;
+    count += std::uint64_t(std::int64_t(pmc << shift) >> shift);
+  }
+
+  /// Extrapolate time enabled and running since the last update of the page.
+  if (is_user_time) {
+    const auto quotient = cycles >> time_shift;
+    const auto remainder = cycles & ((std::uint64_t{ 1U } << time_shift) - 1U);
+    const auto delta = time_offset + quotient * time_mult + ((remainder * time_mult) >> time_shift);
+
+    time_enabled += delta;
+    if (index > 0U) {
+      time_running += delta;
+    }
+  }
 
-  const auto read_size = ::read(leader_file_descriptor, &this->_end_value, sizeof(read_format));
-  ioctl(leader_file_descriptor, PERF_EVENT_IOC_DISABLE, 0);
-  return read_size > 0U;
+  value = count;
+  return true;
+#else
+  return false;
+#endif
 }
 
 bool
 perf::Group::add(perf::CounterConfig counter)
 {
+  if (this->_members.size() >= MAX_MEMBERS) {
+    return false;
+  }
+
   this->_members.emplace_back(counter);
   return true;
 }
 
 double
-perf::Group::get(const std::size_t index) const
+perf::Group::get(const std::size_t index, const perf::HybridPmu& hybrid_pmu) const
 {
-  const auto multiplexing_correction = double(this->_end_value.time_enabled - this->_start_value.time_enabled) /
-                                       double(this->_end_value.time_running - this->_start_value.time_running);
+  /// The share of each core PMU is extrapolated with the merged times, such that the shares sum up to get().
+  const auto merged = this->merged_multiplexing(index, false);
+  const auto multiplexing_correction =
+    merged.time_running() > 0U ? double(merged.time_enabled()) / double(merged.time_running()) : 1.0;
+
+  if (this->_hybrid_pmu == &hybrid_pmu) {
+    return this->_accumulated.multiplexing(index).raw_value() * multiplexing_correction;
+  }
+
+  for (const auto& hybrid_group : this->_hybrid_groups) {
+    if (hybrid_group._hybrid_pmu == &hybrid_pmu) {
+      return hybrid_group._accumulated.multiplexing(index).raw_value() * multiplexing_correction;
+    }
+  }
+
+  return std::numeric_limits<double>::quiet_NaN();
+}
 
-  const auto& counter = this->_members[index];
-  const auto start_value = Group::value_for_id(this->_start_value, counter.id());
-  const auto end_value = Group::value_for_id(this->_end_value, counter.id());
+std::vector<const perf::HybridPmu*>
+perf::Group::hybrid_pmus(const perf::Config& config) const
+{
+  auto hybrid_pmus = std::vector<const HybridPmu*>{};
 
-  if (start_value.has_value() && end_value.has_value()) {
-    const auto result = double(end_value.value() - start_value.value());
-    return result > .0 ? result * multiplexing_correction : .0;
+  const auto& core_pmus = HardwareInfo::hybrid_pmus();
+  if (core_pmus.size() < 2U) {
+    return hybrid_pmus;
+  }
+
+  /// Software events are counted with any group; events of other PMUs (e.g., raw events) leave the group unbound.
+  auto is_generic = false;
+  const HybridPmu* bound_pmu = nullptr;
+  for (const auto& counter : this->_members) {
+    if (HybridPmu::is_generic_event(counter.type(), counter.event_id())) {
+      is_generic = true;
+    } else if (counter.type() != PERF_TYPE_SOFTWARE) {
+      const auto core_pmu = std::find_if(
+        core_pmus.begin(), core_pmus.end(), [&counter](const auto& pmu) { return pmu.type() == counter.type(); });
+      if (core_pmu == core_pmus.end()) {
+        return hybrid_pmus;
+      }
+      bound_pmu = &*core_pmu;
+    }
+  }
+
+  if (bound_pmu != nullptr) {
+    hybrid_pmus.emplace_back(bound_pmu);
+  } else if (is_generic) {
+    for (const auto& core_pmu : core_pmus) {
+      if (!config.cpu_id().has_value() || core_pmu.is_serving(config.cpu_id().value())) {
+        hybrid_pmus.emplace_back(&core_pmu);
+      }
+    }
+  }
+
+  return hybrid_pmus;
+}
+
+perf::Multiplexing
+perf::Group::merged_multiplexing(const std::size_t index, const bool is_snapshot) const
+{
+  const auto multiplexing = is_snapshot ? this->_snapshot.multiplexing(index) : this->_accumulated.multiplexing(index);
+  if (this->_hybrid_groups.empty()) {
+    return multiplexing;
+  }
+
+  auto raw_value = multiplexing.raw_value();
+  auto time_enabled = multiplexing.time_enabled();
+  auto time_running = multiplexing.time_running();
+  for (const auto& hybrid_group : this->_hybrid_groups) {
+    const auto hybrid_multiplexing =
+      is_snapshot ? hybrid_group._snapshot.multiplexing(index) : hybrid_group._accumulated.multiplexing(index);
+    raw_value += hybrid_multiplexing.raw_value();
+    time_enabled = std::max(time_enabled, hybrid_multiplexing.time_enabled());
+    time_running += hybrid_multiplexing.time_running();
+  }
+
+  return Multiplexing{ raw_value, time_enabled, std::min(time_running, time_enabled) };
+}
+
+double
+perf::Group::accumulated_value::get(const std::size_t index) const noexcept
+{
+  if (index >= MAX_MEMBERS) {
+    return 0;
+  }
+
+  const auto multiplexing_correction =
+    this->time_running > 0U ? double(this->time_enabled) / double(this->time_running) : 1.0;
+
+  return double(this->values[index]) * multiplexing_correction;
+}
+
+perf::Multiplexing
+perf::Group::accumulated_value::multiplexing(const std::size_t index) const noexcept
+{
+  if (index >= MAX_MEMBERS) {
+    return Multiplexing{};
   }
 
-  return 0;
+  return Multiplexing{ double(this->values[index]), this->time_enabled, this->time_running };
 }
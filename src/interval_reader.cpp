@@ -0,0 +1,297 @@
+#include <perfcpp/interval_reader.h>
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+std::vector<perf::EventCounter*>
+pointers(std::vector<perf::EventCounter>& event_counters)
+{
+  auto event_counter_pointers = std::vector<perf::EventCounter*>{};
+  event_counter_pointers.reserve(event_counters.size());
+  for (auto& event_counter : event_counters) {
+    event_counter_pointers.push_back(&event_counter);
+  }
+
+  return event_counter_pointers;
+}
+
+/**
+ * Calculates the value of a member within an interval, scaled by the share of the interval the group was running.
+ *
+ * @param previous Raw values of the group at the start of the interval.
+ * @param current Raw values of the group at the end of the interval.
+ * @param index Index of the member.
+ * @return Value of the member within the interval.
+ */
+double
+interval_value(const perf::Group::Counts& previous, const perf::Group::Counts& current, const std::size_t index)
+{
+  /// Raw values and times only grow while a group is opened.
+  const auto delta = [](const std::uint64_t start, const std::uint64_t end) { return end > start ? end - start : 0U; };
+
+  return perf::Multiplexing{ double(delta(previous.values[index], current.values[index])),
+                             delta(previous.time_enabled, current.time_enabled),
+                             delta(previous.time_running, current.time_running) }
+    .scaled_value();
+}
+}
+
+perf::IntervalReader::IntervalReader(perf::EventCounter& event_counter,
+                                     const std::chrono::milliseconds interval,
+                                     const std::size_t capacity)
+  : IntervalReader(std::vector<EventCounter*>{ &event_counter }, interval, capacity)
+{
+}
+
+perf::IntervalReader::IntervalReader(perf::MultiThreadEventCounter& event_counter,
+                                     const std::chrono::milliseconds interval,
+                                     const std::size_t capacity)
+  : IntervalReader(pointers(event_counter._thread_local_counter), interval, capacity)
+{
+}
+
+perf::IntervalReader::IntervalReader(perf::MultiProcessEventCounter& event_counter,
+                                     const std::chrono::milliseconds interval,
+                                     const std::size_t capacity)
+  : IntervalReader(pointers(event_counter._process_local_counter), interval, capacity)
+{
+}
+
+perf::IntervalReader::IntervalReader(perf::MultiCoreEventCounter& event_counter,
+                                     const std::chrono::milliseconds interval,
+                                     const std::size_t capacity)
+  : IntervalReader(pointers(event_counter._cpu_local_counter), interval, capacity)
+{
+}
+
+perf::IntervalReader::IntervalReader(std::vector<EventCounter*>&& event_counters,
+                                     const std::chrono::milliseconds interval,
+                                     const std::size_t capacity)
+  : _event_counters(std::move(event_counters))
+  , _interval(interval)
+  , _capacity(capacity)
+{
+  if (this->_event_counters.empty()) {
+    throw std::runtime_error{ "Cannot create an interval reader without event counters." };
+  }
+
+  if (this->_capacity == 0U) {
+    throw std::runtime_error{ "The capacity of the interval reader must be greater than zero." };
+  }
+
+  const auto& main_counter = *this->_event_counters.front();
+  this->_count_counters = std::count_if(
+    main_counter._counters.begin(), main_counter._counters.end(), [](const auto& event) { return event.is_counter(); });
+
+  /// Allocate all memory upfront; the background thread will not allocate.
+  this->_values.resize(this->_capacity * this->_count_counters, .0);
+  this->_times.resize(this->_capacity);
+  this->_durations.resize(this->_capacity);
+
+  auto count_groups = std::size_t{ 0U };
+  this->_first_group_ids.reserve(this->_event_counters.size());
+  for (const auto* event_counter : this->_event_counters) {
+    this->_first_group_ids.emplace_back(count_groups);
+    count_groups += event_counter->_groups.size();
+  }
+  this->_first_group_ids.emplace_back(count_groups);
+
+  this->_previous_counts.resize(count_groups);
+  this->_current_counts.resize(count_groups);
+  this->_previous_generations.resize(count_groups, 0U);
+  this->_current_generations.resize(count_groups, 0U);
+}
+
+perf::IntervalReader::~IntervalReader()
+{
+  this->stop();
+}
+
+void
+perf::IntervalReader::start()
+{
+  if (this->_reader_thread.joinable()) {
+    return;
+  }
+
+  {
+    auto lock = std::unique_lock{ this->_mutex };
+    this->_is_stop_requested = false;
+    this->_count_intervals = 0U;
+  }
+
+  this->_reader_thread = std::thread{ &IntervalReader::run, this };
+}
+
+void
+perf::IntervalReader::stop()
+{
+  if (!this->_reader_thread.joinable()) {
+    return;
+  }
+
+  {
+    auto lock = std::unique_lock{ this->_mutex };
+    this->_is_stop_requested = true;
+  }
+  this->_stop_condition.notify_all();
+
+  this->_reader_thread.join();
+}
+
+std::size_t
+perf::IntervalReader::size() const
+{
+  auto lock = std::unique_lock{ this->_mutex };
+  return std::min<std::uint64_t>(this->_count_intervals, this->_capacity);
+}
+
+std::uint64_t
+perf::IntervalReader::count_overwritten() const
+{
+  auto lock = std::unique_lock{ this->_mutex };
+  return this->_count_intervals > this->_capacity ? this->_count_intervals - this->_capacity : 0U;
+}
+
+perf::IntervalResult
+perf::IntervalReader::result(const std::size_t index, const std::uint64_t normalization) const
+{
+  const auto& main_counter = *this->_event_counters.front();
+
+  auto counter_values = std::vector<std::pair<std::string_view, double>>{};
+  counter_values.reserve(this->_count_counters);
+
+  auto time = std::chrono::nanoseconds{ 0U };
+  auto duration = std::chrono::nanoseconds{ 0U };
+
+  {
+    auto lock = std::unique_lock{ this->_mutex };
+
+    const auto count_stored = std::min<std::uint64_t>(this->_count_intervals, this->_capacity);
+    if (index >= count_stored) {
+      throw std::runtime_error{ "Interval index out of range." };
+    }
+
+    /// The oldest stored interval is located behind the newest one (once the ring wrapped around).
+    const auto slot = (this->_count_intervals - count_stored + index) % this->_capacity;
+    time = this->_times[slot];
+    duration = this->_durations[slot];
+
+    auto counter_id = 0U;
+    for (const auto& event : main_counter._counters) {
+      if (event.is_counter()) {
+        counter_values.emplace_back(event.name(),
+                                    this->_values[slot * this->_count_counters + counter_id] / double(normalization));
+        ++counter_id;
+      }
+    }
+  }
+
+  return IntervalResult{ time, duration, main_counter.evaluate(std::move(counter_values)) };
+}
+
+std::vector<perf::IntervalResult>
+perf::IntervalReader::result() const
+{
+  const auto count_stored = this->size();
+
+  auto results = std::vector<IntervalResult>{};
+  results.reserve(count_stored);
+
+  for (auto index = 0U; index < count_stored; ++index) {
+    results.emplace_back(this->result(index));
+  }
+
+  return results;
+}
+
+void
+perf::IntervalReader::read()
+{
+  for (auto event_counter_id = 0U; event_counter_id < this->_event_counters.size(); ++event_counter_id) {
+    const auto& event_counter = *this->_event_counters[event_counter_id];
+    const auto first_group_id = this->_first_group_ids[event_counter_id];
+    const auto count_groups =
+      std::min(this->_first_group_ids[event_counter_id + 1U] - first_group_id, event_counter._groups.size());
+
+    /// The file descriptors stay valid while reading, since the counters cannot be opened or closed meanwhile.
+    const auto lock = std::lock_guard{ event_counter._lifecycle_mutex.get() };
+    for (auto group_id = first_group_id; group_id < first_group_id + count_groups; ++group_id) {
+      if (!event_counter._is_opened) {
+        this->_current_generations[group_id] = 0U;
+      } else if (event_counter._groups[group_id - first_group_id].read_counts(this->_current_counts[group_id])) {
+        this->_current_generations[group_id] = event_counter._open_generation;
+      } else {
+        this->_current_counts[group_id] = this->_previous_counts[group_id];
+        this->_current_generations[group_id] = this->_previous_generations[group_id];
+      }
+    }
+  }
+}
+
+void
+perf::IntervalReader::run()
+{
+  const auto start_time = std::chrono::steady_clock::now();
+  auto last_time = start_time;
+  auto next_time = start_time + this->_interval;
+
+  /// Baseline for the first interval.
+  std::fill(this->_previous_generations.begin(), this->_previous_generations.end(), 0U);
+  this->read();
+  std::swap(this->_previous_counts, this->_current_counts);
+  std::swap(this->_previous_generations, this->_current_generations);
+
+  auto lock = std::unique_lock{ this->_mutex };
+  while (!this->_stop_condition.wait_until(lock, next_time, [this] { return this->_is_stop_requested; })) {
+    lock.unlock();
+    this->read();
+    const auto now = std::chrono::steady_clock::now();
+    lock.lock();
+
+    /// Write the deltas into the next slot of the ring, overwriting the oldest interval if the ring is full.
+    auto* values = this->_values.data() + (this->_count_intervals % this->_capacity) * this->_count_counters;
+    std::fill(values, values + this->_count_counters, .0);
+
+    for (auto event_counter_id = 0U; event_counter_id < this->_event_counters.size(); ++event_counter_id) {
+      const auto& event_counter = *this->_event_counters[event_counter_id];
+      const auto first_group_id = this->_first_group_ids[event_counter_id];
+      const auto count_groups = this->_first_group_ids[event_counter_id + 1U] - first_group_id;
+
+      auto counter_id = 0U;
+      for (const auto& event : event_counter._counters) {
+        if (!event.is_counter()) {
+          continue;
+        }
+
+        const auto group_id = first_group_id + event.group_id();
+        const auto generation = this->_current_generations[group_id];
+
+        /// Counters that were (re-)opened since the previous read count from zero; closed counters add nothing.
+        if (event.group_id() < count_groups && generation != 0U) {
+          const auto& previous_counts = this->_previous_generations[group_id] == generation
+                                          ? this->_previous_counts[group_id]
+                                          : Group::Counts{};
+          values[counter_id] += interval_value(previous_counts, this->_current_counts[group_id], event.in_group_id());
+        }
+
+        ++counter_id;
+      }
+    }
+
+    const auto slot = this->_count_intervals % this->_capacity;
+    this->_times[slot] = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_time);
+    this->_durations[slot] = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_time);
+    ++this->_count_intervals;
+
+    std::swap(this->_previous_counts, this->_current_counts);
+    std::swap(this->_previous_generations, this->_current_generations);
+    last_time = now;
+
+    /// Skip intervals that were missed (e.g., when the reader thread was descheduled).
+    do {
+      next_time += this->_interval;
+    } while (next_time <= now);
+  }
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <perfcpp/metric_expression.h>
+#include <stdexcept>
+
+namespace {
+/**
+ * Recursive descent parser that compiles an expression into postfix bytecode.
+ *
+ * sum     := product (('+' | '-') product)*
+ * product := unary (('*' | '/') unary)*
+ * unary   := '-' unary | primary
+ * primary := number | function '(' sum (',' sum)* ')' | counter | '(' sum ')'
+ */
+class ExpressionParser
+{
+public:
+  ExpressionParser(const std::string_view expression,
+                   std::vector<std::string>& counter_names,
+                   std::vector<perf::MetricExpression::Instruction>& instructions) noexcept
+    : _expression(expression)
+    , _counter_names(counter_names)
+    , _instructions(instructions)
+  {
+  }
+
+  ~ExpressionParser() = default;
+
+  void parse()
+  {
+    this->sum();
+
+    this->skip_whitespace();
+    if (this->_position < this->_expression.size()) {
+      this->fail("unexpected character");
+    }
+  }
+
+private:
+  using Operation = perf::MetricExpression::Operation;
+  using Instruction = perf::MetricExpression::Instruction;
+
+  std::string_view _expression;
+  std::size_t _position{ 0U };
+  std::vector<std::string>& _counter_names;
+  std::vector<Instruction>& _instructions;
+
+  /// Current depth of the evaluation stack.
+  std::uint32_t _stack_size{ 0U };
+
+  [[noreturn]] void fail(std::string_view message) const
+  {
+    throw std::runtime_error{ std::string{ "Cannot parse metric expression '" }
+                                .append(this->_expression)
+                                .append("' at position ")
+                                .append(std::to_string(this->_position))
+                                .append(": ")
+                                .append(message)
+                                .append(".") };
+  }
+
+  [[nodiscard]] static bool is_identifier_start(const char character) noexcept
+  {
+    return std::isalpha(static_cast<unsigned char>(character)) || character == '_';
+  }
+
+  [[nodiscard]] static bool is_identifier(const char character) noexcept
+  {
+    return std::isalnum(static_cast<unsigned char>(character)) || character == '_' || character == '-' ||
+           character == '.' || character == ':';
+  }
+
+  void skip_whitespace() noexcept
+  {
+    while (this->_position < this->_expression.size() &&
+           std::isspace(static_cast<unsigned char>(this->_expression[this->_position]))) {
+      ++this->_position;
+    }
+  }
+
+  /**
+   * Skips whitespace and consumes the given character, if it is next.
+   *
+   * @param character Character to consume.
+   * @return True, if the character was consumed.
+   */
+  [[nodiscard]] bool consume(const char character) noexcept
+  {
+    this->skip_whitespace();
+    if (this->_position < this->_expression.size() && this->_expression[this->_position] == character) {
+      ++this->_position;
+      return true;
+    }
+
+    return false;
+  }
+
+  /**
+   * Appends the given instruction and tracks the depth of the evaluation stack.
+   *
+   * @param instruction Instruction to append.
+   * @param count_popped Number of values the instruction removes from the stack (before pushing its result).
+   */
+  void emit(Instruction instruction, const std::uint32_t count_popped)
+  {
+    this->_stack_size = this->_stack_size - count_popped + 1U;
+    if (this->_stack_size > perf::MetricExpression::MAX_STACK_SIZE) {
+      this->fail("expression is nested too deeply");
+    }
+
+    this->_instructions.emplace_back(instruction);
+  }
+
+  void sum()
+  {
+    this->product();
+
+    while (true) {
+      if (this->consume('+')) {
+        this->product();
+        this->emit(Instruction{ Operation::Add }, 2U);
+      } else if (this->consume('-')) {
+        this->product();
+        this->emit(Instruction{ Operation::Subtract }, 2U);
+      } else {
+        return;
+      }
+    }
+  }
+
+  void product()
+  {
+    this->unary();
+
+    while (true) {
+      if (this->consume('*')) {
+        this->unary();
+        this->emit(Instruction{ Operation::Multiply }, 2U);
+      } else if (this->consume('/')) {
+        this->unary();
+        this->emit(Instruction{ Operation::Divide }, 2U);
+      } else {
+        return;
+      }
+    }
+  }
+
+  void unary()
+  {
+    if (this->consume('-')) {
+      this->unary();
+      this->emit(Instruction{ Operation::Negate }, 1U);
+    } else {
+      this->primary();
+    }
+  }
+
+  void primary()
+  {
+    this->skip_whitespace();
+    if (this->_position >= this->_expression.size()) {
+      this->fail("unexpected end of expression");
+    }
+
+    /// Parenthesized expression.
+    if (this->consume('(')) {
+      this->sum();
+      if (!this->consume(')')) {
+        this->fail("expected ')'");
+      }
+      return;
+    }
+
+    const auto character = this->_expression[this->_position];
+
+    /// Numeric constant.
+    if (std::isdigit(static_cast<unsigned char>(character)) || character == '.') {
+      const auto remaining = std::string{ this->_expression.substr(this->_position) };
+      char* end = nullptr;
+      const auto constant = std::strtod(remaining.c_str(), &end);
+      if (end == remaining.c_str()) {
+        this->fail("invalid number");
+      }
+      this->_position += std::size_t(end - remaining.c_str());
+      this->emit(Instruction{ Operation::Constant, constant }, 0U);
+      return;
+    }
+
+    if (!ExpressionParser::is_identifier_start(character)) {
+      this->fail("unexpected character");
+    }
+
+    const auto begin = this->_position;
+    while (this->_position < this->_expression.size() &&
+           ExpressionParser::is_identifier(this->_expression[this->_position])) {
+      ++this->_position;
+    }
+    const auto identifier = this->_expression.substr(begin, this->_position - begin);
+
+    /// Function call.
+    if (this->consume('(')) {
+      this->function(identifier);
+      return;
+    }
+
+    /// Counter; every counter is required only once.
+    auto counter_id = std::distance(this->_counter_names.begin(),
+                                    std::find(this->_counter_names.begin(), this->_counter_names.end(), identifier));
+    if (std::size_t(counter_id) == this->_counter_names.size()) {
+      this->_counter_names.emplace_back(identifier);
+    }
+    this->emit(Instruction{ Operation::Counter, std::uint16_t(counter_id) }, 0U);
+  }
+
+  /**
+   * Parses the arguments of a function (the opening parenthesis is already consumed) and emits the function.
+   *
+   * @param name Name of the function.
+   */
+  void function(const std::string_view name)
+  {
+    auto count_arguments = 0U;
+    do {
+      this->sum();
+      ++count_arguments;
+    } while (this->consume(','));
+
+    if (!this->consume(')')) {
+      this->fail("expected ')'");
+    }
+
+    if ((name == "min" || name == "max") && count_arguments == 2U) {
+      this->emit(Instruction{ name == "min" ? Operation::Min : Operation::Max }, 2U);
+    } else if (name == "if_zero" && count_arguments == 3U) {
+      this->emit(Instruction{ Operation::IfZero }, 3U);
+    } else {
+      this->fail(std::string{ "unknown function '" }
+                   .append(name)
+                   .append("' with ")
+                   .append(std::to_string(count_arguments))
+                   .append(" argument(s)"));
+    }
+  }
+};
+}
+
+perf::MetricExpression::MetricExpression(std::string&& name, const std::string_view expression)
+  : _name(std::move(name))
+  , _expression(expression)
+{
+  auto parser = ExpressionParser{ this->_expression, this->_counter_names, this->_instructions };
+  parser.parse();
+}
+
+std::optional<double>
+perf::MetricExpression::calculate(const perf::CounterResult& result) const
+{
+  auto is_every_counter_available = true;
+  const auto value = this->evaluate([this, &result, &is_every_counter_available](const std::uint16_t counter_id) {
+    const auto counter_value = result.get(this->_counter_names[counter_id]);
+    is_every_counter_available &= counter_value.has_value();
+    return counter_value.value_or(std::numeric_limits<double>::quiet_NaN());
+  });
+
+  if (is_every_counter_available) {
+    return value;
+  }
+
+  return std::nullopt;
+}
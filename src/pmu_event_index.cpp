@@ -0,0 +1,563 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <linux/perf_event.h>
+#include <perfcpp/pmu_event_index.h>
+#include <perfcpp/pmu_event_parser.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Average number of events per bucket of the perfect hash; larger buckets need fewer seeds but longer searches.
+constexpr auto EVENTS_PER_BUCKET = std::uint32_t{ 4U };
+
+/// Maximal seed tried per bucket before giving up.
+constexpr auto MAX_SEED = std::uint32_t{ 1U } << 24U;
+
+/**
+ * Minimal reader for the pmu-events JSON files: An array of flat objects whose values are strings or numbers.
+ * Nested values are skipped.
+ */
+class JsonReader
+{
+public:
+  JsonReader(std::string_view input, const std::string& file_name) noexcept
+    : _input(input)
+    , _file_name(file_name)
+  {
+  }
+  ~JsonReader() = default;
+
+  /**
+   * Reads all objects of the top-level array; other top-level values (e.g., objects) yield no objects.
+   *
+   * @return List of objects, each a map from keys to scalar values.
+   */
+  [[nodiscard]] std::vector<std::unordered_map<std::string, std::string>> objects()
+  {
+    auto objects = std::vector<std::unordered_map<std::string, std::string>>{};
+
+    this->skip_whitespace();
+    if (!this->is_next('[')) {
+      return objects;
+    }
+
+    this->expect('[');
+    while (!this->is_next(']')) {
+      objects.emplace_back(this->object());
+      if (!this->is_next(']')) {
+        this->expect(',');
+      }
+    }
+    this->expect(']');
+
+    return objects;
+  }
+
+private:
+  std::string_view _input;
+  std::size_t _position{ 0U };
+  const std::string& _file_name;
+
+  void skip_whitespace() noexcept
+  {
+    while (this->_position < this->_input.size() &&
+           std::isspace(static_cast<unsigned char>(this->_input[this->_position]))) {
+      ++this->_position;
+    }
+  }
+
+  [[nodiscard]] bool is_next(const char character) noexcept
+  {
+    this->skip_whitespace();
+    return this->_position < this->_input.size() && this->_input[this->_position] == character;
+  }
+
+  void expect(const char character)
+  {
+    if (!this->is_next(character)) {
+      this->fail(std::string{ "Expected '" } + character + "'.");
+    }
+    ++this->_position;
+  }
+
+  [[noreturn]] void fail(const std::string& message) const
+  {
+    throw std::runtime_error{ std::string{ "Cannot parse pmu-events file '" }
+                                .append(this->_file_name)
+                                .append("' at position ")
+                                .append(std::to_string(this->_position))
+                                .append(": ")
+                                .append(message) };
+  }
+
+  [[nodiscard]] std::unordered_map<std::string, std::string> object()
+  {
+    auto object = std::unordered_map<std::string, std::string>{};
+
+    this->expect('{');
+    while (!this->is_next('}')) {
+      auto key = this->string();
+      this->expect(':');
+      auto value = this->value();
+      if (value.has_value()) {
+        object.insert(std::make_pair(std::move(key), std::move(value.value())));
+      }
+
+      if (!this->is_next('}')) {
+        this->expect(',');
+      }
+    }
+    this->expect('}');
+
+    return object;
+  }
+
+  /**
+   * @return The scalar value, or std::nullopt for nested values (which are skipped).
+   */
+  [[nodiscard]] std::optional<std::string> value()
+  {
+    if (this->is_next('"')) {
+      return this->string();
+    }
+
+    if (this->is_next('{') || this->is_next('[')) {
+      this->skip_nested();
+      return std::nullopt;
+    }
+
+    /// Numbers, true, false, and null.
+    const auto begin = this->_position;
+    while (this->_position < this->_input.size() &&
+           std::strchr(",}] \t\r\n", this->_input[this->_position]) == nullptr) {
+      ++this->_position;
+    }
+    if (begin == this->_position) {
+      this->fail("Expected a value.");
+    }
+
+    return std::string{ this->_input.substr(begin, this->_position - begin) };
+  }
+
+  [[nodiscard]] std::string string()
+  {
+    this->expect('"');
+
+    auto value = std::string{};
+    while (this->_position < this->_input.size() && this->_input[this->_position] != '"') {
+      auto character = this->_input[this->_position++];
+      if (character == '\\' && this->_position < this->_input.size()) {
+        character = this->_input[this->_position++];
+        switch (character) {
+          case 'n':
+            character = '\n';
+            break;
+          case 't':
+            character = '\t';
+            break;
+          case 'u':
+            /// Descriptions may contain unicode escapes; names do not, keep a placeholder.
+            this->_position = std::min(this->_position + 4U, this->_input.size());
+            character = '?';
+            break;
+          default:
+            break;
+        }
+      }
+      value.push_back(character);
+    }
+    this->expect('"');
+
+    return value;
+  }
+
+  void skip_nested()
+  {
+    auto depth = std::size_t{ 0U };
+    do {
+      if (this->is_next('"')) {
+        std::ignore = this->string();
+        continue;
+      }
+      if (this->_position >= this->_input.size()) {
+        this->fail("Unexpected end of file.");
+      }
+
+      const auto character = this->_input[this->_position++];
+      if (character == '{' || character == '[') {
+        ++depth;
+      } else if (character == '}' || character == ']') {
+        --depth;
+      }
+    } while (depth > 0U);
+  }
+};
+
+/**
+ * Parses the first (comma-separated) number of a value, e.g., "0xB7, 0xBB".
+ *
+ * @param value Value to parse.
+ * @return The number (0 if the value is no number).
+ */
+std::uint64_t
+parse_number(const std::string& value)
+{
+  try {
+    return std::stoull(value.substr(0U, value.find(',')), nullptr, 0);
+  } catch (std::logic_error&) {
+    return 0U;
+  }
+}
+
+/**
+ * Reads the contents of a file.
+ *
+ * @param file_name Name of the file.
+ * @return Contents of the file.
+ */
+std::string
+read_file(const std::string& file_name)
+{
+  auto stream = std::ifstream{ file_name, std::ios::binary };
+  if (!stream.is_open()) {
+    throw std::runtime_error{ std::string{ "Cannot open pmu-events file '" }.append(file_name).append("'.") };
+  }
+
+  return std::string{ std::istreambuf_iterator<char>{ stream }, std::istreambuf_iterator<char>{} };
+}
+
+/**
+ * Lists the JSON files to compile: the given file or all *.json files of the given directory.
+ *
+ * @param json_path File or directory.
+ * @return List of files, sorted.
+ */
+std::vector<std::string>
+json_files(const std::string& json_path)
+{
+  auto files = std::vector<std::string>{};
+
+  if (auto* directory = ::opendir(json_path.c_str()); directory != nullptr) {
+    while (const auto* entry = ::readdir(directory)) {
+      const auto name = std::string_view{ entry->d_name };
+      if (name.size() > 5U && name.substr(name.size() - 5U) == ".json") {
+        files.emplace_back(std::string{ json_path }.append("/").append(name));
+      }
+    }
+    ::closedir(directory);
+    std::sort(files.begin(), files.end());
+  } else {
+    files.emplace_back(json_path);
+  }
+
+  return files;
+}
+}
+
+perf::PmuEventIndex::PmuEventIndex(const std::string& index_file)
+{
+  const auto file_descriptor = ::open(index_file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot open pmu-events index '" }.append(index_file).append("'.") };
+  }
+
+  struct stat file_status
+  {};
+  if (::fstat(file_descriptor, &file_status) == 0 && std::size_t(file_status.st_size) >= sizeof(header)) {
+    auto* data = ::mmap(nullptr, std::size_t(file_status.st_size), PROT_READ, MAP_SHARED, file_descriptor, 0);
+    if (data != MAP_FAILED) {
+      this->_data = static_cast<const std::uint8_t*>(data);
+      this->_size = std::size_t(file_status.st_size);
+    }
+  }
+  ::close(file_descriptor);
+
+  /// Validate the header before accessing the index.
+  const auto is_valid = this->_data != nullptr && this->file_header().magic == MAGIC &&
+                        this->file_header().size == this->_size && this->file_header().count_buckets > 0U &&
+                        PmuEventIndex::entries_offset(this->file_header().count_buckets) +
+                            sizeof(entry) * this->file_header().count_events <=
+                          this->_size;
+  if (!is_valid) {
+    this->unmap();
+    throw std::runtime_error{ std::string{ "File '" }.append(index_file).append("' is no valid pmu-events index.") };
+  }
+}
+
+perf::PmuEventIndex::PmuEventIndex(perf::PmuEventIndex&& other) noexcept
+  : _data(std::exchange(other._data, nullptr))
+  , _size(std::exchange(other._size, 0U))
+{
+}
+
+perf::PmuEventIndex&
+perf::PmuEventIndex::operator=(perf::PmuEventIndex&& other) noexcept
+{
+  if (this != &other) {
+    this->unmap();
+    this->_data = std::exchange(other._data, nullptr);
+    this->_size = std::exchange(other._size, 0U);
+  }
+
+  return *this;
+}
+
+perf::PmuEventIndex::~PmuEventIndex()
+{
+  this->unmap();
+}
+
+void
+perf::PmuEventIndex::unmap() noexcept
+{
+  if (this->_data != nullptr) {
+    ::munmap(const_cast<std::uint8_t*>(this->_data), this->_size);
+    this->_data = nullptr;
+    this->_size = 0U;
+  }
+}
+
+std::uint64_t
+perf::PmuEventIndex::hash(const std::string_view name, const std::uint64_t seed) noexcept
+{
+  /// FNV-1a over the lowercase name, followed by the finalizer of MurmurHash3 to spread the bits.
+  auto hash = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+  for (const auto character : name) {
+    hash ^= std::uint64_t(std::tolower(static_cast<unsigned char>(character)));
+    hash *= 0x100000001b3ULL;
+  }
+
+  hash ^= hash >> 33U;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33U;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33U;
+
+  return hash;
+}
+
+std::optional<perf::CounterConfig>
+perf::PmuEventIndex::find(const std::string_view name) const noexcept
+{
+  if (this->_data == nullptr || this->file_header().count_events == 0U) {
+    return std::nullopt;
+  }
+
+  const auto& index_header = this->file_header();
+  const auto bucket = PmuEventIndex::hash(name, 0U) % index_header.count_buckets;
+  const auto slot = PmuEventIndex::hash(name, this->seeds()[bucket]) % index_header.count_events;
+
+  /// The perfect hash maps every name to a slot; compare the name to reject names that are not in the index.
+  const auto& event = this->entries()[slot];
+  const auto event_name = this->name(event);
+  const auto is_equal =
+    !event_name.empty() && event_name.size() == name.size() &&
+    std::equal(event_name.begin(), event_name.end(), name.begin(), [](const char indexed, const char requested) {
+      return indexed == std::tolower(static_cast<unsigned char>(requested));
+    });
+  if (!is_equal) {
+    return std::nullopt;
+  }
+
+  return CounterConfig{ event.type, event.config[0U], event.config[1U], event.config[2U] };
+}
+
+perf::PmuEventIndex
+perf::PmuEventIndex::open_or_compile(const std::string& json_path, const std::string& index_file)
+{
+  /// Compile the index, if it does not exist or any JSON file was modified after compiling it.
+  struct stat index_status
+  {};
+  auto is_outdated = ::stat(index_file.c_str(), &index_status) != 0;
+  for (const auto& file_name : json_files(json_path)) {
+    struct stat json_status
+    {};
+    is_outdated |= ::stat(file_name.c_str(), &json_status) == 0 && json_status.st_mtime > index_status.st_mtime;
+  }
+
+  if (!is_outdated) {
+    try {
+      return PmuEventIndex{ index_file };
+    } catch (std::runtime_error&) {
+      /// Index of an older version or damaged; compile again.
+    }
+  }
+
+  std::ignore = PmuEventIndex::compile(json_path, index_file);
+  return PmuEventIndex{ index_file };
+}
+
+std::size_t
+perf::PmuEventIndex::compile(const std::string& json_path, const std::string& index_file)
+{
+  /// Collect the core events of all files (names in lowercase, events in multiple files are added once).
+  auto names = std::vector<std::string>{};
+  auto events = std::vector<entry>{};
+  auto known_names = std::unordered_set<std::string>{};
+
+  /// Core events of hybrid processors belong to a dynamic PMU ("cpu_core"), whose type is read from the sysfs.
+  const auto hybrid_core_type = PmuEventParser{}.type("cpu_core");
+
+  for (const auto& file_name : json_files(json_path)) {
+    const auto content = read_file(file_name);
+    for (auto& object : JsonReader{ content, file_name }.objects()) {
+      const auto name = object.find("EventName");
+      const auto event_code = object.find("EventCode");
+      const auto config_code = object.find("ConfigCode");
+      if (name == object.end() || (event_code == object.end() && config_code == object.end())) {
+        continue;
+      }
+
+      /// Core events have no unit, or the unit of a core PMU on hybrid systems. Skip uncore events and events of the
+      /// efficiency cores ("cpu_atom"), which share their names with events of the performance cores ("cpu_core").
+      auto type = std::uint32_t{ PERF_TYPE_RAW };
+      if (const auto unit = object.find("Unit"); unit != object.end() && unit->second != "cpu") {
+        if (unit->second != "cpu_core") {
+          continue;
+        }
+
+        /// Events of a PMU that does not exist on this system cannot be opened.
+        if (!hybrid_core_type.has_value()) {
+          continue;
+        }
+        type = hybrid_core_type.value();
+      }
+
+      auto event_name = name->second;
+      std::transform(event_name.begin(), event_name.end(), event_name.begin(), [](const char character) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+      });
+      if (!known_names.insert(event_name).second) {
+        continue;
+      }
+
+      /// Encode the event like the perf tool does for x86 (event select, unit mask, edge, invert, counter mask;
+      /// extended event select bits of AMD in bits 32-35). Other architectures provide the config directly.
+      auto event = entry{ 0U, 0U, type, 0U, { 0U, 0U, 0U } };
+      if (config_code != object.end()) {
+        event.config[0U] = parse_number(config_code->second);
+      } else {
+        const auto code = parse_number(event_code->second);
+        const auto value = [&object](const char* key) {
+          const auto iterator = object.find(key);
+          return iterator != object.end() ? parse_number(iterator->second) : 0U;
+        };
+
+        event.config[0U] = (code & 0xFFU) | ((code & 0xF00U) << 24U) | ((value("UMask") & 0xFFU) << 8U) |
+                           ((value("EdgeDetect") & 0x1U) << 18U) | ((value("Invert") & 0x1U) << 23U) |
+                           ((value("CounterMask") & 0xFFU) << 24U);
+        event.config[1U] = value("MSRValue");
+      }
+
+      names.emplace_back(std::move(event_name));
+      events.emplace_back(event);
+    }
+  }
+
+  /// Build the perfect hash: Distribute the names into buckets and find a seed per bucket (largest buckets first)
+  /// that maps all names of the bucket to free slots.
+  const auto count_events = std::uint32_t(events.size());
+  const auto count_buckets = std::max<std::uint32_t>(1U, (count_events + EVENTS_PER_BUCKET - 1U) / EVENTS_PER_BUCKET);
+
+  auto buckets = std::vector<std::vector<std::uint32_t>>(count_buckets);
+  for (auto event_id = 0U; event_id < count_events; ++event_id) {
+    buckets[PmuEventIndex::hash(names[event_id], 0U) % count_buckets].emplace_back(event_id);
+  }
+
+  auto bucket_order = std::vector<std::uint32_t>(count_buckets);
+  for (auto bucket_id = 0U; bucket_id < count_buckets; ++bucket_id) {
+    bucket_order[bucket_id] = bucket_id;
+  }
+  std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](const auto left, const auto right) {
+    return buckets[left].size() > buckets[right].size();
+  });
+
+  auto seeds = std::vector<std::uint32_t>(count_buckets, 0U);
+  auto slots = std::vector<std::uint32_t>(count_events, 0U);
+  auto is_slot_occupied = std::vector<bool>(count_events, false);
+  auto bucket_slots = std::vector<std::uint32_t>{};
+
+  for (const auto bucket_id : bucket_order) {
+    const auto& bucket = buckets[bucket_id];
+    if (bucket.empty()) {
+      break;
+    }
+
+    auto is_placed = false;
+    for (auto seed = std::uint32_t{ 1U }; seed < MAX_SEED && !is_placed; ++seed) {
+      bucket_slots.clear();
+      is_placed = true;
+      for (const auto event_id : bucket) {
+        const auto slot = std::uint32_t(PmuEventIndex::hash(names[event_id], seed) % count_events);
+        if (is_slot_occupied[slot] || std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end()) {
+          is_placed = false;
+          break;
+        }
+        bucket_slots.emplace_back(slot);
+      }
+
+      if (is_placed) {
+        seeds[bucket_id] = seed;
+        for (auto i = 0U; i < bucket.size(); ++i) {
+          slots[bucket[i]] = bucket_slots[i];
+          is_slot_occupied[bucket_slots[i]] = true;
+        }
+      }
+    }
+
+    if (!is_placed) {
+      throw std::runtime_error{ "Cannot build a perfect hash for the pmu-events index." };
+    }
+  }
+
+  /// Place the entries at their slots and append the names.
+  auto placed_events = std::vector<entry>(count_events);
+  auto names_data = std::string{};
+  for (auto event_id = 0U; event_id < count_events; ++event_id) {
+    auto event = events[event_id];
+    event.name_offset = std::uint32_t(names_data.size());
+    event.name_length = std::uint32_t(names[event_id].size());
+    names_data.append(names[event_id]);
+
+    placed_events[slots[event_id]] = event;
+  }
+
+  const auto entries_offset = PmuEventIndex::entries_offset(count_buckets);
+  const auto index_header = header{ MAGIC,
+                                    count_events,
+                                    count_buckets,
+                                    entries_offset + sizeof(entry) * count_events + names_data.size() };
+
+  auto data = std::string(index_header.size, '\0');
+  std::memcpy(data.data(), &index_header, sizeof(header));
+  std::memcpy(data.data() + sizeof(header), seeds.data(), sizeof(std::uint32_t) * count_buckets);
+  std::memcpy(data.data() + entries_offset, placed_events.data(), sizeof(entry) * count_events);
+  std::memcpy(data.data() + entries_offset + sizeof(entry) * count_events, names_data.data(), names_data.size());
+
+  /// Write to a temporary file and rename it, such that processes never map a partially written index.
+  const auto temporary_file = std::string{ index_file }.append(".").append(std::to_string(::getpid()));
+  {
+    auto stream = std::ofstream{ temporary_file, std::ios::binary | std::ios::trunc };
+    if (!stream.is_open() || !stream.write(data.data(), std::streamsize(data.size()))) {
+      throw std::runtime_error{ std::string{ "Cannot write pmu-events index '" }.append(index_file).append("'.") };
+    }
+  }
+  if (::rename(temporary_file.c_str(), index_file.c_str()) != 0) {
+    ::unlink(temporary_file.c_str());
+    throw std::runtime_error{ std::string{ "Cannot write pmu-events index '" }.append(index_file).append("'.") };
+  }
+
+  return count_events;
+}
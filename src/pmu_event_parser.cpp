@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cctype>
+#include <dirent.h>
+#include <fstream>
+#include <perfcpp/pmu_event_parser.h>
+#include <stdexcept>
+
+namespace {
+/// Maximal depth of aliases referring to other aliases.
+constexpr auto MAX_ALIAS_DEPTH = std::uint8_t{ 4U };
+
+/**
+ * Lists the entries of a directory (without "." and "..").
+ *
+ * @param path Path of the directory.
+ * @return Names of the entries, sorted; empty if the directory cannot be read.
+ */
+std::vector<std::string>
+list_directory(const std::string& path)
+{
+  auto entries = std::vector<std::string>{};
+
+  if (auto* directory = ::opendir(path.c_str()); directory != nullptr) {
+    while (const auto* entry = ::readdir(directory)) {
+      if (entry->d_name[0] != '.') {
+        entries.emplace_back(entry->d_name);
+      }
+    }
+    ::closedir(directory);
+  }
+
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+/**
+ * Reads the first line of a (sysfs) file.
+ *
+ * @param path Path of the file.
+ * @return The first line, or std::nullopt if the file cannot be read.
+ */
+std::optional<std::string>
+read_line(const std::string& path)
+{
+  auto stream = std::ifstream{ path };
+  if (!stream.is_open()) {
+    return std::nullopt;
+  }
+
+  auto line = std::string{};
+  std::getline(stream, line);
+  return line;
+}
+
+/**
+ * Parses an unsigned (decimal, hexadecimal, or octal) number.
+ *
+ * @param value String to parse.
+ * @return The number, or std::nullopt if the string is not a number.
+ */
+std::optional<std::uint64_t>
+parse_number(const std::string_view value)
+{
+  if (value.empty() || value.front() < '0' || value.front() > '9') {
+    return std::nullopt;
+  }
+
+  try {
+    auto count_parsed = std::size_t{ 0U };
+    const auto number = std::stoull(std::string{ value }, &count_parsed, 0);
+    if (count_parsed == value.size()) {
+      return number;
+    }
+  } catch (std::logic_error&) {
+  }
+
+  return std::nullopt;
+}
+
+/**
+ * Removes leading and trailing whitespace.
+ *
+ * @param value String to trim.
+ * @return The trimmed string.
+ */
+std::string_view
+trim(std::string_view value)
+{
+  while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) {
+    value.remove_prefix(1U);
+  }
+  while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+    value.remove_suffix(1U);
+  }
+
+  return value;
+}
+}
+
+perf::CounterConfig
+perf::PmuEventParser::parse(std::string_view event) const
+{
+  /// Event strings have the form "<pmu>/<terms>/".
+  const auto pmu_end = event.find('/');
+  if (pmu_end == std::string_view::npos || pmu_end == 0U || event.back() != '/' || event.size() < pmu_end + 3U ||
+      event.find('/', pmu_end + 1U) != event.size() - 1U) {
+    throw std::runtime_error{ std::string{ "Cannot parse event '" }.append(event).append(
+      "': Expected the format '<pmu>/<terms>/'.") };
+  }
+
+  const auto pmu = event.substr(0U, pmu_end);
+  const auto terms = event.substr(pmu_end + 1U, event.size() - pmu_end - 2U);
+
+  const auto type = this->type(pmu);
+  if (!type.has_value()) {
+    throw std::runtime_error{ std::string{ "Cannot parse event '" }
+                                .append(event)
+                                .append("': PMU '")
+                                .append(pmu)
+                                .append("' does not exist.") };
+  }
+
+  auto config = std::array<std::uint64_t, 3U>{ 0U, 0U, 0U };
+  auto period = std::optional<std::uint64_t>{ std::nullopt };
+  try {
+    this->apply(pmu, terms, config, period, 0U);
+  } catch (std::runtime_error& exception) {
+    throw std::runtime_error{ std::string{ "Cannot parse event '" }.append(event).append("': ").append(
+      exception.what()) };
+  }
+
+  auto counter_config = CounterConfig{ type.value(), config[0U], config[1U], config[2U] };
+  if (period.has_value()) {
+    counter_config.period(period.value());
+  }
+
+  return counter_config;
+}
+
+std::vector<std::string>
+perf::PmuEventParser::pmus() const
+{
+  return list_directory(this->_sysfs_root);
+}
+
+std::vector<std::string>
+perf::PmuEventParser::events(const std::string_view pmu) const
+{
+  auto events = list_directory(std::string{ this->_sysfs_root }.append("/").append(pmu).append("/events"));
+
+  /// Attributes of events (e.g., "energy-pkg.scale") are no events.
+  events.erase(std::remove_if(events.begin(),
+                              events.end(),
+                              [](const auto& name) { return name.find('.') != std::string::npos; }),
+               events.end());
+
+  return events;
+}
+
+std::optional<std::uint32_t>
+perf::PmuEventParser::type(const std::string_view pmu) const
+{
+  const auto line = read_line(std::string{ this->_sysfs_root }.append("/").append(pmu).append("/type"));
+  if (line.has_value()) {
+    if (const auto type = parse_number(trim(line.value())); type.has_value()) {
+      return std::uint32_t(type.value());
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<perf::PmuEventParser::Format>
+perf::PmuEventParser::format(const std::string_view pmu, const std::string_view term) const
+{
+  const auto line =
+    read_line(std::string{ this->_sysfs_root }.append("/").append(pmu).append("/format/").append(term));
+  if (!line.has_value()) {
+    return std::nullopt;
+  }
+
+  /// Formats have the form "<field>:<bits>[,<bits>]*" where <bits> is a single bit or a range "<first>-<last>".
+  const auto format = trim(line.value());
+  const auto field_end = format.find(':');
+  if (field_end == std::string_view::npos) {
+    throw std::runtime_error{ std::string{ "Malformed format of term '" }.append(term).append("'.") };
+  }
+
+  const auto field_name = format.substr(0U, field_end);
+  auto field = std::uint8_t{ 0U };
+  if (field_name == "config1") {
+    field = 1U;
+  } else if (field_name == "config2") {
+    field = 2U;
+  } else if (field_name != "config") {
+    throw std::runtime_error{ std::string{ "Unsupported field '" }
+                                .append(field_name)
+                                .append("' in format of term '")
+                                .append(term)
+                                .append("'.") };
+  }
+
+  auto bit_ranges = std::vector<std::pair<std::uint8_t, std::uint8_t>>{};
+  auto bits = format.substr(field_end + 1U);
+  while (!bits.empty()) {
+    const auto range_end = std::min(bits.find(','), bits.size());
+    const auto range = bits.substr(0U, range_end);
+    const auto separator = range.find('-');
+
+    const auto first = parse_number(range.substr(0U, separator));
+    const auto last = separator != std::string_view::npos ? parse_number(range.substr(separator + 1U)) : first;
+    if (!first.has_value() || !last.has_value() || first.value() > last.value() || last.value() > 63U) {
+      throw std::runtime_error{ std::string{ "Malformed format of term '" }.append(term).append("'.") };
+    }
+    bit_ranges.emplace_back(std::uint8_t(first.value()), std::uint8_t(last.value()));
+
+    bits.remove_prefix(std::min(range_end + 1U, bits.size()));
+  }
+
+  return Format{ field, std::move(bit_ranges) };
+}
+
+std::optional<std::string>
+perf::PmuEventParser::alias(const std::string_view pmu, const std::string_view alias) const
+{
+  return read_line(std::string{ this->_sysfs_root }.append("/").append(pmu).append("/events/").append(alias));
+}
+
+void
+perf::PmuEventParser::apply(const std::string_view pmu,
+                            std::string_view terms,
+                            std::array<std::uint64_t, 3U>& config,
+                            std::optional<std::uint64_t>& period,
+                            const std::uint8_t depth) const
+{
+  if (depth > MAX_ALIAS_DEPTH) {
+    throw std::runtime_error{ "Aliases are nested too deeply." };
+  }
+
+  while (!terms.empty()) {
+    const auto term_end = std::min(terms.find(','), terms.size());
+    const auto term = trim(terms.substr(0U, term_end));
+    terms.remove_prefix(std::min(term_end + 1U, terms.size()));
+
+    if (term.empty()) {
+      continue;
+    }
+
+    /// Split the term into name and value; terms without value are flags (value 1) or aliases.
+    const auto separator = term.find('=');
+    const auto name = trim(term.substr(0U, separator));
+    auto value = std::optional<std::uint64_t>{ 1U };
+    if (separator != std::string_view::npos) {
+      value = parse_number(trim(term.substr(separator + 1U)));
+      if (!value.has_value()) {
+        throw std::runtime_error{ std::string{ "Term '" }.append(term).append("' requires a numeric value.") };
+      }
+    }
+
+    /// Raw fields and the sampling period.
+    if (name == "config" || name == "config1" || name == "config2") {
+      config[name == "config" ? 0U : std::size_t(name.back() - '0')] = value.value();
+    } else if (name == "period") {
+      period = value.value();
+    }
+
+    /// Terms of the PMU format.
+    else if (const auto format = this->format(pmu, name); format.has_value()) {
+      auto remaining_value = value.value();
+      auto& field = config[format->field()];
+      for (const auto& [first_bit, last_bit] : format->bit_ranges()) {
+        const auto count_bits = std::uint8_t(last_bit - first_bit + 1U);
+        const auto mask = count_bits == 64U ? ~std::uint64_t{ 0U } : (std::uint64_t{ 1U } << count_bits) - 1U;
+
+        field = (field & ~(mask << first_bit)) | ((remaining_value & mask) << first_bit);
+        remaining_value = count_bits == 64U ? 0U : remaining_value >> count_bits;
+      }
+
+      if (remaining_value != 0U) {
+        throw std::runtime_error{ std::string{ "Value of term '" }.append(name).append("' exceeds its format.") };
+      }
+    }
+
+    /// Aliases (only without value).
+    else if (const auto alias_terms = this->alias(pmu, name);
+             alias_terms.has_value() && separator == std::string_view::npos) {
+      this->apply(pmu, trim(alias_terms.value()), config, period, depth + 1U);
+    }
+
+    else {
+      throw std::runtime_error{ std::string{ "Unknown term '" }.append(name).append("'.") };
+    }
+  }
+}
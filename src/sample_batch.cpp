@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <numeric>
+#include <perfcpp/sample_batch.h>
+
+namespace {
+template<typename T>
+std::size_t
+column_memory_usage(const perf::SampleBatch::Column<T>& column) noexcept
+{
+  return column.values().capacity() * sizeof(T) + column.validity().capacity() * sizeof(std::uint64_t);
+}
+
+template<typename T>
+std::size_t
+column_memory_usage(const perf::SampleBatch::ListColumn<T>& column) noexcept
+{
+  return column.values().capacity() * sizeof(T) + column.offsets().capacity() * sizeof(std::uint64_t);
+}
+}
+
+std::size_t
+perf::SampleBatch::memory_usage() const noexcept
+{
+  return column_memory_usage(this->_instruction_pointer) + column_memory_usage(this->_process_id) +
+         column_memory_usage(this->_thread_id) + column_memory_usage(this->_time) +
+         column_memory_usage(this->_logical_memory_address) + column_memory_usage(this->_cpu_id) +
+         column_memory_usage(this->_period) + column_memory_usage(this->_weight) +
+         column_memory_usage(this->_data_src) + column_memory_usage(this->_physical_memory_address) +
+         column_memory_usage(this->_callchain) + column_memory_usage(this->_branches);
+}
+
+void
+perf::SampleBatch::enable(const SampleView::Layout& layout) noexcept
+{
+  this->_instruction_pointer._is_enabled |= layout.is_set(SampleView::InstructionPointer);
+  this->_process_id._is_enabled |= layout.is_set(SampleView::ThreadId);
+  this->_thread_id._is_enabled |= layout.is_set(SampleView::ThreadId);
+  this->_time._is_enabled |= layout.is_set(SampleView::Time);
+  this->_logical_memory_address._is_enabled |= layout.is_set(SampleView::LogicalMemoryAddress);
+  this->_cpu_id._is_enabled |= layout.is_set(SampleView::CpuId);
+  this->_period._is_enabled |= layout.is_set(SampleView::Period);
+  this->_weight._is_enabled |= layout.is_set(SampleView::Weight);
+  this->_data_src._is_enabled |= layout.is_set(SampleView::DataSource);
+  this->_physical_memory_address._is_enabled |= layout.is_set(SampleView::PhysicalMemoryAddress);
+  this->_callchain._is_enabled |= layout.is_set(SampleView::Callchain);
+  this->_branches._is_enabled |= layout.is_set(SampleView::BranchStack);
+}
+
+void
+perf::SampleBatch::push_back(const SampleView& record)
+{
+  if (record.is_loss()) {
+    this->_count_loss += record.count_loss().value_or(0U);
+    return;
+  }
+
+  if (!record.is_sample()) {
+    return;
+  }
+
+  /// Enabled columns receive a value (or a placeholder) for every sample, such that all columns have the same size.
+  if (this->_instruction_pointer._is_enabled) {
+    this->_instruction_pointer.push_back(record.instruction_pointer(), 0U);
+  }
+  if (this->_process_id._is_enabled) {
+    this->_process_id.push_back(record.process_id(), 0U);
+  }
+  if (this->_thread_id._is_enabled) {
+    this->_thread_id.push_back(record.thread_id(), 0U);
+  }
+  if (this->_time._is_enabled) {
+    this->_time.push_back(record.time(), 0U);
+  }
+  if (this->_logical_memory_address._is_enabled) {
+    this->_logical_memory_address.push_back(record.logical_memory_address(), 0U);
+  }
+  if (this->_cpu_id._is_enabled) {
+    this->_cpu_id.push_back(record.cpu_id(), 0U);
+  }
+  if (this->_period._is_enabled) {
+    this->_period.push_back(record.period(), 0U);
+  }
+  if (this->_weight._is_enabled) {
+    this->_weight.push_back(record.weight(), Weight{ 0U });
+  }
+  if (this->_data_src._is_enabled) {
+    this->_data_src.push_back(record.data_src(), DataSource{ 0U });
+  }
+  if (this->_physical_memory_address._is_enabled) {
+    this->_physical_memory_address.push_back(record.physical_memory_address(), 0U);
+  }
+  if (this->_callchain._is_enabled) {
+    this->_callchain.push_back(record.callchain(), [](const auto instruction_pointer) {
+      return std::uintptr_t{ instruction_pointer };
+    });
+  }
+  if (this->_branches._is_enabled) {
+    this->_branches.push_back(record.branches(), [](const perf_branch_entry& branch) {
+      return Branch(
+        branch.from, branch.to, branch.mispred, branch.predicted, branch.in_tx, branch.abort, branch.cycles);
+    });
+  }
+
+  ++this->_size;
+}
+
+void
+perf::SampleBatch::sort_by_time()
+{
+  if (!this->_time._is_enabled) {
+    return;
+  }
+
+  auto order = std::vector<std::size_t>(this->_size);
+  std::iota(order.begin(), order.end(), 0U);
+  std::stable_sort(order.begin(), order.end(), [&time = this->_time.values()](const auto left, const auto right) {
+    return time[left] < time[right];
+  });
+
+  /// Skip reordering if the samples are already sorted (e.g., samples of a single buffer).
+  if (std::is_sorted(order.begin(), order.end())) {
+    return;
+  }
+
+  this->_instruction_pointer.permute(order);
+  this->_process_id.permute(order);
+  this->_thread_id.permute(order);
+  this->_time.permute(order);
+  this->_logical_memory_address.permute(order);
+  this->_cpu_id.permute(order);
+  this->_period.permute(order);
+  this->_weight.permute(order);
+  this->_data_src.permute(order);
+  this->_physical_memory_address.permute(order);
+  this->_callchain.permute(order);
+  this->_branches.permute(order);
+}
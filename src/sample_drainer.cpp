@@ -0,0 +1,208 @@
+#include <perfcpp/sample_drainer.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <tuple>
+#include <unistd.h>
+
+namespace {
+/// Identifier of the stop event within the epoll instance (buffers are identified by sampler index and descriptor).
+constexpr auto STOP_EVENT_ID = std::uint64_t{ 0xFFFFFFFFFFFFFFFFULL };
+
+std::vector<perf::Sampler*>
+pointers(std::vector<perf::Sampler>& samplers)
+{
+  auto sampler_pointers = std::vector<perf::Sampler*>{};
+  sampler_pointers.reserve(samplers.size());
+  for (auto& sampler : samplers) {
+    sampler_pointers.push_back(&sampler);
+  }
+
+  return sampler_pointers;
+}
+}
+
+perf::SampleDrainer::SampleDrainer(perf::Sampler& sampler, perf::SampleDrainer::Sink&& sink)
+  : SampleDrainer(std::vector<Sampler*>{ &sampler }, std::move(sink))
+{
+}
+
+perf::SampleDrainer::SampleDrainer(perf::MultiThreadSampler& sampler, perf::SampleDrainer::Sink&& sink)
+  : SampleDrainer(pointers(static_cast<MultiSamplerBase&>(sampler).samplers()), std::move(sink))
+{
+}
+
+perf::SampleDrainer::SampleDrainer(perf::MultiCoreSampler& sampler, perf::SampleDrainer::Sink&& sink)
+  : SampleDrainer(pointers(static_cast<MultiSamplerBase&>(sampler).samplers()), std::move(sink))
+{
+}
+
+perf::SampleDrainer::SampleDrainer(std::vector<Sampler*>&& samplers, perf::SampleDrainer::Sink&& sink)
+  : _samplers(std::move(samplers))
+  , _sink(std::move(sink))
+{
+  if (!this->_sink) {
+    throw std::runtime_error{ "Cannot create a sample drainer without sink." };
+  }
+}
+
+perf::SampleDrainer::~SampleDrainer()
+{
+  this->stop();
+}
+
+void
+perf::SampleDrainer::start()
+{
+  if (this->_drain_thread.joinable()) {
+    return;
+  }
+
+  this->_epoll_file_descriptor = ::epoll_create1(EPOLL_CLOEXEC);
+  this->_stop_file_descriptor = ::eventfd(0U, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (this->_epoll_file_descriptor < 0 || this->_stop_file_descriptor < 0) {
+    const auto error = errno;
+    this->close();
+    throw std::runtime_error{ std::string{ "Cannot create epoll instance for draining samples (error no: " }
+                                .append(std::to_string(error))
+                                .append(").") };
+  }
+
+  /// Take the samplers that are opened now; the open state is not read again while the background thread runs.
+  this->_opened_samplers.clear();
+  std::copy_if(this->_samplers.begin(),
+               this->_samplers.end(),
+               std::back_inserter(this->_opened_samplers),
+               [](const auto* sampler) { return sampler->_is_opened; });
+
+  /// Wait for the stop event and the buffers of all opened samplers.
+  auto stop_event = epoll_event{};
+  stop_event.events = EPOLLIN;
+  stop_event.data.u64 = STOP_EVENT_ID;
+  auto is_registered =
+    ::epoll_ctl(this->_epoll_file_descriptor, EPOLL_CTL_ADD, this->_stop_file_descriptor, &stop_event) == 0;
+
+  for (auto sampler_id = std::uint64_t{ 0U }; sampler_id < this->_opened_samplers.size() && is_registered;
+       ++sampler_id) {
+    for (const auto& sample_counter : this->_opened_samplers[sampler_id]->_sample_counter) {
+      if (sample_counter.buffer() == nullptr) {
+        continue;
+      }
+
+      const auto file_descriptor = static_cast<std::int32_t>(sample_counter.buffer_file_descriptor());
+      auto buffer_event = epoll_event{};
+      buffer_event.events = EPOLLIN;
+      buffer_event.data.u64 = (sampler_id << 32U) | std::uint32_t(file_descriptor);
+      is_registered &= ::epoll_ctl(this->_epoll_file_descriptor, EPOLL_CTL_ADD, file_descriptor, &buffer_event) == 0;
+    }
+  }
+
+  if (!is_registered) {
+    const auto error = errno;
+    this->close();
+    throw std::runtime_error{ std::string{ "Cannot register sample buffer for draining (error no: " }
+                                .append(std::to_string(error))
+                                .append(").") };
+  }
+
+  this->_count_samples.store(0U);
+  this->_count_batches.store(0U);
+
+  this->_drain_thread = std::thread{ &SampleDrainer::run, this };
+}
+
+void
+perf::SampleDrainer::stop()
+{
+  if (!this->_drain_thread.joinable()) {
+    return;
+  }
+
+  /// Wake up the background thread, which drains the signaled buffers one last time.
+  const auto stop_value = std::uint64_t{ 1U };
+  std::ignore = ::write(this->_stop_file_descriptor, &stop_value, sizeof(stop_value));
+  this->_drain_thread.join();
+  this->close();
+
+  /// Drain the samples below the wakeup mark of their buffers.
+  this->drain(this->_opened_samplers);
+}
+
+void
+perf::SampleDrainer::drain(const std::vector<Sampler*>& samplers)
+{
+  auto batch = std::vector<Sample>{};
+
+  for (auto* sampler : samplers) {
+    std::ignore = sampler->for_each_sample([&batch](Sample&& sample) { batch.push_back(std::move(sample)); });
+  }
+
+  if (!batch.empty()) {
+    this->_count_samples.fetch_add(batch.size());
+    this->_count_batches.fetch_add(1U);
+    this->_sink(std::move(batch));
+  }
+}
+
+void
+perf::SampleDrainer::close() noexcept
+{
+  if (this->_epoll_file_descriptor > -1) {
+    ::close(this->_epoll_file_descriptor);
+    this->_epoll_file_descriptor = -1;
+  }
+
+  if (this->_stop_file_descriptor > -1) {
+    ::close(this->_stop_file_descriptor);
+    this->_stop_file_descriptor = -1;
+  }
+}
+
+void
+perf::SampleDrainer::run()
+{
+  auto events = std::array<epoll_event, 64U>{};
+  auto signaled_samplers = std::vector<Sampler*>{};
+  signaled_samplers.reserve(this->_opened_samplers.size());
+
+  auto is_stop_requested = false;
+  while (!is_stop_requested) {
+    const auto count_events =
+      ::epoll_wait(this->_epoll_file_descriptor, events.data(), static_cast<std::int32_t>(events.size()), -1);
+    if (count_events < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    signaled_samplers.clear();
+    for (auto event_id = 0; event_id < count_events; ++event_id) {
+      const auto& event = events[event_id];
+      if (event.data.u64 == STOP_EVENT_ID) {
+        is_stop_requested = true;
+        continue;
+      }
+
+      auto* sampler = this->_opened_samplers[event.data.u64 >> 32U];
+      if (std::find(signaled_samplers.begin(), signaled_samplers.end(), sampler) == signaled_samplers.end()) {
+        signaled_samplers.push_back(sampler);
+      }
+
+      /// Buffers of exited threads report a hang-up on every wait; drain them a last time and stop waiting for them.
+      if ((event.events & (EPOLLHUP | EPOLLERR)) != 0U) {
+        ::epoll_ctl(this->_epoll_file_descriptor,
+                    EPOLL_CTL_DEL,
+                    static_cast<std::int32_t>(event.data.u64 & 0xFFFFFFFFULL),
+                    nullptr);
+      }
+    }
+
+    this->drain(signaled_samplers);
+  }
+}
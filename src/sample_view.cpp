@@ -0,0 +1,297 @@
+#include <perfcpp/sample_view.h>
+
+namespace {
+/**
+ * Sample type flag per field of the record.
+ */
+constexpr std::array<std::uint64_t, perf::SampleView::CountFields> FIELD_SAMPLE_TYPES{
+  PERF_SAMPLE_IDENTIFIER,
+  PERF_SAMPLE_IP,
+  PERF_SAMPLE_TID,
+  PERF_SAMPLE_TIME,
+  PERF_SAMPLE_ADDR,
+  PERF_SAMPLE_ID,
+  PERF_SAMPLE_STREAM_ID,
+  PERF_SAMPLE_CPU,
+  PERF_SAMPLE_PERIOD,
+  PERF_SAMPLE_READ,
+  PERF_SAMPLE_CALLCHAIN,
+  PERF_SAMPLE_RAW,
+  PERF_SAMPLE_BRANCH_STACK,
+  PERF_SAMPLE_REGS_USER,
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  PERF_SAMPLE_WEIGHT | PERF_SAMPLE_WEIGHT_STRUCT,
+#else
+  PERF_SAMPLE_WEIGHT,
+#endif
+  PERF_SAMPLE_DATA_SRC,
+  PERF_SAMPLE_TRANSACTION,
+  PERF_SAMPLE_REGS_INTR,
+#ifndef PERFCPP_NO_SAMPLE_PHYS_ADDR
+  PERF_SAMPLE_PHYS_ADDR,
+#else
+  0U,
+#endif
+#ifndef PERFCPP_NO_SAMPLE_CGROUP
+  PERF_SAMPLE_CGROUP,
+#else
+  0U,
+#endif
+#ifndef PERFCPP_NO_SAMPLE_DATA_PAGE_SIZE
+  PERF_SAMPLE_DATA_PAGE_SIZE,
+#else
+  0U,
+#endif
+#ifndef PERFCPP_NO_SAMPLE_CODE_PAGE_SIZE
+  PERF_SAMPLE_CODE_PAGE_SIZE,
+#else
+  0U,
+#endif
+};
+
+/**
+ * @param field Field of the record.
+ * @return True, if the length of the field depends on the record.
+ */
+constexpr bool
+is_variable_field(const perf::SampleView::Field field) noexcept
+{
+  return field == perf::SampleView::CounterValues || field == perf::SampleView::Callchain ||
+         field == perf::SampleView::Raw || field == perf::SampleView::BranchStack ||
+         field == perf::SampleView::UserRegisters || field == perf::SampleView::KernelRegisters;
+}
+}
+
+perf::SampleView::Layout::Layout() noexcept
+{
+  this->_offsets.fill(UNKNOWN_OFFSET);
+}
+
+perf::SampleView::Layout::Layout(const std::uint64_t sample_type,
+                                 const std::uint64_t branch_sample_type,
+                                 const std::size_t count_user_registers,
+                                 const std::size_t count_kernel_registers) noexcept
+  : Layout()
+{
+#ifndef PERFCPP_NO_SAMPLE_BRANCH_HW_INDEX
+  this->_is_branch_hw_index = (branch_sample_type & PERF_SAMPLE_BRANCH_HW_INDEX) != 0U;
+#else
+  static_cast<void>(branch_sample_type);
+#endif
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  this->_is_weight_struct = (sample_type & PERF_SAMPLE_WEIGHT_STRUCT) != 0U;
+#endif
+  this->_count_user_registers = count_user_registers;
+  this->_count_kernel_registers = count_kernel_registers;
+
+  /// All fields in front of the first variable-length field have a fixed offset (each fixed-size field has 8 bytes).
+  auto offset = std::uint16_t{ 0U };
+  for (auto field_id = 0U; field_id < CountFields; ++field_id) {
+    const auto field = static_cast<Field>(field_id);
+    if ((sample_type & FIELD_SAMPLE_TYPES[field]) == 0U) {
+      continue;
+    }
+
+    this->_fields |= 1U << field;
+
+    if (this->_first_variable_field == CountFields) {
+      if (is_variable_field(field)) {
+        this->_first_variable_field = field;
+      } else {
+        this->_offsets[field] = offset;
+        offset += sizeof(std::uint64_t);
+      }
+    }
+  }
+}
+
+std::optional<perf::Weight>
+perf::SampleView::weight() const noexcept
+{
+  const auto offset = this->offset(Weight);
+  if (offset == Layout::UNKNOWN_OFFSET) {
+    return std::nullopt;
+  }
+
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  /// The weight is either a single value or a struct of three values.
+  if (this->_layout.is_weight_struct()) {
+    const auto weight = this->read<perf_sample_weight>(offset);
+    return weight.has_value()
+             ? std::make_optional(perf::Weight{ weight->var1_dw, weight->var2_w, weight->var3_w })
+             : std::nullopt;
+  }
+#endif
+
+  const auto weight = this->read<std::uint64_t>(offset);
+  return weight.has_value() ? std::make_optional(perf::Weight{ static_cast<std::uint32_t>(weight.value()) })
+                            : std::nullopt;
+}
+
+perf::ArrayView<std::uint64_t>
+perf::SampleView::callchain() const noexcept
+{
+  const auto offset = this->offset(Callchain);
+  if (offset == Layout::UNKNOWN_OFFSET) {
+    return ArrayView<std::uint64_t>{};
+  }
+
+  const auto count_instruction_pointers = this->read<std::uint64_t>(offset);
+  return count_instruction_pointers.has_value()
+           ? this->array<std::uint64_t>(offset + sizeof(std::uint64_t), count_instruction_pointers.value())
+           : ArrayView<std::uint64_t>{};
+}
+
+perf::ArrayView<perf_branch_entry>
+perf::SampleView::branches() const noexcept
+{
+  const auto offset = this->offset(BranchStack);
+  if (offset == Layout::UNKNOWN_OFFSET) {
+    return ArrayView<perf_branch_entry>{};
+  }
+
+  /// The number of branches is followed by the hardware index (if requested) and the branches.
+  const auto count_branches = this->read<std::uint64_t>(offset);
+  const auto branches_offset =
+    offset + sizeof(std::uint64_t) + (this->_layout.is_branch_hw_index() ? sizeof(std::uint64_t) : 0U);
+  return count_branches.has_value() ? this->array<perf_branch_entry>(branches_offset, count_branches.value())
+                                    : ArrayView<perf_branch_entry>{};
+}
+
+perf::ArrayView<char>
+perf::SampleView::raw() const noexcept
+{
+  const auto offset = this->offset(Raw);
+  if (offset == Layout::UNKNOWN_OFFSET) {
+    return ArrayView<char>{};
+  }
+
+  const auto raw_data_size = this->read<std::uint32_t>(offset);
+  return raw_data_size.has_value() ? this->array<char>(offset + sizeof(std::uint32_t), raw_data_size.value())
+                                   : ArrayView<char>{};
+}
+
+perf::ArrayView<std::uint64_t>
+perf::SampleView::registers(const Field field) const noexcept
+{
+  const auto offset = this->offset(field);
+  if (offset == Layout::UNKNOWN_OFFSET) {
+    return ArrayView<std::uint64_t>{};
+  }
+
+  /// Registers are only recorded if the ABI is known (e.g., not for kernel threads).
+  const auto abi = this->read<std::uint64_t>(offset);
+  if (!abi.has_value() || abi.value() == PERF_SAMPLE_REGS_ABI_NONE) {
+    return ArrayView<std::uint64_t>{};
+  }
+
+  const auto count_registers =
+    field == UserRegisters ? this->_layout.count_user_registers() : this->_layout.count_kernel_registers();
+  return this->array<std::uint64_t>(offset + sizeof(std::uint64_t), count_registers);
+}
+
+std::optional<double>
+perf::SampleView::counter_value(const std::string_view name) const noexcept
+{
+  const auto offset = this->offset(CounterValues);
+  if (offset == Layout::UNKNOWN_OFFSET) {
+    return std::nullopt;
+  }
+
+  /// Counter values are recorded as number of values, time enabled and running, and (value, id) per counter.
+  const auto count_counter_values = this->read<std::uint64_t>(offset);
+  const auto time_enabled = this->read<std::uint64_t>(offset + sizeof(std::uint64_t));
+  const auto time_running = this->read<std::uint64_t>(offset + 2U * sizeof(std::uint64_t));
+  if (!count_counter_values.has_value() || !time_enabled.has_value() || !time_running.has_value() ||
+      count_counter_values.value() != this->_counter_names.size()) {
+    return std::nullopt;
+  }
+
+  for (auto counter_id = 0U; counter_id < this->_counter_names.size(); ++counter_id) {
+    if (this->_counter_names[counter_id] == name) {
+      const auto value = this->read<std::uint64_t>(offset + (3U + 2U * counter_id) * sizeof(std::uint64_t));
+      if (!value.has_value()) {
+        return std::nullopt;
+      }
+
+      const auto multiplexing_correction = double(time_enabled.value()) / double(time_running.value());
+      return double(value.value()) * multiplexing_correction;
+    }
+  }
+
+  return std::nullopt;
+}
+
+void
+perf::SampleView::resolve_offsets() const noexcept
+{
+  this->_resolved_offsets.fill(Layout::UNKNOWN_OFFSET);
+  this->_is_resolved = true;
+
+  /// Start at the first variable-length field, located behind the fixed-size fields.
+  auto offset = std::size_t{ 0U };
+  for (auto field_id = 0U; field_id < this->_layout.first_variable_field(); ++field_id) {
+    offset += this->_layout.is_set(static_cast<Field>(field_id)) ? sizeof(std::uint64_t) : 0U;
+  }
+
+  const auto payload_size = std::size_t{ this->_header->size } - sizeof(perf_event_header);
+  for (auto field_id = std::uint32_t{ this->_layout.first_variable_field() }; field_id < CountFields; ++field_id) {
+    const auto field = static_cast<Field>(field_id);
+    if (!this->_layout.is_set(field)) {
+      continue;
+    }
+
+    /// Fields behind the end of the record (malformed records) remain unknown.
+    if (offset + sizeof(std::uint64_t) > payload_size) {
+      return;
+    }
+    this->_resolved_offsets[field] = static_cast<std::uint16_t>(offset);
+
+    /// Skip the field, reading only the length of variable-length fields (the size of raw data has 32 bits).
+    const auto length = field == Raw ? std::uint64_t{ this->read<std::uint32_t>(offset).value() }
+                                     : this->read<std::uint64_t>(offset).value();
+    switch (field) {
+      case CounterValues:
+        offset += (3U + 2U * length) * sizeof(std::uint64_t);
+        break;
+      case Callchain:
+        offset += (1U + length) * sizeof(std::uint64_t);
+        break;
+      case Raw:
+        offset += sizeof(std::uint32_t) + length;
+        break;
+      case BranchStack:
+        offset += (this->_layout.is_branch_hw_index() ? 2U : 1U) * sizeof(std::uint64_t) +
+                  length * sizeof(perf_branch_entry);
+        break;
+      case UserRegisters:
+        offset += (1U + (length != PERF_SAMPLE_REGS_ABI_NONE ? this->_layout.count_user_registers() : 0U)) *
+                  sizeof(std::uint64_t);
+        break;
+      case KernelRegisters:
+        offset += (1U + (length != PERF_SAMPLE_REGS_ABI_NONE ? this->_layout.count_kernel_registers() : 0U)) *
+                  sizeof(std::uint64_t);
+        break;
+      default:
+        offset += sizeof(std::uint64_t);
+    }
+  }
+}
+
+perf::Sample::Mode
+perf::SampleView::mode(const std::uint16_t misc) noexcept
+{
+  if (static_cast<bool>(misc & PERF_RECORD_MISC_KERNEL)) {
+    return Sample::Mode::Kernel;
+  } else if (static_cast<bool>(misc & PERF_RECORD_MISC_USER)) {
+    return Sample::Mode::User;
+  } else if (static_cast<bool>(misc & PERF_RECORD_MISC_HYPERVISOR)) {
+    return Sample::Mode::Hypervisor;
+  } else if (static_cast<bool>(misc & PERF_RECORD_MISC_GUEST_KERNEL)) {
+    return Sample::Mode::GuestKernel;
+  } else if (static_cast<bool>(misc & PERF_RECORD_MISC_GUEST_USER)) {
+    return Sample::Mode::GuestUser;
+  }
+
+  return Sample::Mode::Unknown;
+}
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <asm/unistd.h>
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <perfcpp/sampler.h>
@@ -132,13 +133,28 @@ perf::Sampler::trigger(std::vector<std::vector<Trigger>>&& triggers)
 }
 
 void
-perf::Sampler::open()
+perf::Sampler::open(const perf::Sampler* resolved_sampler)
 {
   /// Do not open again, if the sampler was already opened.
-  if (std::exchange(this->_is_opened, true)) {
+  if (this->_is_opened) {
     return;
   }
 
+  /// The buffer consists of one control page and 2^n data pages.
+  const auto count_data_pages = this->_config.buffer_pages() - 1U;
+  if (this->_config.buffer_pages() < 2U || (count_data_pages & (count_data_pages - 1U)) != 0U) {
+    throw std::runtime_error{ std::string{ "Cannot open sampler with " }
+                                .append(std::to_string(this->_config.buffer_pages()))
+                                .append(" buffer pages: Expected 1 + 2^n pages (e.g., 1 + 64).") };
+  }
+  this->_is_opened = true;
+
+  /// Offsets of the fields within sample records, used by views on the records.
+  this->_sample_layout = SampleView::Layout{ this->_values.get(),
+                                             this->_values.branch_mask(),
+                                             this->_values.user_registers().size(),
+                                             this->_values.kernel_registers().size() };
+
   /// Build the groups from triggers + counters from values.
   for (const auto& trigger_group : this->_triggers) {
     auto group = Group{};
@@ -214,13 +230,56 @@ perf::Sampler::open()
     throw std::runtime_error{ "No trigger for sampling specified." };
   }
 
-  for (auto& sample_counter : this->_sample_counter) {
+  /// On hybrid processors, generic hardware events only sample on the core PMU they are bound to: Open one instance of
+  /// every group per core PMU; the samples of all instances are merged when reading the results.
+  const auto count_sample_counters = this->_sample_counter.size();
+  for (auto sample_counter_id = std::size_t{ 0U }; sample_counter_id < count_sample_counters; ++sample_counter_id) {
+    const auto hybrid_pmus = this->_sample_counter[sample_counter_id].group().hybrid_pmus(this->_config);
+    for (auto pmu_id = 1U; pmu_id < hybrid_pmus.size(); ++pmu_id) {
+      auto hybrid_sample_counter = SampleCounter{ this->_sample_counter[sample_counter_id] };
+      hybrid_sample_counter.group().hybrid_pmu(hybrid_pmus[pmu_id]);
+      this->_sample_counter.emplace_back(std::move(hybrid_sample_counter));
+    }
+
+    if (!hybrid_pmus.empty()) {
+      this->_sample_counter[sample_counter_id].group().hybrid_pmu(hybrid_pmus.front());
+    }
+  }
+
+  /// Counters of the resolved sampler can only be reused if both samplers have the same groups.
+  const auto is_resolved_sampler_reusable =
+    resolved_sampler != nullptr && resolved_sampler->_sample_counter.size() == this->_sample_counter.size() &&
+    std::equal(this->_sample_counter.begin(),
+               this->_sample_counter.end(),
+               resolved_sampler->_sample_counter.begin(),
+               [](const auto& sample_counter, const auto& resolved_sample_counter) {
+                 return sample_counter.group().size() == resolved_sample_counter.group().size();
+               });
+
+  for (auto sample_counter_id = 0U; sample_counter_id < this->_sample_counter.size(); ++sample_counter_id) {
+    auto& sample_counter = this->_sample_counter[sample_counter_id];
+
     /// Detect, if the leader is an auxiliary (specifically for Sapphire Rapids).
     const auto is_leader_auxiliary_counter = sample_counter.group().member(0U).is_auxiliary();
 
+    /// Pinning and exclusivity are properties of the group (set on the leader only).
+    const auto& members = sample_counter.group().members();
+    const auto is_pinned =
+      this->_config.is_pinned() ||
+      std::any_of(members.begin(), members.end(), [](const auto& counter) { return counter.is_pinned(); });
+    const auto is_exclusive =
+      this->_config.is_exclusive() ||
+      std::any_of(members.begin(), members.end(), [](const auto& counter) { return counter.is_exclusive(); });
+
     for (auto counter_index = 0U; counter_index < sample_counter.group().size(); ++counter_index) {
       auto& counter = sample_counter.group().member(counter_index);
 
+      /// Start with the precise_ip that worked for the resolved sampler (e.g., on another core) to skip retries.
+      if (is_resolved_sampler_reusable) {
+        const auto& resolved_group = resolved_sampler->_sample_counter[sample_counter_id].group();
+        counter.precise_ip(resolved_group.member(counter_index).precise_ip());
+      }
+
       /// The first counter in the group has a "special" role, others will use its file descriptor.
       const auto is_leader = counter_index == 0U;
 
@@ -235,7 +294,12 @@ perf::Sampler::open()
       perf_event.config = counter.event_id();
       perf_event.config1 = counter.event_id_extension()[0U];
       perf_event.config2 = counter.event_id_extension()[1U];
+      if (sample_counter.group().hybrid_pmu() != nullptr) {
+        sample_counter.group().hybrid_pmu()->bind(perf_event);
+      }
       perf_event.disabled = is_leader;
+      perf_event.pinned = static_cast<std::uint64_t>(is_leader && is_pinned);
+      perf_event.exclusive = static_cast<std::uint64_t>(is_leader && is_exclusive);
 
       perf_event.inherit = static_cast<std::int32_t>(this->_config.is_include_child_threads());
       perf_event.exclude_kernel = static_cast<std::int32_t>(!this->_config.is_include_kernel());
@@ -277,6 +341,14 @@ perf::Sampler::open()
 #ifndef PERFCPP_NO_RECORD_CGROUP
         perf_event.cgroup = this->_values.is_set(PERF_SAMPLE_CGROUP) ? 1U : 0U;
 #endif
+
+        /// Wake up consumers polling the buffer after a number of bytes or samples.
+        if (this->_config.wakeup_watermark() > 0U) {
+          perf_event.watermark = 1U;
+          perf_event.wakeup_watermark = this->_config.wakeup_watermark();
+        } else {
+          perf_event.wakeup_events = this->_config.wakeup_events();
+        }
       }
 
       if (this->_values.is_set(PERF_SAMPLE_READ)) {
@@ -290,6 +362,13 @@ perf::Sampler::open()
       const std::int32_t cpu_id =
         this->_config.cpu_id().has_value() ? std::int32_t{ this->_config.cpu_id().value() } : -1;
 
+      /// Samplers of a cgroup are opened with the file descriptor of the cgroup instead of a process id.
+      if (this->_config.cgroup_file_descriptor().has_value() && cpu_id < 0) {
+        throw std::runtime_error{ "Sampling a cgroup requires a specific CPU core (e.g., via MultiCoreSampler)." };
+      }
+      const auto process_id = this->_config.cgroup_file_descriptor().value_or(this->_config.process_id());
+      const auto flags = this->_config.cgroup_file_descriptor().has_value() ? PERF_FLAG_PID_CGROUP : 0UL;
+
       /// Open the counter. Try to decrease the precise_ip if the file syscall was not successful, reporting an invalid
       /// argument.
       std::int64_t file_descriptor;
@@ -302,10 +381,10 @@ perf::Sampler::open()
 
         file_descriptor = ::syscall(__NR_perf_event_open,
                                     &perf_event,
-                                    this->_config.process_id(),
+                                    process_id,
                                     cpu_id,
                                     sample_counter.group().leader_file_descriptor(),
-                                    0);
+                                    flags);
 
         /// If opening the file descriptor was successfully, we can start the counter.
         /// Otherwise, we will try to decrease the precision and try again.
@@ -336,7 +415,7 @@ perf::Sampler::open()
                                    : sample_counter.group().leader_file_descriptor();
     auto* buffer = ::mmap(nullptr,
                           this->_config.buffer_pages() * 4096U,
-                          PROT_READ,
+                          PROT_READ | PROT_WRITE, /// Writable to publish the tail when draining the buffer.
                           MAP_SHARED,
                           static_cast<std::int32_t>(file_descriptor),
                           0);
@@ -349,7 +428,7 @@ perf::Sampler::open()
       throw std::runtime_error{ "Created buffer via mmap() is null." };
     }
 
-    sample_counter.buffer(buffer);
+    sample_counter.buffer(buffer, file_descriptor);
   }
 }
 
@@ -397,51 +476,196 @@ perf::Sampler::close()
   }
 }
 
+template<typename F>
+std::uint64_t
+perf::Sampler::read_records(const SampleCounter& sample_counter,
+                            std::uint64_t tail,
+                            const std::uint64_t head,
+                            std::vector<std::uint8_t>& scratch,
+                            F&& callback) const
+{
+  const auto* mmap_page = reinterpret_cast<const perf_event_mmap_page*>(sample_counter.buffer());
+
+  /// The data area starts at page 1 (from 0); older kernels do not report offset and size.
+  const auto data_offset = mmap_page->data_size > 0U ? mmap_page->data_offset : std::uint64_t{ 4096U };
+  const auto data_size =
+    mmap_page->data_size > 0U ? mmap_page->data_size : (this->_config.buffer_pages() - 1U) * std::uint64_t{ 4096U };
+  auto* data = reinterpret_cast<std::uint8_t*>(sample_counter.buffer()) + data_offset;
+
+  /// The perf subsystem never writes more than the data area ahead of the tail and keeps records 8-byte aligned;
+  /// otherwise, the records are garbage and skipped.
+  if (data_size == 0U || head < tail || head - tail > data_size || tail % sizeof(std::uint64_t) != 0U) {
+    return head;
+  }
+
+  /// Head and tail grow continuously; records are located at their offset modulo the size of the data area.
+  /// Since records are 8-byte aligned, the header never wraps around the end of the data area.
+  while (tail < head) {
+    const auto offset = tail % data_size;
+    auto* event_header = reinterpret_cast<perf_event_header*>(data + offset);
+    const auto size = std::uint64_t{ event_header->size };
+
+    /// The head is published only after writing complete records: Records exceeding the head are malformed. Since
+    /// the following records cannot be located, skip them (rather than blocking the buffer forever).
+    if (size < sizeof(perf_event_header) || size % sizeof(std::uint64_t) != 0U || tail + size > head) {
+      return head;
+    }
+
+    /// Reassemble records that wrap around the end of the data area.
+    if (offset + size > data_size) {
+      const auto size_until_end = data_size - offset;
+      if (scratch.size() < size) {
+        scratch.resize(size);
+      }
+      std::memcpy(scratch.data(), data + offset, size_until_end);
+      std::memcpy(scratch.data() + size_until_end, data, size - size_until_end);
+      event_header = reinterpret_cast<perf_event_header*>(scratch.data());
+    }
+
+    callback(event_header);
+
+    /// Go to the next record.
+    tail += size;
+  }
+
+  return tail;
+}
+
 std::vector<perf::Sample>
 perf::Sampler::result(const bool sort_by_time) const
 {
   auto result = std::vector<Sample>{};
   result.reserve(2048U);
 
+  auto scratch = std::vector<std::uint8_t>{};
   for (const auto& sample_counter : this->_sample_counter) {
     if (sample_counter.buffer() == nullptr) {
       continue;
     }
 
-    auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(sample_counter.buffer());
+    /// Read all records that were not consumed yet, without consuming them.
+    const auto* mmap_page = reinterpret_cast<const perf_event_mmap_page*>(sample_counter.buffer());
+    std::ignore = this->read_records(
+      sample_counter,
+      mmap_page->data_tail,
+      Sampler::data_head(mmap_page),
+      scratch,
+      [&](perf_event_header* event_header) {
+        if (auto sample = this->read_record(UserLevelBufferEntry{ event_header }, sample_counter); sample.has_value()) {
+          result.push_back(std::move(sample.value()));
+        }
+      });
+  }
 
-    /// When the ringbuffer is empty or already read, there is nothing to do.
-    if (mmap_page->data_tail >= mmap_page->data_head) {
-      return result;
+  /// Sort the samples if requested and we can sort by time.
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+  }
+
+  return result;
+}
+
+perf::SampleBatch
+perf::Sampler::result_columnar(const bool sort_by_time) const
+{
+  auto batch = SampleBatch{};
+  batch.enable(this->_sample_layout);
+  this->read_columnar(batch);
+
+  /// Sort the samples if requested and we can sort by time.
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    batch.sort_by_time();
+  }
+
+  return batch;
+}
+
+void
+perf::Sampler::read_columnar(SampleBatch& batch) const
+{
+  auto scratch = std::vector<std::uint8_t>{};
+  for (const auto& sample_counter : this->_sample_counter) {
+    if (sample_counter.buffer() == nullptr) {
+      continue;
     }
 
-    /// The buffer starts at page 1 (from 0).
-    auto iterator = std::uintptr_t(sample_counter.buffer()) + 4096U;
-
-    /// data_head is the size (in bytes) of the samples.
-    const auto end = iterator + mmap_page->data_head;
-
-    while (iterator < end) {
-      auto* event_header = reinterpret_cast<perf_event_header*>(iterator);
-      auto entry = UserLevelBufferEntry{ event_header };
-
-      if (entry.is_sample_event()) { /// Read "normal" samples.
-        result.push_back(this->read_sample_event(entry, sample_counter));
-      } else if (entry.is_loss_event()) { /// Read lost samples.
-        result.push_back(this->read_loss_event(entry));
-      } else if (entry.is_context_switch_event()) { /// Read context switch.
-        result.push_back(this->read_context_switch_event(entry));
-      } else if (entry.is_cgroup_event()) { /// Read cgroup samples.
-        result.push_back(this->read_cgroup_event(entry));
-      } else if (entry.is_throttle_event() && this->_values._is_include_throttle) { /// Read (un-) throttle samples.
-        result.push_back(this->read_throttle_event(entry));
-      }
+    /// Read all records that were not consumed yet, without consuming them.
+    const auto* mmap_page = reinterpret_cast<const perf_event_mmap_page*>(sample_counter.buffer());
+    std::ignore = this->read_records(sample_counter,
+                                     mmap_page->data_tail,
+                                     Sampler::data_head(mmap_page),
+                                     scratch,
+                                     [&](const perf_event_header* event_header) {
+                                       batch.push_back(SampleView{
+                                         event_header, this->_sample_layout, sample_counter.counter_names() });
+                                     });
+  }
+}
 
-      /// Go to the next sample.
-      iterator += event_header->size;
+std::size_t
+perf::Sampler::for_each_sample(const std::function<void(Sample&&)>& callback)
+{
+  auto count_samples = std::size_t{ 0U };
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    if (sample_counter.buffer() == nullptr) {
+      continue;
     }
+
+    auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(sample_counter.buffer());
+    const auto tail = this->read_records(
+      sample_counter,
+      mmap_page->data_tail,
+      Sampler::data_head(mmap_page),
+      this->_scratch,
+      [&](perf_event_header* event_header) {
+        if (auto sample = this->read_record(UserLevelBufferEntry{ event_header }, sample_counter); sample.has_value()) {
+          callback(std::move(sample.value()));
+          ++count_samples;
+        }
+      });
+
+    /// Hand the space of the consumed records back to the perf subsystem.
+    Sampler::data_tail(mmap_page, tail);
   }
 
+  return count_samples;
+}
+
+std::size_t
+perf::Sampler::for_each_sample_view(const std::function<void(const SampleView&)>& callback)
+{
+  auto count_records = std::size_t{ 0U };
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    if (sample_counter.buffer() == nullptr) {
+      continue;
+    }
+
+    auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(sample_counter.buffer());
+    const auto tail = this->read_records(
+      sample_counter,
+      mmap_page->data_tail,
+      Sampler::data_head(mmap_page),
+      this->_scratch,
+      [&](const perf_event_header* event_header) {
+        callback(SampleView{ event_header, this->_sample_layout, sample_counter.counter_names() });
+        ++count_records;
+      });
+
+    /// Hand the space of the consumed records back to the perf subsystem.
+    Sampler::data_tail(mmap_page, tail);
+  }
+
+  return count_records;
+}
+
+std::vector<perf::Sample>
+perf::Sampler::drain(const bool sort_by_time)
+{
+  auto result = std::vector<Sample>{};
+  std::ignore = this->for_each_sample([&result](Sample&& sample) { result.push_back(std::move(sample)); });
+
   /// Sort the samples if requested and we can sort by time.
   if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
     std::sort(result.begin(), result.end(), SampleTimestampComparator{});
@@ -450,6 +674,52 @@ perf::Sampler::result(const bool sort_by_time) const
   return result;
 }
 
+std::uint64_t
+perf::Sampler::data_head(const perf_event_mmap_page* mmap_page) noexcept
+{
+  const auto head = reinterpret_cast<const volatile perf_event_mmap_page*>(mmap_page)->data_head;
+
+  /// Read the records only after reading the head (pairs with the write barrier of the perf subsystem).
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return head;
+}
+
+void
+perf::Sampler::data_tail(perf_event_mmap_page* mmap_page, const std::uint64_t tail) noexcept
+{
+  /// Finish reading the records before handing their space back, the perf subsystem may overwrite them afterward.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  reinterpret_cast<volatile perf_event_mmap_page*>(mmap_page)->data_tail = tail;
+}
+
+std::optional<perf::Sample>
+perf::Sampler::read_record(UserLevelBufferEntry entry, const SampleCounter& sample_counter) const
+{
+  if (entry.is_sample_event()) { /// Read "normal" samples.
+    return this->read_sample_event(entry, sample_counter);
+  }
+
+  if (entry.is_loss_event()) { /// Read lost samples.
+    return this->read_loss_event(entry);
+  }
+
+  if (entry.is_context_switch_event()) { /// Read context switch.
+    return this->read_context_switch_event(entry);
+  }
+
+  if (entry.is_cgroup_event()) { /// Read cgroup samples.
+    return this->read_cgroup_event(entry);
+  }
+
+  if (entry.is_throttle_event() && this->_values._is_include_throttle) { /// Read (un-) throttle samples.
+    return this->read_throttle_event(entry);
+  }
+
+  return std::nullopt;
+}
+
 void
 perf::Sampler::read_sample_id(perf::Sampler::UserLevelBufferEntry& entry, perf::Sample& sample) const noexcept
 {
@@ -479,19 +749,7 @@ perf::Sampler::read_sample_id(perf::Sampler::UserLevelBufferEntry& entry, perf::
 perf::Sample::Mode
 perf::Sampler::UserLevelBufferEntry::mode() const noexcept
 {
-  if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_KERNEL)) {
-    return Sample::Mode::Kernel;
-  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_USER)) {
-    return Sample::Mode::User;
-  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_HYPERVISOR)) {
-    return Sample::Mode::Hypervisor;
-  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_GUEST_KERNEL)) {
-    return Sample::Mode::GuestKernel;
-  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_GUEST_USER)) {
-    return Sample::Mode::GuestUser;
-  }
-
-  return Sample::Mode::Unknown;
+  return SampleView::mode(this->_misc);
 }
 
 perf::Sample
@@ -546,7 +804,7 @@ perf::Sampler::read_sample_event(perf::Sampler::UserLevelBufferEntry entry, cons
 
     /// Read the counters (if the number matches the number of specified counters).
     auto* counter_values = entry.read<read_format::value>(count_counter_values);
-    if (count_counter_values == sample_counter.group().size()) {
+    if (counter_values != nullptr && count_counter_values == sample_counter.group().size()) {
       auto counter_results = std::vector<std::pair<std::string_view, double>>{};
 
       /// Add each counter and its value to the result set of the sample.
@@ -566,12 +824,12 @@ perf::Sampler::read_sample_event(perf::Sampler::UserLevelBufferEntry entry, cons
     /// Read the size of the callchain.
     const auto callchain_size = entry.read<std::uint64_t>();
 
-    if (callchain_size > 0U) {
+    /// Read the callchain entries.
+    const auto* instruction_pointers = entry.read<std::uint64_t>(callchain_size);
+    if (callchain_size > 0U && instruction_pointers != nullptr) {
       auto callchain = std::vector<std::uintptr_t>{};
       callchain.reserve(callchain_size);
 
-      /// Read the callchain entries.
-      auto* instruction_pointers = entry.read<std::uint64_t>(callchain_size);
       for (auto index = 0U; index < callchain_size; ++index) {
         callchain.push_back(std::uintptr_t{ instruction_pointers[index] });
       }
@@ -585,25 +843,26 @@ perf::Sampler::read_sample_event(perf::Sampler::UserLevelBufferEntry entry, cons
     const auto raw_data_size = entry.read<std::uint32_t>();
 
     /// Read the raw data.
-    const auto* raw_sample_data = entry.read<char>(raw_data_size);
-    auto raw_data = std::vector<char>(std::size_t{ raw_data_size }, '\0');
-    for (auto i = 0U; i < raw_data_size; ++i) {
-      raw_data[i] = raw_sample_data[i];
-    }
+    if (const auto* raw_sample_data = entry.read<char>(raw_data_size); raw_sample_data != nullptr) {
+      auto raw_data = std::vector<char>(std::size_t{ raw_data_size }, '\0');
+      for (auto i = 0U; i < raw_data_size; ++i) {
+        raw_data[i] = raw_sample_data[i];
+      }
 
-    sample.raw(std::move(raw_data));
+      sample.raw(std::move(raw_data));
+    }
   }
 
   if (this->_values.is_set(PERF_SAMPLE_BRANCH_STACK)) {
     /// Read the size of the branch stack.
     const auto count_branches = entry.read<std::uint64_t>();
 
-    if (count_branches > 0U) {
+    /// Read the branch stack entries.
+    const auto* sampled_branches = entry.read<perf_branch_entry>(count_branches);
+    if (count_branches > 0U && sampled_branches != nullptr) {
       auto branches = std::vector<Branch>{};
       branches.reserve(count_branches);
 
-      /// Read the branch stack entries.
-      auto* sampled_branches = entry.read<perf_branch_entry>(count_branches);
       for (auto i = 0U; i < count_branches; ++i) {
         const auto& branch = sampled_branches[i];
         branches.emplace_back(
@@ -621,12 +880,12 @@ perf::Sampler::read_sample_event(perf::Sampler::UserLevelBufferEntry entry, cons
     /// Read the number of registers.
     const auto count_user_registers = this->_values.user_registers().size();
 
-    if (count_user_registers > 0U) {
+    /// Read the register values.
+    const auto* perf_user_registers = entry.read<std::uint64_t>(count_user_registers);
+    if (count_user_registers > 0U && perf_user_registers != nullptr) {
       auto user_registers = std::vector<std::uint64_t>{};
       user_registers.reserve(count_user_registers);
 
-      /// Read the register values.
-      const auto* perf_user_registers = entry.read<std::uint64_t>(count_user_registers);
       for (auto register_id = 0U; register_id < count_user_registers; ++register_id) {
         user_registers.push_back(perf_user_registers[register_id]);
       }
@@ -661,12 +920,12 @@ perf::Sampler::read_sample_event(perf::Sampler::UserLevelBufferEntry entry, cons
     /// Read the number of registers.
     const auto count_kernel_registers = this->_values.kernel_registers().size();
 
-    if (count_kernel_registers > 0U) {
+    /// Read the register values.
+    const auto* perf_kernel_registers = entry.read<std::uint64_t>(count_kernel_registers);
+    if (count_kernel_registers > 0U && perf_kernel_registers != nullptr) {
       auto kernel_registers = std::vector<std::uint64_t>{};
       kernel_registers.reserve(count_kernel_registers);
 
-      /// Read the register values.
-      const auto* perf_kernel_registers = entry.read<std::uint64_t>(count_kernel_registers);
       for (auto register_id = 0U; register_id < count_kernel_registers; ++register_id) {
         kernel_registers.push_back(perf_kernel_registers[register_id]);
       }
@@ -746,7 +1005,8 @@ perf::Sampler::read_cgroup_event(perf::Sampler::UserLevelBufferEntry entry) cons
   const auto cgroup_id = entry.read<std::uint64_t>();
   auto* path = entry.as<const char*>();
 
-  sample.cgroup(CGroup{ cgroup_id, std::string{ path } });
+  /// The path is null-terminated within the record (unless the record is malformed).
+  sample.cgroup(CGroup{ cgroup_id, std::string{ path, ::strnlen(path, entry.size()) } });
 
   return sample;
 }
@@ -798,6 +1058,48 @@ perf::MultiSamplerBase::result(const std::vector<Sampler>& sampler, bool sort_by
   return std::vector<perf::Sample>{};
 }
 
+perf::SampleBatch
+perf::MultiSamplerBase::result_columnar(bool sort_by_time) const
+{
+  auto batch = SampleBatch{};
+
+  /// Enable the columns of all samplers first, such that all columns hold a value for every sample.
+  for (const auto& sampler : this->samplers()) {
+    batch.enable(sampler._sample_layout);
+  }
+
+  for (const auto& sampler : this->samplers()) {
+    /// Only sort if all samplers recorded the timestamp.
+    sort_by_time &= sampler._values.is_set(PERF_SAMPLE_TIME);
+
+    sampler.read_columnar(batch);
+  }
+
+  if (sort_by_time) {
+    batch.sort_by_time();
+  }
+
+  return batch;
+}
+
+std::vector<perf::Sample>
+perf::MultiSamplerBase::drain(bool sort_by_time)
+{
+  auto result = std::vector<Sample>{};
+  std::ignore = this->for_each_sample([&result](Sample&& sample) { result.push_back(std::move(sample)); });
+
+  /// Only sort if all samplers recorded the timestamp.
+  for (const auto& sampler : this->samplers()) {
+    sort_by_time &= sampler._values.is_set(PERF_SAMPLE_TIME);
+  }
+
+  if (sort_by_time) {
+    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+  }
+
+  return result;
+}
+
 void
 perf::MultiSamplerBase::trigger(std::vector<Sampler>& samplers, std::vector<std::vector<std::string>>&& trigger_names)
 {
@@ -823,12 +1125,14 @@ perf::MultiSamplerBase::trigger(std::vector<Sampler>& samplers, std::vector<std:
 }
 
 void
-perf::MultiSamplerBase::open(perf::Sampler& sampler, const perf::SampleConfig config)
+perf::MultiSamplerBase::open(perf::Sampler& sampler,
+                             const perf::SampleConfig config,
+                             const perf::Sampler* resolved_sampler)
 {
   sampler._values = _values;
   sampler._config = config;
 
-  sampler.open();
+  sampler.open(resolved_sampler);
 }
 
 void
@@ -1016,19 +1320,42 @@ perf::MultiCoreSampler::MultiCoreSampler(const perf::CounterDefinition& counter_
   }
 }
 
+perf::MultiCoreSampler::MultiCoreSampler(const perf::CounterDefinition& counter_list,
+                                         const perf::CgroupHandle& cgroup,
+                                         std::vector<std::uint16_t>&& core_ids,
+                                         perf::SampleConfig config)
+  : MultiCoreSampler(counter_list, std::move(core_ids), config)
+{
+  /// Record all processes of the cgroup on the CPUs.
+  _config.cgroup_file_descriptor(cgroup.file_descriptor());
+}
+
 void
 perf::MultiCoreSampler::open()
 {
-  for (auto sampler_id = 0U; sampler_id < this->_core_ids.size(); ++sampler_id) {
+  /// The first core resolves the event attributes (e.g., the supported precise_ip), the remaining cores are opened
+  /// in parallel and reuse them.
+  const auto open = [this](const std::size_t sampler_id) {
     auto config = this->_config;
     config.cpu_id(this->_core_ids[sampler_id]);
-    MultiSamplerBase::open(this->_core_local_samplers[sampler_id], config);
-  }
+    MultiSamplerBase::open(
+      this->_core_local_samplers[sampler_id], config, sampler_id > 0U ? &this->_core_local_samplers.front() : nullptr);
+  };
+
+  this->_open_timing =
+    ParallelOpen::open(this->_core_ids.size(), this->_config.max_open_threads(), [&open]() { open(0U); }, open);
 }
 
 bool
 perf::MultiCoreSampler::start()
 {
+  /// Open all samplers (in parallel) before starting them.
+  if (std::any_of(this->_core_local_samplers.begin(), this->_core_local_samplers.end(), [](const auto& sampler) {
+        return !MultiSamplerBase::is_opened(sampler);
+      })) {
+    this->open();
+  }
+
   for (auto sampler_id = 0U; sampler_id < this->_core_ids.size(); ++sampler_id) {
     auto config = this->_config;
     config.cpu_id(this->_core_ids[sampler_id]);
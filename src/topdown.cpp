@@ -0,0 +1,120 @@
+#include <perfcpp/topdown.h>
+
+namespace {
+/**
+ * Builds an expression dividing the given numerator by the given total, resulting in zero if the total is zero.
+ *
+ * @param numerator Expression of the numerator.
+ * @param total Expression of the total.
+ * @return Expression of the ratio.
+ */
+std::string
+ratio(const std::string& numerator, const std::string& total)
+{
+  return std::string{ "if_zero(" }
+    .append(total)
+    .append(", 0, (")
+    .append(numerator)
+    .append(") / ")
+    .append(total)
+    .append(")");
+}
+}
+
+std::vector<std::pair<std::string, perf::CounterConfig>>
+perf::Topdown::intel_counters(const bool is_level2)
+{
+  /// The topdown metric events report the fraction of slots (scaled by the kernel to slots) of their category.
+  auto counters = std::vector<std::pair<std::string, CounterConfig>>{
+    { "topdown-slots", CounterConfig{ PERF_TYPE_RAW, 0x0400 } },
+    { "topdown-retiring", CounterConfig{ PERF_TYPE_RAW, 0x8000 } },
+    { "topdown-bad-spec", CounterConfig{ PERF_TYPE_RAW, 0x8100 } },
+    { "topdown-fe-bound", CounterConfig{ PERF_TYPE_RAW, 0x8200 } },
+    { "topdown-be-bound", CounterConfig{ PERF_TYPE_RAW, 0x8300 } },
+  };
+
+  if (is_level2) {
+    counters.emplace_back("topdown-heavy-ops", CounterConfig{ PERF_TYPE_RAW, 0x8400 });
+    counters.emplace_back("topdown-br-mispredict", CounterConfig{ PERF_TYPE_RAW, 0x8500 });
+    counters.emplace_back("topdown-fetch-lat", CounterConfig{ PERF_TYPE_RAW, 0x8600 });
+    counters.emplace_back("topdown-mem-bound", CounterConfig{ PERF_TYPE_RAW, 0x8700 });
+  }
+
+  return counters;
+}
+
+std::vector<std::pair<std::string, std::string>>
+perf::Topdown::intel_metrics(const bool is_level2)
+{
+  /// Like perf, the sum of the level-1 categories is used as total (instead of the slots) to get exactly 100%.
+  const auto total = std::string{ "(topdown-retiring + topdown-bad-spec + topdown-fe-bound + topdown-be-bound)" };
+
+  auto metrics = std::vector<std::pair<std::string, std::string>>{
+    { "tma_retiring", ratio("topdown-retiring", total) },
+    { "tma_bad_speculation", ratio("topdown-bad-spec", total) },
+    { "tma_frontend_bound", ratio("topdown-fe-bound", total) },
+    { "tma_backend_bound", ratio("topdown-be-bound", total) },
+  };
+
+  if (is_level2) {
+    metrics.emplace_back("tma_heavy_operations", ratio("topdown-heavy-ops", total));
+    metrics.emplace_back("tma_light_operations", ratio("max(topdown-retiring - topdown-heavy-ops, 0)", total));
+    metrics.emplace_back("tma_branch_mispredicts", ratio("topdown-br-mispredict", total));
+    metrics.emplace_back("tma_machine_clears", ratio("max(topdown-bad-spec - topdown-br-mispredict, 0)", total));
+    metrics.emplace_back("tma_fetch_latency", ratio("topdown-fetch-lat", total));
+    metrics.emplace_back("tma_fetch_bandwidth", ratio("max(topdown-fe-bound - topdown-fetch-lat, 0)", total));
+    metrics.emplace_back("tma_memory_bound", ratio("topdown-mem-bound", total));
+    metrics.emplace_back("tma_core_bound", ratio("max(topdown-be-bound - topdown-mem-bound, 0)", total));
+  }
+
+  return metrics;
+}
+
+std::vector<std::pair<std::string, perf::CounterConfig>>
+perf::Topdown::amd_counters(const std::uint8_t dispatch_slots)
+{
+  /// Raw AMD encoding: event select [7:0] and [35:32], unit mask [15:8], counter mask [31:24].
+  /// With the counter mask set to the number of slots, the event counts cycles where no slot received an op.
+  const auto all_slots_mask = std::uint64_t(dispatch_slots) << 24U;
+
+  return {
+    { "ls_not_halted_cyc", CounterConfig{ PERF_TYPE_RAW, 0x76 } },
+    { "ex_ret_ops", CounterConfig{ PERF_TYPE_RAW, 0xC1 } },
+    { "de_src_op_disp.all", CounterConfig{ PERF_TYPE_RAW, 0x07AA } },
+    { "de_no_dispatch_per_slot.no_ops_from_frontend", CounterConfig{ PERF_TYPE_RAW, 0x1000001A0 } },
+    { "de_no_dispatch_per_slot.no_ops_from_frontend.all_slots",
+      CounterConfig{ PERF_TYPE_RAW, 0x1000001A0 | all_slots_mask } },
+    { "de_no_dispatch_per_slot.backend_stalls", CounterConfig{ PERF_TYPE_RAW, 0x100001EA0 } },
+    { "de_no_dispatch_per_slot.smt_contention", CounterConfig{ PERF_TYPE_RAW, 0x1000060A0 } },
+    { "ex_no_retire.not_complete", CounterConfig{ PERF_TYPE_RAW, 0x02D6 } },
+    { "ex_no_retire.load_not_complete", CounterConfig{ PERF_TYPE_RAW, 0xA2D6 } },
+  };
+}
+
+std::vector<std::pair<std::string, std::string>>
+perf::Topdown::amd_metrics(const std::uint8_t dispatch_slots)
+{
+  const auto slots = std::string{ "(" }.append(std::to_string(dispatch_slots)).append(" * ls_not_halted_cyc)");
+  const auto backend_bound = ratio("de_no_dispatch_per_slot.backend_stalls", slots);
+  const auto frontend_bound = ratio("de_no_dispatch_per_slot.no_ops_from_frontend", slots);
+
+  /// Cycles where no slot was dispatched due to the frontend (counter mask = number of slots) are fetch latency.
+  const auto fetch_latency =
+    ratio(std::to_string(dispatch_slots).append(" * de_no_dispatch_per_slot.no_ops_from_frontend.all_slots"), slots);
+  const auto memory_bound = std::string{ "if_zero(ex_no_retire.not_complete, 0, " }
+                              .append(backend_bound)
+                              .append(" * ex_no_retire.load_not_complete / ex_no_retire.not_complete)");
+
+  return {
+    { "tma_retiring", ratio("ex_ret_ops", slots) },
+    { "tma_bad_speculation", ratio("max(de_src_op_disp.all - ex_ret_ops, 0)", slots) },
+    { "tma_frontend_bound", frontend_bound },
+    { "tma_backend_bound", backend_bound },
+    { "tma_smt_contention", ratio("de_no_dispatch_per_slot.smt_contention", slots) },
+    { "tma_fetch_latency", fetch_latency },
+    { "tma_fetch_bandwidth",
+      std::string{ "max(" }.append(frontend_bound).append(" - ").append(fetch_latency).append(", 0)") },
+    { "tma_memory_bound", memory_bound },
+    { "tma_core_bound", std::string{ "max(" }.append(backend_bound).append(" - ").append(memory_bound).append(", 0)") },
+  };
+}
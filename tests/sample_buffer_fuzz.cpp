@@ -0,0 +1,233 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <perfcpp/sampler.h>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Drains synthetic ring buffers through a sampler, without opening any counter.
+ */
+class SampleBufferFuzzer
+{
+public:
+  /// Size of the control page and of the data area (one page, such that records wrap around frequently).
+  constexpr static inline auto CONTROL_PAGE_SIZE = std::uint64_t{ 4096U };
+  constexpr static inline auto DATA_SIZE = std::uint64_t{ 4096U };
+
+  SampleBufferFuzzer()
+    : _buffer(CONTROL_PAGE_SIZE + DATA_SIZE)
+    , _sampler(_counter_definitions, SampleConfig{})
+  {
+    auto* mmap_page = this->mmap_page();
+    mmap_page->data_offset = CONTROL_PAGE_SIZE;
+    mmap_page->data_size = DATA_SIZE;
+
+    /// Sample the fields like an opened sampler would: Instruction pointer, time, callchain, and raw data.
+    this->_sampler.values().instruction_pointer(true).time(true).callchain(true).raw(true);
+    this->_sampler._sample_layout = SampleView::Layout{ this->_sampler._values.get(),
+                                                        this->_sampler._values.branch_mask(),
+                                                        this->_sampler._values.user_registers().size(),
+                                                        this->_sampler._values.kernel_registers().size() };
+    this->_sampler._sample_counter.emplace_back(Group{});
+    this->_sampler._sample_counter.back().buffer(this->_buffer.data(), -1);
+  }
+
+  ~SampleBufferFuzzer() = default;
+
+  [[nodiscard]] perf_event_mmap_page* mmap_page() noexcept
+  {
+    return reinterpret_cast<perf_event_mmap_page*>(this->_buffer.data());
+  }
+  [[nodiscard]] std::uint8_t* data() noexcept { return this->_buffer.data() + CONTROL_PAGE_SIZE; }
+  [[nodiscard]] Sampler& sampler() noexcept { return _sampler; }
+
+private:
+  CounterDefinition _counter_definitions;
+
+  /// Control page followed by the data area; sized exactly, such that the sanitizer catches reads outside.
+  std::vector<std::uint8_t> _buffer;
+
+  Sampler _sampler;
+};
+}
+
+namespace {
+std::size_t count_failures = 0U;
+
+/**
+ * Reports a failed check.
+ *
+ * @param round Round of the fuzzer.
+ * @param message Description of the failed check.
+ */
+void
+fail(const std::uint64_t round, const std::string& message)
+{
+  if (count_failures++ < 10U) {
+    std::cerr << "FAILED (round " << round << "): " << message << std::endl;
+  }
+}
+
+/**
+ * Expected content of a sample record written into the buffer.
+ */
+struct ExpectedSample
+{
+  std::uint64_t instruction_pointer;
+  std::uint64_t callchain_size;
+};
+}
+
+/**
+ * Writes random sample records into a ring buffer (including records that wrap around the end of the data area),
+ * corrupts some rounds (random bytes, record sizes, and heads), and drains them via for_each_sample() and
+ * for_each_sample_view(). Intact records must be returned unchanged; corrupted buffers must neither be read out of
+ * bounds (checked by the sanitizers) nor block the buffer (the tail must reach the head).
+ *
+ * Usage: sample-buffer-fuzz [rounds] [seed]
+ */
+int
+main(int argc, char** argv)
+{
+  const auto count_rounds = argc > 1 ? std::stoull(argv[1]) : 10000ULL;
+  auto random = std::mt19937_64{ argc > 2 ? std::stoull(argv[2]) : 42ULL };
+
+  auto fuzzer = perf::SampleBufferFuzzer{};
+  auto* mmap_page = fuzzer.mmap_page();
+  auto* data = fuzzer.data();
+  constexpr auto data_size = perf::SampleBufferFuzzer::DATA_SIZE;
+
+  auto count_checked_samples = std::uint64_t{ 0U };
+  auto count_wrapped_records = std::uint64_t{ 0U };
+
+  for (auto round = std::uint64_t{ 0U }; round < count_rounds; ++round) {
+    /// Rounds 0 and 1 (of 4) are intact, round 2 contains random bytes, round 3 has a corrupted size or head.
+    const auto kind = round % 4U;
+    const auto is_intact = kind < 2U;
+
+    const auto tail = (random() % 100000U) * sizeof(std::uint64_t);
+    auto head = tail;
+    mmap_page->data_tail = tail;
+
+    /// Write records (header, instruction pointer, time, callchain, raw data) until the data area is full.
+    auto expected_samples = std::vector<ExpectedSample>{};
+    auto record_offsets = std::vector<std::uint64_t>{};
+    while (true) {
+      const auto callchain_size = std::uint64_t{ random() % 40U };
+      const auto raw_size = std::uint32_t((random() % 5U) * sizeof(std::uint64_t) + sizeof(std::uint32_t));
+      const auto size = sizeof(perf_event_header) + (3U + callchain_size) * sizeof(std::uint64_t) +
+                        sizeof(std::uint32_t) + raw_size;
+      if (head + size - tail > data_size) {
+        break;
+      }
+
+      auto record = std::vector<std::uint8_t>(size);
+      const auto header = perf_event_header{ PERF_RECORD_SAMPLE, PERF_RECORD_MISC_USER, std::uint16_t(size) };
+      const auto instruction_pointer = std::uint64_t{ random() };
+      std::memcpy(record.data(), &header, sizeof(perf_event_header));
+      std::memcpy(record.data() + 8U, &instruction_pointer, sizeof(std::uint64_t));
+      std::memcpy(record.data() + 16U, &head, sizeof(std::uint64_t));
+      std::memcpy(record.data() + 24U, &callchain_size, sizeof(std::uint64_t));
+      for (auto index = std::uint64_t{ 0U }; index < callchain_size; ++index) {
+        const auto frame = instruction_pointer + index;
+        std::memcpy(record.data() + 32U + index * sizeof(std::uint64_t), &frame, sizeof(std::uint64_t));
+      }
+      std::memcpy(record.data() + 32U + callchain_size * sizeof(std::uint64_t), &raw_size, sizeof(std::uint32_t));
+
+      for (auto index = std::uint64_t{ 0U }; index < size; ++index) {
+        data[(head + index) % data_size] = record[index];
+      }
+      count_wrapped_records += (head % data_size) + size > data_size;
+
+      expected_samples.emplace_back(ExpectedSample{ instruction_pointer, callchain_size });
+      record_offsets.emplace_back(head);
+      head += size;
+    }
+
+    if (kind == 2U) {
+      for (auto i = 0U; i < 16U; ++i) {
+        data[random() % data_size] = std::uint8_t(random());
+      }
+    } else if (kind == 3U) {
+      switch (random() % 4U) {
+        case 0U: /// Size of a record that is too small, misaligned, or exceeds the head.
+          if (!record_offsets.empty()) {
+            const auto offset = record_offsets[random() % record_offsets.size()] % data_size;
+            const auto size = std::uint16_t(random() % 3U == 0U ? 0U : random());
+            std::memcpy(data + offset + offsetof(perf_event_header, size), &size, sizeof(std::uint16_t));
+          }
+          break;
+        case 1U: /// Misaligned head.
+          head += 1U + random() % 7U;
+          break;
+        case 2U: /// Head more than the data area ahead of the tail.
+          head = tail + data_size + sizeof(std::uint64_t) * (1U + random() % 64U);
+          break;
+        default: /// Head behind the tail.
+          head = tail - sizeof(std::uint64_t) * (1U + random() % 64U);
+          break;
+      }
+    }
+    mmap_page->data_head = head;
+
+    /// Drain the buffer, alternating the interfaces.
+    auto count_samples = std::uint64_t{ 0U };
+    const auto check = [&](const std::uint64_t instruction_pointer, const std::uint64_t callchain_size,
+                           const std::uint64_t last_frame) {
+      if (is_intact) {
+        if (count_samples >= expected_samples.size()) {
+          fail(round, "More samples than written.");
+        } else {
+          const auto& expected = expected_samples[count_samples];
+          if (instruction_pointer != expected.instruction_pointer || callchain_size != expected.callchain_size ||
+              (callchain_size > 0U && last_frame != expected.instruction_pointer + callchain_size - 1U)) {
+            fail(round, "Sample " + std::to_string(count_samples) + " differs from the written record.");
+          }
+        }
+        ++count_checked_samples;
+      }
+      ++count_samples;
+    };
+
+    if (round % 2U == 0U) {
+      fuzzer.sampler().for_each_sample([&](perf::Sample&& sample) {
+        const auto& callchain = sample.callchain();
+        const auto callchain_size = callchain.has_value() ? callchain->size() : 0U;
+        check(sample.instruction_pointer().value_or(0U), callchain_size,
+              callchain_size > 0U ? callchain->back() : 0U);
+      });
+    } else {
+      fuzzer.sampler().for_each_sample_view([&](const perf::SampleView& sample) {
+        const auto callchain = sample.callchain();
+        check(sample.instruction_pointer().value_or(0U), callchain.size(),
+              callchain.size() > 0U ? callchain[callchain.size() - 1U] : 0U);
+      });
+    }
+
+    if (is_intact && count_samples != expected_samples.size()) {
+      fail(round, "Read " + std::to_string(count_samples) + " of " + std::to_string(expected_samples.size()) +
+                    " samples.");
+    }
+
+    /// The consumed (or skipped) records are handed back, such that the buffer never blocks.
+    if (mmap_page->data_tail != head) {
+      fail(round, "Tail did not reach the head.");
+    }
+  }
+
+  if (count_failures > 0U) {
+    std::cerr << count_failures << " checks failed." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Checked " << count_checked_samples << " samples (" << count_wrapped_records
+            << " records wrapped around) in " << count_rounds << " rounds." << std::endl;
+  return EXIT_SUCCESS;
+}
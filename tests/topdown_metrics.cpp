@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <perfcpp/metric_expression.h>
+#include <perfcpp/topdown.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+std::size_t count_failures = 0U;
+
+/**
+ * Evaluates the metric with the given name on the given result and compares it to the expected value.
+ *
+ * @param metrics List of metric names and expressions.
+ * @param name Name of the metric.
+ * @param result Synthetic counter result.
+ * @param expected Expected value of the metric.
+ */
+void
+expect(const std::vector<std::pair<std::string, std::string>>& metrics,
+       const std::string& name,
+       const perf::CounterResult& result,
+       const double expected)
+{
+  for (const auto& [metric_name, expression] : metrics) {
+    if (metric_name == name) {
+      const auto value = perf::MetricExpression{ std::string{ metric_name }, expression }.calculate(result);
+      if (!value.has_value() || std::abs(value.value() - expected) > 1e-9) {
+        std::cerr << "FAILED: " << name << " = " << (value.has_value() ? std::to_string(value.value()) : "n/a")
+                  << ", expected " << expected << std::endl;
+        ++count_failures;
+      }
+      return;
+    }
+  }
+
+  std::cerr << "FAILED: metric " << name << " is not defined." << std::endl;
+  ++count_failures;
+}
+}
+
+/**
+ * Checks the top-down metrics of perf::Topdown on synthetic counter results, without the hardware.
+ */
+int
+main()
+{
+  /// Intel: The kernel reports the topdown metric events in slots; the level-1 categories sum up to all slots.
+  const auto intel_level1 = perf::Topdown::intel_metrics(false);
+  const auto intel_result = perf::CounterResult{ { { "topdown-slots", 1000.0 },
+                                                   { "topdown-retiring", 400.0 },
+                                                   { "topdown-bad-spec", 100.0 },
+                                                   { "topdown-fe-bound", 200.0 },
+                                                   { "topdown-be-bound", 300.0 },
+                                                   { "topdown-heavy-ops", 150.0 },
+                                                   { "topdown-br-mispredict", 60.0 },
+                                                   { "topdown-fetch-lat", 120.0 },
+                                                   { "topdown-mem-bound", 180.0 } } };
+  expect(intel_level1, "tma_retiring", intel_result, 0.4);
+  expect(intel_level1, "tma_bad_speculation", intel_result, 0.1);
+  expect(intel_level1, "tma_frontend_bound", intel_result, 0.2);
+  expect(intel_level1, "tma_backend_bound", intel_result, 0.3);
+
+  const auto intel_level2 = perf::Topdown::intel_metrics(true);
+  expect(intel_level2, "tma_heavy_operations", intel_result, 0.15);
+  expect(intel_level2, "tma_light_operations", intel_result, 0.25);
+  expect(intel_level2, "tma_branch_mispredicts", intel_result, 0.06);
+  expect(intel_level2, "tma_machine_clears", intel_result, 0.04);
+  expect(intel_level2, "tma_fetch_latency", intel_result, 0.12);
+  expect(intel_level2, "tma_fetch_bandwidth", intel_result, 0.08);
+  expect(intel_level2, "tma_memory_bound", intel_result, 0.18);
+  expect(intel_level2, "tma_core_bound", intel_result, 0.12);
+
+  /// Intel: Metrics without any slots (e.g., the group was never scheduled) are zero instead of NaN.
+  const auto intel_empty_result = perf::CounterResult{ { { "topdown-retiring", 0.0 },
+                                                         { "topdown-bad-spec", 0.0 },
+                                                         { "topdown-fe-bound", 0.0 },
+                                                         { "topdown-be-bound", 0.0 } } };
+  expect(intel_level1, "tma_retiring", intel_empty_result, 0.0);
+  expect(intel_level1, "tma_backend_bound", intel_empty_result, 0.0);
+
+  /// AMD (Zen 4): Six dispatch slots per cycle, i.e., 6,000 slots in 1,000 cycles.
+  const auto amd = perf::Topdown::amd_metrics(6U);
+  const auto amd_result =
+    perf::CounterResult{ { { "ls_not_halted_cyc", 1000.0 },
+                           { "ex_ret_ops", 2400.0 },
+                           { "de_src_op_disp.all", 3000.0 },
+                           { "de_no_dispatch_per_slot.no_ops_from_frontend", 1200.0 },
+                           { "de_no_dispatch_per_slot.no_ops_from_frontend.all_slots", 100.0 },
+                           { "de_no_dispatch_per_slot.backend_stalls", 1800.0 },
+                           { "de_no_dispatch_per_slot.smt_contention", 600.0 },
+                           { "ex_no_retire.not_complete", 1000.0 },
+                           { "ex_no_retire.load_not_complete", 500.0 } } };
+  expect(amd, "tma_retiring", amd_result, 0.4);
+  expect(amd, "tma_bad_speculation", amd_result, 0.1);
+  expect(amd, "tma_frontend_bound", amd_result, 0.2);
+  expect(amd, "tma_backend_bound", amd_result, 0.3);
+  expect(amd, "tma_smt_contention", amd_result, 0.1);
+  expect(amd, "tma_fetch_latency", amd_result, 0.1);
+  expect(amd, "tma_fetch_bandwidth", amd_result, 0.1);
+  expect(amd, "tma_memory_bound", amd_result, 0.15);
+  expect(amd, "tma_core_bound", amd_result, 0.15);
+
+  /// AMD (Zen 5): Eight dispatch slots per cycle.
+  const auto amd_zen5 = perf::Topdown::amd_metrics(8U);
+  expect(amd_zen5, "tma_retiring", amd_result, 0.3);
+
+  if (count_failures > 0U) {
+    std::cerr << count_failures << " checks failed." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "All top-down metric checks passed." << std::endl;
+  return EXIT_SUCCESS;
+}